@@ -7,19 +7,17 @@ float Application::radius = 50.0f;
 float Application::width = 100.0f;
 float Application::height = 50.0f;
 float Application::radius_ = 0.0f;
-float Application::restiutionValue = 0.65f; 
-float Application::gravity = 9.81f; 
 float Application::toastTimer = 0.0f; 
 float Application::deltaTime = 0.f; 
 bool Application::pause = false; 
 bool Application::showNormal = false;
 bool Application::attachPendulum = false; 
 bool Application::showCollisionPoint = false;
-int Application::maxIteration = 3; 
+bool Application::showAABB = false;
+bool Application::showBroadphase = false;
 float Application::correctionValue = 0.85f; 
-float Application::frictionValue = 0.5f; 
 
-std::vector<Body*> Application::bodies;
+World Application::world;
 Body* Application::greatBall = nullptr;
 Body* Application::polygon = nullptr;
 Body* Application::otherPolygon = nullptr;
@@ -31,11 +29,86 @@ bool Application::isRecentBodySelected = false;
 bool Application::showSavedToast = false;
 bool Application::showLoadFailToast = false;
 bool Application::showOverwriteModal = false;
+bool Application::binaryState = false;
 Body* Application::draggedBody = nullptr;
 Body* Application::recentSelectedBody = nullptr;
 Vec2 Application::dragOffset; 
 ContactInformation Application::contact;
-WreckingBall Application::wb; 
+Vec2 Application::pendulumOrigin = {700.f, 50.f};
+
+// Deterministic mode
+bool Application::deterministic = false;
+float Application::stepAccumulator = 0.f;
+uint64_t Application::stateHash = 0;
+
+StateWriter Application::stateWriter;
+StateLoader Application::stateLoader;
+
+// Rewind history
+RewindBuffer Application::rewind;
+SceneSnapshot Application::rewindScratch;
+const RewindBuffer::Frame* Application::rewindHead = nullptr;
+size_t Application::rewindHeadCommands = 0;
+bool Application::rewindEnabled = false;
+int Application::rewindBudgetMB = 64;
+int Application::rewindInterval = 10;
+
+// Replay recording
+ReplayRecorder Application::recorder;
+uint32_t Application::stepCount = 0;
+
+namespace {
+    // Steps between keyframes in a replay log; replay verifies against each one
+    constexpr uint32_t KEYFRAME_INTERVAL = 300;
+    // Largest position error (px) a replay may show against a recorded keyframe
+    constexpr float REPLAY_TOLERANCE = 1e-3f;
+    // Fixed steps a single frame may catch up on before time is dropped
+    constexpr int MAX_FIXED_STEPS = 4;
+    // Arc segments per rounded end of a capsule outline
+    constexpr int CAPSULE_ARC_SEGMENTS = 12;
+    // Mass a static bob takes on while it hangs from the pendulum
+    constexpr float PENDULUM_BOB_MASS = 20.f;
+
+    // Outline of a capsule as one closed polygon: a half circle around each
+    // end of the core segment, inset by offset pixels
+    std::vector<Vec2> CapsuleOutline(const CapsuleShape& capsule, float rotation, float offset) {
+        std::vector<Vec2> points;
+        points.reserve(2 * (CAPSULE_ARC_SEGMENTS + 1));
+        const float radius = std::max(0.f, capsule.radius - offset);
+        const float pi = 3.14159265f;
+        for (int end = 0; end < 2; end++) {
+            const Vec2& center = end == 0 ? capsule.worldB : capsule.worldA;
+            const float start = rotation - pi * 0.5f + end * pi;
+            for (int i = 0; i <= CAPSULE_ARC_SEGMENTS; i++) {
+                const float angle = start + pi * i / CAPSULE_ARC_SEGMENTS;
+                points.push_back(Vec2(center.x + cosf(angle) * radius, center.y + sinf(angle) * radius));
+            }
+        }
+        return points;
+    }
+
+    // One convex child of a compound, outline only
+    void DrawPart(const Body& part, glm::vec3 color, RenderLayer layer) {
+        switch (part.shape->GetType()) {
+            case CIRCLE:
+                Renderer::DrawCircle(part.position, static_cast<CircleShape*>(part.shape)->radius, color, layer);
+                break;
+            case CAPSULE: {
+                std::vector<Vec2> outline = CapsuleOutline(*static_cast<CapsuleShape*>(part.shape), part.rotation, 0.f);
+                Renderer::DrawPolygon(outline, outline.size(), color, layer);
+                break;
+            }
+            case POLYGON:
+            case BOX: {
+                const std::vector<Vec2>& vertices = static_cast<PolygonShape*>(part.shape)->worldVertices;
+                Renderer::DrawPolygon(vertices, vertices.size(), color, layer);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
 
 //State Save / Load 
 std::string Application::currentSceneName = "untitled";
@@ -67,13 +140,15 @@ void Application::Init(GLFWwindow* window) {
 
 void Application::SetUp() {
     greatBall = new Body(CircleShape(100), 400, 300, 0.f, 0.f);
-    bodies.push_back(greatBall);
+    world.AddBody(greatBall);
     radius_ = greatBall->GetRadius();
 
-    Body* floor1 = new Body(BoxShape(800.f , 20.f), 700.f, 450.f, 0.f, glm::radians(15.f)); 
-    bodies.push_back(floor1); 
-    Body* floor2 = new Body(BoxShape(800.f , 20.f), 1200.f, 750.f, 0.f, glm::radians(-15.f)); 
-    bodies.push_back(floor2); 
+    // Floors are static chains along the top of the old 800x20 slabs
+    const std::vector<Vec2> floorSurface = { Vec2(-400.f, -10.f), Vec2(400.f, -10.f) };
+    Body* floor1 = new Body(ChainShape(floorSurface), 700.f, 450.f, 0.f, glm::radians(15.f));
+    world.AddBody(floor1); 
+    Body* floor2 = new Body(ChainShape(floorSurface), 1200.f, 750.f, 0.f, glm::radians(-15.f));
+    world.AddBody(floor2); 
 }
 
 Body* Application::getGreatBall(){
@@ -81,15 +156,16 @@ Body* Application::getGreatBall(){
 }
 
 void Application::Update(GLFWwindow* window) {
-    glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    // Start recording this frame's draw commands
+    Renderer::BeginFrame();
 
       // Static to keep value between frames
     static double timePreviousFrame = glfwGetTime();
 
     // Calculate deltaTime in seconds
     double currentTime = glfwGetTime();
-    deltaTime = static_cast<float>(currentTime - timePreviousFrame);
+    float elapsed = static_cast<float>(currentTime - timePreviousFrame);
+    deltaTime = elapsed;
 
     // Clamp deltaTime to avoid large jumps
     if (deltaTime > 0.016f)
@@ -98,31 +174,51 @@ void Application::Update(GLFWwindow* window) {
     // Set current time for next frame
     timePreviousFrame = currentTime;
 
-    int scale = Constants::PIXELS_PER_METER; 
-
-    // pause/Resume 
+    // Report saves the writer thread has finished
+    StateWriter::Result saved;
+    while (stateWriter.Poll(saved)) {
+        if (saved.ok) {
+            std::cout << "[State] Saved " << saved.bodyCount << " bodies to: " << saved.path
+                      << " (" << saved.milliseconds << " ms)\n";
+            showSavedToast = true;
+            toastTimer = 2.5f;
+        } else {
+            std::cerr << "[State] Could not write: " << saved.path << "\n";
+        }
+    }
 
-    if(!pause){
-    // Apply forces to bodies
-    for (auto body : bodies) {
-        Vec2 weight = Vec2(0.0, body->mass * body->gravity * scale);
-        body->AddForce(weight);
+    // Swap in a finished load between frames
+    StateLoader::Result loaded;
+    if (stateLoader.Poll(loaded))
+        FinishLoad(loaded);
 
-        // Optional:
-        // Vec2 wind = Vec2(2.0 * PIXELS_PER_METER, 0.0);
-        // body->AddForce(wind);
-        // body->AddTorque(20.0f);
+    // Close the previous frame's commands and drop a keyframe now and then
+    if (recorder.IsRecording()) {
+        recorder.EndFrame();
+        if (recorder.FramesSinceKeyframe() >= KEYFRAME_INTERVAL)
+            WriteKeyframe(0);
     }
 
-    // Integrate forces to update velocity/position
-     for (auto body : bodies) {
-        body->Update(deltaTime);
-        body->restitution = restiutionValue;
-        body->gravity = gravity;  
-        body->friction = frictionValue; 
+    // Rewind settings from the panel; the history starts with a snapshot of now
+    rewind.budgetBytes = static_cast<size_t>(rewindBudgetMB) * 1024 * 1024;
+    rewind.interval    = static_cast<uint32_t>(std::max(1, rewindInterval));
+    if (rewindEnabled && rewind.Empty())
+        CaptureRewind();
+    else if (!rewindEnabled && !rewind.Empty()) {
+        rewind.Clear();
+        rewindHead = nullptr;
     }
 
-    // Update dragged body position to follow cursor
+    // pause/Resume 
+
+    if(!pause){
+    world.debugDraw.flags = (showCollisionPoint ? DEBUG_CONTACTS   : DEBUG_NONE) |
+                            (showNormal         ? DEBUG_NORMALS    : DEBUG_NONE) |
+                            (showAABB           ? DEBUG_AABBS      : DEBUG_NONE) |
+                            (showBroadphase     ? DEBUG_BROADPHASE : DEBUG_NONE);
+
+    // Dragged body is pulled to the cursor; the target is part of the recorded step
+    Vec2 targetPos;
     if (draggedBody) {
         double mouseX, mouseY;
         glfwGetCursorPos(window, &mouseX, &mouseY);
@@ -133,74 +229,73 @@ void Application::Update(GLFWwindow* window) {
         mouseX = mouseX * fbW / winW;
         mouseY = mouseY * fbH / winH;
 
-        Vec2 targetPos = {
-            (float)(mouseX - dragOffset.x),
-            (float)(mouseY - dragOffset.y)
-        };
-
-        // Derive velocity from mouse movement so collision impulses transfer correctly
-        if (deltaTime > 0.0f) {
-            draggedBody->velocity.x = (targetPos.x - draggedBody->position.x) / deltaTime;
-            draggedBody->velocity.y = (targetPos.y - draggedBody->position.y) / deltaTime;
-        }
-        draggedBody->position = targetPos;
+        targetPos = { (float)mouseX, (float)mouseY };
     }
-        // Detect collisions
-    // Update vertices before collision checks
-    for (Body* body : bodies) {
-        if (body && body->shape) {
-            body->shape->UpdateVertices(body->rotation, body->position);
+
+    bool dragging = draggedBody != nullptr;
+    if (deterministic) {
+        // Fixed dt: run as many whole steps as real time covers, independent of frame rate
+        stepAccumulator = std::min(stepAccumulator + elapsed, MAX_FIXED_STEPS * World::FIXED_TIME_STEP);
+        while (stepAccumulator >= World::FIXED_TIME_STEP) {
+            Execute(InputCommand::Step(World::FIXED_TIME_STEP, dragging, targetPos));
+            stepAccumulator -= World::FIXED_TIME_STEP;
         }
+    } else {
+        Execute(InputCommand::Step(deltaTime, dragging, targetPos));
     }
+}
 
-// Collision loop
-for (int n = 0; n < maxIteration; n++){
-for (size_t i = 0; i < bodies.size() - 1; i++) {
-    for (size_t j = i + 1; j < bodies.size(); j++) {
-        Body* a = bodies[i];
-        Body* b = bodies[j];
-
-        ContactInformation contact; 
-        if (a && a->shape) { 
-            bool collisionHappened = CollisionDetection::isColliding(a, b, contact);
-            
-            if (collisionHappened) {
-                a->allowRotation = true; 
-                b->allowRotation = true; 
-                CollisionSolver::ResolveCollision(contact); 
-
-                if(showCollisionPoint){
-                Renderer::DrawCircle(contact.start, 3.f, {1.0f, 0.0f, 0.0f});
-                Renderer::DrawCircle(contact.end, 3.f, {0.0f, 1.0f, 0.0f});
-                }
-                
-                if(showNormal){
-                Vec2 direction = contact.end - contact.start;
-                if (direction.Magnitude() > 0.0f) {
-                    direction = direction.Normalize();
-                    Renderer::DrawLine(
-                        contact.start,
-                        contact.start + direction * 15.0f,
-                        {0.0f, 1.0f, 1.0f}
-                    );
-                }
-              }
-            }
-        } else {
-            std::cerr << "a or a->shape is null.\n";
-        }
+}
 
+void Application::StepSimulation(float dt, bool dragging, Vec2 dragTarget) {
+    // A dynamic body is pulled towards the cursor by the solver, so it
+    // stops at whatever it is dragged into; a static one is an obstacle
+    // being placed, and is put there
+    Body* pulled = dragging ? draggedBody : nullptr;
+    if (pulled && pulled->IsStatic()) {
+        pulled->position = dragTarget - dragOffset.Rotate(pulled->rotation);
+        pulled->shape->UpdateVertices(pulled->rotation, pulled->position);
+        pulled = nullptr;
     }
-  } 
+    SyncMouseJoint(pulled, dragTarget);
+
+    world.Step(dt);
+
+    stepCount++;
+    if (deterministic)
+        stateHash = world.StateHash();
 }
 
+void Application::SyncMouseJoint(Body* body, const Vec2& target) {
+    MouseJoint* mouse = DragJoint();
+    if (mouse && mouse->b != body) {
+        world.RemoveJoint(mouse);
+        mouse = nullptr;
+    }
+    if (!body) return;
+
+    // Grabbed where it was clicked, however it has turned since
+    if (!mouse) {
+        mouse = new MouseJoint(body, body->position + dragOffset.Rotate(body->rotation), DRAG_MAX_ACCELERATION * body->mass);
+        // Exactly the grab point, whatever the pose rounded it to, so a
+        // joint recreated from a keyframe pulls on the same spot
+        mouse->localAnchorB = dragOffset;
+        world.AddJoint(mouse);
+    }
+    mouse->SetTarget(target);
 }
 
+MouseJoint* Application::DragJoint()
+{
+    auto it = std::find_if(world.joints.begin(), world.joints.end(), [](const Joint* joint) {
+        return joint->GetType() == MOUSE_JOINT;
+    });
+    return it != world.joints.end() ? static_cast<MouseJoint*>(*it) : nullptr;
 }
 
-void Application::Render(GLFWwindow* window){
+void Application::DrawScene() {
 // Draw bodies with appropriate colors
-    for (auto body : bodies) {        
+    for (auto body : world.bodies) {        
         if (body->shape->GetType() == CIRCLE) {
             CircleShape* circle = static_cast<CircleShape*>(body->shape);
           Renderer::DrawCircle(body->position, circle->radius, glm::vec3(1.0f, 1.0f, 1.0f));
@@ -216,13 +311,10 @@ void Application::Render(GLFWwindow* window){
         // Making outline color highlighted to make sure it is selected 
         if(recentSelectedBody && !recentSelectedBody->IsStatic() &&isRecentBodySelected){
            static float offSet = 1.0f; 
-           Renderer::DrawCircle(recentSelectedBody->position, recentSelectedBody->GetRadius() - offSet, glm::vec4(1.0f, 1.0f, 0.0f, 0.5f));
+           Renderer::DrawCircle(recentSelectedBody->position, recentSelectedBody->GetRadius() - offSet, glm::vec4(1.0f, 1.0f, 0.0f, 0.5f), LAYER_HIGHLIGHT);
         }
         
     }
-        if (body->shape->GetType() == CIRCLE) {
-            body->isColliding = false;
-         }
         
         if (body->shape->GetType() == POLYGON) {  
         PolygonShape* polygonShape = static_cast<PolygonShape*>(body->shape);
@@ -230,42 +322,66 @@ void Application::Render(GLFWwindow* window){
         Renderer::DrawPolygon(polygonShape->worldVertices, polygonShape->worldVertices.size(), glm::vec3(1.0f, 1.0f, 0.0f));
       }   
 
-      if (body->shape->GetType() == POLYGON) {
-            body->isColliding = false;
-         }
-
       if(body->shape->GetType() == BOX){
         BoxShape* boxShape = static_cast<BoxShape*>(body->shape); 
         Renderer::DrawRectangle(body->position, boxShape->width, boxShape->height, glm::vec3 (0.5f, 1.0f, 0.5f), body->rotation); 
         //Renderer::DrawRect(body->position.x, body->position.y, boxShape->width, boxShape->height, color);  
 
         // Making outline color highlighted to make sure it is selected 
-        if(recentSelectedBody && isRecentBodySelected){
+        if(recentSelectedBody && isRecentBodySelected && recentSelectedBody->shape->GetType() == BOX){
         BoxShape* _boxShape = static_cast<BoxShape*>(recentSelectedBody->shape); 
            static float offSet = 1.0f; 
-           Renderer::DrawRectangle(recentSelectedBody->position, _boxShape->width - offSet, _boxShape->height - offSet, glm::vec4 (1.0f, 1.0f, 0.5f, 0.1f), recentSelectedBody->rotation); 
+           Renderer::DrawRectangle(recentSelectedBody->position, _boxShape->width - offSet, _boxShape->height - offSet, glm::vec4 (1.0f, 1.0f, 0.5f, 0.1f), recentSelectedBody->rotation, LAYER_HIGHLIGHT); 
         }
     }
 
-       if (body->shape->GetType() == BOX) {
-            body->isColliding = false;
-         }
-    }
+      if (body->shape->GetType() == CHAIN) {
+        // Only the segments on screen
+        const ChainShape* chain = static_cast<ChainShape*>(body->shape);
+        const AABB screen { Vec2(0.f, 0.f), Vec2((float)screenWidth, (float)screenHeight) };
+        chain->QuerySegments(screen, [&](int segment) {
+            Vec2 start, end;
+            chain->GetSegment(segment, start, end);
+            Renderer::DrawLine(start, end, glm::vec3(0.5f, 1.0f, 0.5f));
+        });
+      }
 
-    // position of the hinge of pendulum
-    static Vec2 origin = {700.f, 50.f};
-    
-    if(attachPendulum)
-    {
-    for (auto body : bodies) {
-        if (body->shape->GetType() == CIRCLE && body->IsStatic()) {
-            Renderer::DrawLine(origin, body->position, glm::vec4(1.0f, 1.0f, 0.5f, 1.0f));
-            auto bobPos = wb.SolvePendulum(body->gravity, origin, body->position, deltaTime, isRecentBodySelected);
-            body->position = bobPos; 
+      if (body->shape->GetType() == CAPSULE) {
+        CapsuleShape* capsule = static_cast<CapsuleShape*>(body->shape);
+        std::vector<Vec2> outline = CapsuleOutline(*capsule, body->rotation, 0.f);
+        Renderer::DrawPolygon(outline, outline.size(), glm::vec3(0.5f, 0.8f, 1.0f));
+
+        if (body == recentSelectedBody && isRecentBodySelected) {
+            std::vector<Vec2> highlight = CapsuleOutline(*capsule, body->rotation, 1.0f);
+            Renderer::DrawPolygon(highlight, highlight.size(), glm::vec3(1.0f, 1.0f, 0.5f), LAYER_HIGHLIGHT);
+        }
+      }
+
+      if (body->shape->GetType() == COMPOUND) {
+        const CompoundShape* compound = static_cast<CompoundShape*>(body->shape);
+        const bool selected = body == recentSelectedBody && isRecentBodySelected;
+        for (int i = 0; i < compound->PartCount(); i++) {
+            const Body* part = compound->PlacePart(i);
+            DrawPart(*part, glm::vec3(1.0f, 0.7f, 0.4f), LAYER_WORLD);
+            if (selected) DrawPart(*part, glm::vec3(1.0f, 1.0f, 0.5f), LAYER_HIGHLIGHT);
         }
-        break; 
+      }
     }
-  }
+
+    // Joints as lines between their anchors; the pendulum string among them
+    for (const Joint* joint : world.joints)
+        Renderer::DrawLine(joint->AnchorA(), joint->AnchorB(), glm::vec4(1.0f, 1.0f, 0.5f, 1.0f));
+
+    // Drain the debug primitives the physics step produced this frame
+    Renderer::DrawDebug(world.debugDraw);
+    world.debugDraw.Clear();
+}
+
+void Application::Render(GLFWwindow* window){
+    DrawScene();
+
+    // Sort and execute every draw command recorded this frame
+    Renderer::EndFrame();
 
     // Render ImGui
     ImGui_ImplOpenGL3_NewFrame();
@@ -273,16 +389,23 @@ void Application::Render(GLFWwindow* window){
     ImGui::NewFrame();
 
     SimContext ctx {
-        pause, showNormal, showCollisionPoint, attachPendulum,
-        isRecentBodySelected, showSavedToast, showLoadFailToast, showOverwriteModal,
-        gravity, restiutionValue, frictionValue, correctionValue, radius_, toastTimer,
-        maxIteration,
-        bodies, greatBall, recentSelectedBody,
+        pause, showNormal, showCollisionPoint, showAABB, showBroadphase, attachPendulum,
+        isRecentBodySelected, showSavedToast, showLoadFailToast, showOverwriteModal, binaryState,
+        stateLoader.Busy(), stateLoader.Progress(),
+        recorder.IsRecording(), recorder.BytesWritten(),
+        deterministic, world.threadCount, stateHash,
+        rewindEnabled, rewindBudgetMB, rewindInterval,
+        rewind.OldestStep(), rewind.NewestStep(), stepCount, rewind.BytesUsed(), rewind.FrameCount(),
+        world.gravity, world.restitution, world.friction, correctionValue, radius_, toastTimer,
+        world.maxIteration, world.continuousCollision, world.solver, world.substeps,
+        world.bodies, greatBall, recentSelectedBody,
         stateName, pendingFilepath, newSaveName,
         [](const std::string& fp){ SaveState(fp); },
         [](const std::string& fp){ LoadState(fp); },
-        []{ return ClearDynamicObjectOnScreen(); },
-        [](Body* b){ return DeleteParticularBody(b); }
+        [](){ stateLoader.Cancel(); },
+        [](const std::string& fp){ recorder.IsRecording() ? StopRecording() : StartRecording(fp); },
+        [](const InputCommand& command){ Execute(command); },
+        [](uint32_t step){ RewindTo(step); }
     };
     GUI::Render(window, ctx);
 
@@ -292,151 +415,466 @@ void Application::Render(GLFWwindow* window){
 
 void Application::SaveState(const std::string& filepath)
 {
-    
+    // Capture here, encode and write on the writer's thread
+    SceneSnapshot snapshot;
+    CaptureScene(snapshot);
+    stateWriter.Save(filepath, std::move(snapshot));
+}
 
-    nlohmann::json j; 
-    j["globalGravity"] = gravity; 
-    j["globalRestituion"] = restiutionValue; 
-    j["globalFriction"] = frictionValue; 
-    j["pause"] = pause; 
-    j["pendulumAttached"] = attachPendulum; 
-    
-    nlohmann::json bodyArray = nlohmann::json::array(); 
-
-    for (auto* body : bodies) {
-        nlohmann::json b; 
-        // --- Transform ---
-        b["x"] = body->position.x;
-        b["y"] = body->position.y;
-        b["rotation"] = body->rotation;
-
-        // --- Motion (this is what makes it a STATE save) ---
-        b["velocityX"] = body->velocity.x;
-        b["velocityY"] = body->velocity.y;
-        b["angularVelocity"] = body->angularVelocity;
-
-        // --- Physics properties ---
-        b["mass"] = body->mass;
-        b["restitution"] = body->restitution;
-        b["friction"] = body->friction;
-        b["gravity"] = body->gravity;
-
-        // --- Shape ---
-        ShapeType type = body->shape->GetType();
-        if (type == CIRCLE) {
-            CircleShape* c = static_cast<CircleShape*>(body->shape);
-            b["shape"] = "circle";
-            b["radius"] = c->radius;
-        }
-        else if (type == BOX) {
-            BoxShape* box = static_cast<BoxShape*>(body->shape);
-            b["shape"] = "box";
-            b["width"] = box->width;
-            b["height"] = box->height;
-        }
-        else if (type == POLYGON) {
-            PolygonShape* poly = static_cast<PolygonShape*>(body->shape);
-            b["shape"] = "polygon";
-            b["numSides"] = (int)poly->localVertices.size();
-        }
+void Application::LoadState(const std::string& filepath)
+{
+    // Parse on the loader's thread; Update swaps the bodies in once it is done
+    if (!stateLoader.Load(filepath, CurrentSettings()))
+        std::cerr << "[State] A load is already running, ignoring: " << filepath << "\n";
+}
 
-        bodyArray.push_back(b);
+void Application::FinishLoad(StateLoader::Result& loaded)
+{
+    if (loaded.cancelled) {
+        std::cout << "[State] Load cancelled: " << loaded.path << "\n";
+        return;
+    }
+    if (!loaded.ok) {
+        std::cerr << "[State] Could not read: " << loaded.path << "\n";
+        showSavedToast = false;
+        showLoadFailToast = true;
+        toastTimer = 2.5f;
+        return;
     }
 
-    j["bodies"] = bodyArray;
+    size_t count = loaded.bodies.size();
+    ReplaceScene(loaded.settings, loaded.bodies);
+    SceneReplaced();
 
-    // Create folder if needed
-    std::filesystem::create_directories("states");
-    std::ofstream file(filepath);
-    file << j.dump(4);
-    file.close();
+    double rate = loaded.milliseconds > 0.0 ? count / (loaded.milliseconds / 1000.0) : 0.0;
+    std::cout << "[State] Loaded " << count << " bodies from: " << loaded.path
+              << " (" << loaded.milliseconds << " ms, " << static_cast<long long>(rate) << " bodies/s)\n";
+}
+
+bool Application::RestoreSnapshot(const SnapshotView& view)
+{
+    // Build the new scene aside so corrupt records leave the current one intact
+    std::vector<Body*> loaded;
+    if (!SceneSnapshot::CreateBodies(view, loaded))
+        return false;
 
-    std::cout << "[State] Saved " << bodies.size() << " bodies to: " << filepath << "\n"; 
+    ReplaceScene(view.settings, loaded);
+    return true;
 }
 
-void Application::LoadState(const std::string& filepath)
+SnapshotSettings Application::CurrentSettings()
 {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-        std::cerr << "[State] Could not open: " << filepath << "\n";
-        return;
-    }
+    SnapshotSettings settings {};
+    settings.gravity      = world.gravity;
+    settings.restitution  = world.restitution;
+    settings.friction     = world.friction;
+    settings.maxIteration = world.maxIteration;
+    settings.flags        = (pause ? SETTINGS_PAUSED : 0u) |
+                            (attachPendulum ? SETTINGS_PENDULUM_ATTACHED : 0u);
+    return settings;
+}
 
+void Application::ReplaceScene(const SnapshotSettings& settings, std::vector<Body*>& bodies)
+{
     // --- Full reset ---
-    for (auto* body : bodies) delete body;
-    bodies.clear();
+    world.Clear();
     greatBall = nullptr;
+    draggedBody = nullptr;
+    isDragging = false;
     recentSelectedBody = nullptr;
     isRecentBodySelected = false;
 
-    nlohmann::json j;
-    file >> j;
-    file.close();
-
-    // --- Restore global simulation state ---
-    if (j.contains("globalGravity"))     gravity = j["globalGravity"];
-    if (j.contains("globalRestitution")) restiutionValue = j["globalRestitution"];
-    if (j.contains("globalFriction"))    frictionValue = j["globalFriction"];
-    if (j.contains("paused"))            pause = j["paused"];
-    if (j.contains("pendulumAttached"))  attachPendulum = j["pendulumAttached"];
-
-    // --- Rebuild every body with full motion state ---
-    for (auto& b : j["bodies"]) {
-        float x = b["x"];
-        float y = b["y"];
-        float mass = b["mass"];
-        float rotation = b["rotation"];
-        std::string shape = b["shape"];
-
-        Body* body = nullptr;
-
-        if (shape == "circle") {
-            body = new Body(CircleShape(b["radius"].get<float>()), x, y, mass, rotation);
+    world.gravity      = settings.gravity;
+    world.restitution  = settings.restitution;
+    world.friction     = settings.friction;
+    world.maxIteration = settings.maxIteration;
+    pause              = (settings.flags & SETTINGS_PAUSED) != 0;
+    attachPendulum     = (settings.flags & SETTINGS_PENDULUM_ATTACHED) != 0;
+
+    world.bodies.reserve(bodies.size());
+    for (Body* body : bodies)
+        world.AddBody(body);
+    bodies.clear();
+
+    // Joints are not part of a snapshot; the pendulum follows its setting
+    SyncPendulum();
+}
+
+DistanceJoint* Application::Pendulum()
+{
+    // Only the pendulum hangs from a fixed point in the world
+    auto it = std::find_if(world.joints.begin(), world.joints.end(), [](const Joint* joint) {
+        return !joint->a && joint->GetType() == DISTANCE_JOINT;
+    });
+    return it != world.joints.end() ? static_cast<DistanceJoint*>(*it) : nullptr;
+}
+
+void Application::SyncPendulum()
+{
+    DistanceJoint* pendulum = Pendulum();
+    if (!attachPendulum) {
+        if (!pendulum) return;
+        // Back to a fixed obstacle where it hangs
+        Body* bob = pendulum->b;
+        world.RemoveJoint(pendulum);
+        bob->SetMass(0.f);
+        bob->velocity = Vec2();
+        bob->angularVelocity = 0.f;
+        return;
+    }
+
+    // The bob is the first body, when it is a circle; a static one is given
+    // mass so the string can swing it and it can push on what it hits
+    if (pendulum || world.bodies.empty()) return;
+    Body* bob = world.bodies.front();
+    if (bob->shape->GetType() != CIRCLE) return;
+    if (bob->IsStatic()) bob->SetMass(PENDULUM_BOB_MASS);
+    world.AddJoint(new DistanceJoint(nullptr, pendulumOrigin, bob, bob->position));
+}
+
+int Application::BodyIndex(const Body* body)
+{
+    if (!body) return -1;
+    auto it = std::find(world.bodies.begin(), world.bodies.end(), body);
+    return it != world.bodies.end() ? (int)(it - world.bodies.begin()) : -1;
+}
+
+Body* Application::BodyAt(int index)
+{
+    return (index >= 0 && index < (int)world.bodies.size()) ? world.bodies[index] : nullptr;
+}
+
+void Application::SceneReplaced()
+{
+    // A replay cannot re-execute a file load, so it restores the scene from here
+    WriteKeyframe(REPLAY_KEYFRAME_RESET);
+
+    // Rewinding across a load would need the file again; start a new history
+    rewind.Clear();
+    rewindHead = nullptr;
+    if (rewindEnabled)
+        CaptureRewind();
+}
+
+void Application::CaptureScene(SceneSnapshot& snapshot)
+{
+    snapshot.Capture(world);
+    snapshot.settings.flags = CurrentSettings().flags;
+
+    // The snapshot has no warm-start state; dropping ours here keeps this
+    // world stepping as one restored from it will, for the soft step's
+    // carried contact impulses above all
+    world.ClearCaches();
+}
+
+ReplayKeyframe Application::CaptureState(SceneSnapshot& snapshot, uint32_t flags)
+{
+    CaptureScene(snapshot);
+
+    // Interaction state lives outside the world but still steers the simulation
+    ReplayKeyframe keyframe {};
+    keyframe.frame                 = stepCount;
+    keyframe.flags                 = flags | (isRecentBodySelected ? REPLAY_KEYFRAME_SELECTED : 0u);
+    keyframe.greatBall             = BodyIndex(greatBall);
+    keyframe.selectedBody          = BodyIndex(recentSelectedBody);
+    keyframe.draggedBody           = BodyIndex(draggedBody);
+    keyframe.dragOffsetX           = dragOffset.x;
+    keyframe.dragOffsetY           = dragOffset.y;
+    keyframe.correction            = correctionValue;
+    if (const DistanceJoint* pendulum = Pendulum()) {
+        keyframe.pendulumLength  = pendulum->length;
+        keyframe.pendulumImpulse = pendulum->impulse;
+    }
+    if (const MouseJoint* mouse = DragJoint()) {
+        keyframe.flags        |= REPLAY_KEYFRAME_MOUSE_JOINT;
+        keyframe.mouseTargetX  = mouse->localAnchorA.x;
+        keyframe.mouseTargetY  = mouse->localAnchorA.y;
+        keyframe.mouseImpulseX = mouse->impulse.x;
+        keyframe.mouseImpulseY = mouse->impulse.y;
+    }
+    keyframe.stateHash             = static_cast<uint32_t>(world.StateHash());
+    return keyframe;
+}
+
+void Application::WriteKeyframe(uint32_t flags)
+{
+    if (!recorder.IsRecording()) return;
+
+    SceneSnapshot snapshot;
+    ReplayKeyframe keyframe = CaptureState(snapshot, flags);
+    recorder.Keyframe(keyframe, snapshot.View());
+}
+
+void Application::CaptureRewind()
+{
+    ReplayKeyframe state = CaptureState(rewindScratch, 0);
+    rewind.Capture(stepCount, state, rewindScratch);
+
+    // Capturing cleared the caches; a replay clears them at its keyframes,
+    // so it needs one here too
+    WriteKeyframe(0);
+}
+
+void Application::RewindTo(uint32_t step)
+{
+    const RewindBuffer::Frame* frame = rewind.Seek(step, rewindScratch);
+    if (!frame || !RestoreSnapshot(rewindScratch.View())) return;
+    ApplyKeyframe(frame->state);
+
+    // Re-simulate from the snapshot with the inputs recorded after it
+    size_t applied = 0;
+    for (; applied < frame->commands.size(); applied++) {
+        const InputCommand& command = frame->commands[applied];
+        if (command.type == InputType::STEP && stepCount >= step) break;
+        Apply(command);
+    }
+
+    // Inspecting the past: hold here until resumed, which drops the old future
+    pause = true;
+    rewindHead = frame;
+    rewindHeadCommands = applied;
+    if (deterministic)
+        stateHash = world.StateHash();
+
+    WriteKeyframe(REPLAY_KEYFRAME_RESET);
+}
+
+void Application::ApplyKeyframe(const ReplayKeyframe& keyframe)
+{
+    stepCount            = keyframe.frame;
+    greatBall            = BodyAt(keyframe.greatBall);
+    recentSelectedBody   = BodyAt(keyframe.selectedBody);
+    draggedBody          = BodyAt(keyframe.draggedBody);
+    isDragging           = draggedBody != nullptr;
+    isRecentBodySelected = (keyframe.flags & REPLAY_KEYFRAME_SELECTED) != 0;
+    dragOffset           = Vec2(keyframe.dragOffsetX, keyframe.dragOffsetY);
+    correctionValue      = keyframe.correction;
+    CollisionSolver::SetCorrectionValue(correctionValue);
+
+    // Snapshots leave joints out, so the restored pendulum picks up here
+    DistanceJoint* pendulum = Pendulum();
+    if (pendulum && keyframe.pendulumLength > 0.f) {
+        pendulum->length  = keyframe.pendulumLength;
+        pendulum->impulse = keyframe.pendulumImpulse;
+    }
+
+    // So does the drag: without its impulse, the next step's warm start
+    // would pull the body differently than the recorded one did
+    if ((keyframe.flags & REPLAY_KEYFRAME_MOUSE_JOINT) && draggedBody) {
+        SyncMouseJoint(draggedBody, Vec2(keyframe.mouseTargetX, keyframe.mouseTargetY));
+        DragJoint()->impulse = Vec2(keyframe.mouseImpulseX, keyframe.mouseImpulseY);
+    }
+}
+
+void Application::StartRecording(const std::string& filepath)
+{
+    std::filesystem::create_directories(std::filesystem::path(filepath).parent_path());
+    if (!recorder.Start(filepath)) {
+        std::cerr << "[Replay] Could not write: " << filepath << "\n";
+        return;
+    }
+
+    // The first keyframe is the scene the replay starts from
+    WriteKeyframe(REPLAY_KEYFRAME_RESET);
+    std::cout << "[Replay] Recording to: " << filepath << "\n";
+}
+
+void Application::StopRecording()
+{
+    if (!recorder.IsRecording()) return;
+
+    // Closing keyframe lets a replay verify the very end of the session
+    WriteKeyframe(0);
+    recorder.Stop();
+    std::cout << "[Replay] Stopped recording (" << recorder.BytesWritten() / 1024 << " KB)\n";
+}
+
+int Application::RunReplay(const std::string& filepath, int threads)
+{
+    ReplayReader reader;
+    if (!reader.Open(filepath)) {
+        std::cerr << "[Replay] Could not read: " << filepath << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    world.threadCount = threads;
+
+    size_t commandCount = 0, keyframeCount = 0, hashMismatches = 0;
+    float maxDivergence = 0.f;
+    bool restored = false;
+
+    ReplayReader::Chunk chunk;
+    while (reader.Next(chunk)) {
+        if (chunk.tag == ReplayFormat::TAG_CMDS) {
+            for (size_t offset = 0; offset + sizeof(InputCommand) <= chunk.size; offset += sizeof(InputCommand)) {
+                InputCommand command;
+                std::memcpy(&command, chunk.data + offset, sizeof(command));
+                Apply(command);
+                commandCount++;
+            }
+            continue;
         }
-        else if (shape == "box") {
-            body = new Body(BoxShape(b["width"].get<float>(), b["height"].get<float>()), x, y, mass, rotation);
+
+        if (chunk.tag != ReplayFormat::TAG_KEYF)
+            continue;
+
+        ReplayKeyframe keyframe;
+        SnapshotView view;
+        bool valid = chunk.size >= sizeof(keyframe);
+        if (valid) {
+            std::memcpy(&keyframe, chunk.data, sizeof(keyframe));
+            valid = StateFile::Parse(chunk.data + sizeof(keyframe), chunk.size - sizeof(keyframe), view);
         }
-        else if (shape == "polygon") {
-            body = new Body(PolygonShape(b["numSides"].get<int>(), b["size"].get<float>()), x, y, mass, rotation);
+        if (!valid) {
+            std::cerr << "[Replay] Corrupt keyframe in: " << filepath << "\n";
+            return 1;
         }
+        keyframeCount++;
 
-        if (body) {
-            // Restore full motion — this is what makes simulation resume correctly
-            body->velocity.x = b["velocityX"];
-            body->velocity.y = b["velocityY"];
-            body->angularVelocity = b["angularVelocity"];
-            body->restitution = b["restitution"];
-            body->friction = b["friction"];
-            body->gravity = b["gravity"];
-            body->rotation = rotation;
-
-            bodies.push_back(body);
+        // Scene was replaced while recording (or this is the start): take it as-is
+        if (!restored || (keyframe.flags & REPLAY_KEYFRAME_RESET)) {
+            if (!RestoreSnapshot(view)) {
+                std::cerr << "[Replay] Corrupt body records in: " << filepath << "\n";
+                return 1;
+            }
+            ApplyKeyframe(keyframe);
+            restored = true;
+            continue;
         }
+
+        // Otherwise the re-simulated scene must match what was recorded
+        if (view.bodyCount != world.bodies.size()) {
+            std::cerr << "[Replay] Step " << keyframe.frame << ": " << world.bodies.size()
+                      << " bodies, recorded " << view.bodyCount << "\n";
+            return 2;
+        }
+
+        float divergence = 0.f;
+        for (size_t i = 0; i < view.bodyCount; i++) {
+            divergence = std::max(divergence, std::fabs(world.bodies[i]->position.x - view.bodies[i].x));
+            divergence = std::max(divergence, std::fabs(world.bodies[i]->position.y - view.bodies[i].y));
+        }
+        if (divergence > REPLAY_TOLERANCE)
+            std::cerr << "[Replay] Step " << keyframe.frame << ": diverged by " << divergence << " px\n";
+        maxDivergence = std::max(maxDivergence, divergence);
+
+        // Bit-exact check on top of the tolerance
+        if (keyframe.stateHash != static_cast<uint32_t>(world.StateHash())) {
+            std::cerr << "[Replay] Step " << keyframe.frame << ": state hash mismatch\n";
+            hashMismatches++;
+        }
+
+        // The recording dropped its warm-start caches when it captured this
+        world.ClearCaches();
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[Replay] " << filepath << ": " << stepCount << " steps, " << commandCount << " commands, "
+              << keyframeCount << " keyframes, max divergence " << maxDivergence << " px, "
+              << hashMismatches << " hash mismatches (" << ms << " ms, " << threads << " threads)\n";
+    std::cout << "[Replay] Final state hash: " << std::hex << std::setw(16) << std::setfill('0')
+              << world.StateHash() << std::dec << "\n";
+
+    world.Clear();
+    return (maxDivergence <= REPLAY_TOLERANCE && hashMismatches == 0) ? 0 : 2;
+}
+
+// Frames of a small scene built through a NullRenderBackend: every body,
+// joint and debug box must come out as its command, sorted by layer and shape
+bool Application::CheckHeadlessFrames()
+{
+    Renderer::InitRenderer(screenWidth, screenHeight, std::make_unique<NullRenderBackend>());
+    const NullRenderBackend& backend = *static_cast<NullRenderBackend*>(Renderer::GetBackend());
+
+    // A floor, a row of each convex kind and a short chain hanging from the world
+    const int ROW = 20, LINKS = 5;
+    world.AddBody(new Body(BoxShape(800.f, 40.f), 400.f, 580.f, 0.f, 0.f));
+    for (int i = 0; i < ROW; i++) {
+        const float x = 30.f + 38.f * i;
+        world.AddBody(new Body(CircleShape(12.f), x, 100.f, 1.f, 0.f));
+        world.AddBody(new Body(BoxShape(24.f, 24.f), x, 160.f, 1.f, 0.3f * i));
+        world.AddBody(new Body(PolygonShape(5, 14.f), x, 220.f, 1.f, 0.3f * i));
+        world.AddBody(new Body(CapsuleShape(16.f, 8.f), x, 280.f, 1.f, 0.3f * i));
+    }
+    Body* previous = nullptr;
+    for (int i = 0; i < LINKS; i++) {
+        Body* link = new Body(CapsuleShape(12.f, 3.f), 780.f, 20.f + 16.f * (i + 0.5f), 0.2f, glm::radians(90.f));
+        world.AddBody(link);
+        world.AddJoint(new RevoluteJoint(previous, link, Vec2(780.f, 20.f + 16.f * i)));
+        previous = link;
+    }
+    world.debugDraw.flags = DEBUG_AABBS | DEBUG_BROADPHASE;
+
+    const int FRAMES = 60;
+    bool counted = true, ordered = true;
+    double us = 0.;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        Renderer::BeginFrame();
+        world.Step(World::FIXED_TIME_STEP);
+        const size_t debugBoxes = world.debugDraw.boxes.size();
+        // One fat box per body, drawn once the index was refit
+        const size_t fatBoxes = std::count_if(world.debugDraw.boxes.begin(), world.debugDraw.boxes.end(),
+            [](const DebugDraw::Box& box) { return box.color == DebugColor::YELLOW; });
+        counted = counted && fatBoxes == world.bodies.size();
+        auto start = std::chrono::steady_clock::now();
+        DrawScene();
+        Renderer::EndFrame();
+        us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        size_t shapes[4] = {};
+        const std::vector<RenderCommand>& commands = backend.LastFrame().Commands();
+        for (size_t i = 0; i < commands.size(); i++) {
+            const RenderCommand& cmd = commands[i];
+            shapes[static_cast<size_t>(cmd.shape)]++;
+            ordered = ordered && cmd.sortKey == ((static_cast<uint32_t>(cmd.layer) << 8) | static_cast<uint32_t>(cmd.shape));
+            ordered = ordered && (i == 0 || commands[i - 1].sortKey <= cmd.sortKey);
+        }
+        // Circles also draw their rotation line; capsules draw as polygons
+        counted = counted && commands.size() == Renderer::GetCommandList().Size()
+            && shapes[static_cast<size_t>(RenderShape::CIRCLE)] == ROW
+            && shapes[static_cast<size_t>(RenderShape::RECTANGLE)] == 1 + ROW + debugBoxes
+            && shapes[static_cast<size_t>(RenderShape::POLYGON)] == ROW + ROW + LINKS
+            && shapes[static_cast<size_t>(RenderShape::LINE)] == ROW + world.joints.size();
     }
+    counted = counted && backend.FrameCount() == FRAMES && backend.ShapeCount(RenderShape::CIRCLE) == size_t(FRAMES) * ROW;
+    std::cout << "[Bench] headless frames: " << backend.LastFrame().Size() << " commands, " << us / FRAMES
+              << " us to record and sort, " << (ordered ? "sorted" : "out of order") << "\n";
 
-    std::cout << "[State] Loaded " << bodies.size() << " bodies from: " << filepath << "\n";
+    Renderer::CleanupRenderer();
+    world.debugDraw.flags = DEBUG_NONE;
+    world.debugDraw.Clear();
+    world.Clear();
+    return counted && ordered;
 }
 
-Body* Application::SelectCircleInCanvas(double &x, double &y, Body* clickedBody){
-            for (auto body : bodies) {
-                     if (body->shape->GetType() == CIRCLE) {
-                             CircleShape* circleShape = (CircleShape*) body->shape;
-                                if (Utils::IsPointInCircle(x, y, body->position.x, body->position.y, circleShape->radius)) {
-                                    clickedBody = body;
-                                    // isBobSelected = true;
-                                    return clickedBody; 
-                                }
-                            }
-                             else if (body->shape->GetType() == BOX) {
-                                BoxShape* boxShape = (BoxShape*) body->shape;
-                                if (Utils::IsPointInBox(x, y, body, boxShape)) {
-                                    clickedBody = body;
-                                    return clickedBody; 
-                                }
-                          }
-                          isRecentBodySelected = false; 
-                   } 
-          return nullptr; 
+int Application::RunBenchmarks(int pairs)
+{
+    std::vector<Benchmarks::Check> checks;
+    Benchmarks::RunPhysics(pairs, checks);
+    // The renderer's check runs last, on the app's own world and draw code
+    checks.push_back({ "headless frames", CheckHeadlessFrames() });
+    return Benchmarks::Report(checks);
+}
+
+Body* Application::PickBody(const Vec2& point) {
+    // Where shapes overlap, the one centred nearest the cursor wins, so a
+    // click picks the same body whatever order the index reports them in
+    Body* hits[64];
+    const int count = world.QueryPoint(point, hits, 64);
+    Body* picked = nullptr;
+    float nearest = 0.f;
+    for (int i = 0; i < count; i++) {
+        const float distance = (hits[i]->position - point).MagnitudeSquared();
+        if (!picked || distance < nearest ||
+            (distance == nearest && (hits[i]->position.y < picked->position.y ||
+                                     (hits[i]->position.y == picked->position.y && hits[i]->position.x < picked->position.x)))) {
+            picked = hits[i];
+            nearest = distance;
+        }
+    }
+    if (!picked) isRecentBodySelected = false;
+    return picked;
 }
 
 void Application::MouseButtonCallBack(GLFWwindow* window, int button, int action, int mods) {
@@ -451,45 +889,76 @@ void Application::MouseButtonCallBack(GLFWwindow* window, int button, int action
     y = y * fbH / winH;
 
     switch (action) {
-        case GLFW_PRESS:
-            switch (button) {
+        case GLFW_PRESS: {
+            // Roll the polygon side count here so a replay spawns the same polygon
+            int sides = (button == GLFW_MOUSE_BUTTON_LEFT && (mods & GLFW_MOD_SHIFT)) ? RandomNumber(3, 6) : 0;
+            Execute(InputCommand::MousePress(button, mods, (float)x, (float)y, sides));
+            break;
+        }
+
+        case GLFW_RELEASE:
+            Execute(InputCommand::MouseRelease(button));
+            break;
+    }
+}
+
+void Application::Execute(const InputCommand& command) {
+    recorder.Record(command);
+
+    if (rewindEnabled) {
+        // New input after a rewind branches off; what came after is gone
+        if (rewindHead) {
+            rewind.TruncateAfter(rewindHead, rewindHeadCommands);
+            rewindHead = nullptr;
+        }
+        rewind.Record(command);
+    }
+
+    Apply(command);
+
+    if (rewindEnabled && command.type == InputType::STEP && stepCount % rewind.interval == 0)
+        CaptureRewind();
+}
+
+void Application::Apply(const InputCommand& command) {
+    switch (command.type) {
+        case InputType::STEP:
+            StepSimulation(command.a, command.button != 0, Vec2(command.x, command.y));
+            break;
+
+        case InputType::MOUSE_PRESS: {
+            double x = command.x, y = command.y;
+            switch (command.button) {
                 case GLFW_MOUSE_BUTTON_RIGHT:
-                    if (mods & GLFW_MOD_SHIFT) {
+                    if (command.mods & GLFW_MOD_SHIFT) {
                         // Shift + Right Click -> Create a box
                         otherBox = new Body(BoxShape(60.f, 60.f), x, y, 1.f, 0.f);
-                        bodies.push_back(otherBox);
+                        world.AddBody(otherBox);
                     } else {
                         // Just Right Click -> Create a circle
                         smallBall = new Body(CircleShape(35), x, y, 1.f, 0.f);
-                        bodies.push_back(smallBall);
+                        world.AddBody(smallBall);
                     }
                     break;
 
                 case GLFW_MOUSE_BUTTON_LEFT: {
-                    if (mods & GLFW_MOD_SHIFT) {
+                    if (command.mods & GLFW_MOD_SHIFT) {
                         // Shift + Left Click -> Create polygon
-                        otherPolygon = new Body(PolygonShape(RandomNumber(3, 6), 40.f), x, y, 1.f, 0.f);
-                        bodies.push_back(otherPolygon);
+                        otherPolygon = new Body(PolygonShape(command.value, 40.f), x, y, 1.f, 0.f);
+                        world.AddBody(otherPolygon);
                     } else {
-                        Body* clickedBody = SelectCircleInCanvas(x, y, clickedBody); 
+                        Body* clickedBody = PickBody(Vec2((float)x, (float)y));
 
                         // Set appropriate dragging state
                         if (clickedBody) {
-                            if (clickedBody == greatBall) {
-                                isDragging = true;
-                                draggedBody = greatBall;
-                                recentSelectedBody = greatBall; 
-                                isRecentBodySelected = true; 
-                            }
-                            else {
-                                isDragging = true;
-                                draggedBody = clickedBody;
-                                recentSelectedBody = clickedBody; 
-                                isRecentBodySelected = true; 
-                            }
-
-                            dragOffset.x = x - clickedBody->position.x;
-                            dragOffset.y = y - clickedBody->position.y;
+                            isDragging = true;
+                            draggedBody = clickedBody;
+                            recentSelectedBody = clickedBody; 
+                            isRecentBodySelected = true; 
+
+                            // In the body's frame, so the grab point turns with it
+                            dragOffset = Vec2((float)x - clickedBody->position.x,
+                                              (float)y - clickedBody->position.y).Rotate(-clickedBody->rotation);
                         }
 
                     }
@@ -499,18 +968,119 @@ void Application::MouseButtonCallBack(GLFWwindow* window, int button, int action
                 case GLFW_MOUSE_BUTTON_MIDDLE: {
                     // Middle click -> create a large box
                     Body* box = new Body(BoxShape(100, 100), x, y, 1.0, 0.f);
-                    bodies.push_back(box);
+                    world.AddBody(box);
                     break;
                 }
             }
             break;
+        }
 
-        case GLFW_RELEASE:
-            if (button == GLFW_MOUSE_BUTTON_LEFT) {
+        case InputType::MOUSE_RELEASE:
+            if (command.button == GLFW_MOUSE_BUTTON_LEFT) {
                 isDragging = false;
                 draggedBody = nullptr;
+                SyncMouseJoint(nullptr, Vec2());
             }
             break;
+
+        case InputType::ADD_BOX: {
+            Body* addBox = new Body(BoxShape(command.a, command.b), 200.f, 200.f, 1.f, command.c);
+            recentSelectedBody = addBox;
+            world.AddBody(addBox);
+            break;
+        }
+
+        case InputType::ADD_CAPSULE: {
+            // Width spans the whole capsule, height is its thickness
+            float radius = command.b * 0.5f;
+            Body* addCapsule = new Body(CapsuleShape(std::max(0.f, command.a - command.b), radius), 200.f, 200.f, 1.f, command.c);
+            recentSelectedBody = addCapsule;
+            world.AddBody(addCapsule);
+            break;
+        }
+
+        case InputType::ADD_L_SHAPE: {
+            // Upright bar on the left, base bar along the bottom, a third of the shorter side thick
+            float thickness = std::min(command.a, command.b) / 3.f;
+            BoxShape upright(thickness, command.b - thickness);
+            BoxShape base(command.a, thickness);
+            CompoundShape shape({
+                { &upright, Vec2((thickness - command.a) * 0.5f, -thickness * 0.5f), 0.f },
+                { &base,    Vec2(0.f, (command.b - thickness) * 0.5f), 0.f },
+            });
+            Body* addLShape = new Body(shape, 200.f, 200.f, 1.f, command.c);
+            recentSelectedBody = addLShape;
+            world.AddBody(addLShape);
+            break;
+        }
+
+        case InputType::ADD_OUTLINE: {
+            const CompoundShape* shape = Decomposition::FromOutline(PresetOutline(command.value, command.a));
+            if (!shape) break;
+            Body* addOutline = new Body(*shape, 200.f, 200.f, 1.f, command.c);
+            recentSelectedBody = addOutline;
+            world.AddBody(addOutline);
+            break;
+        }
+
+        case InputType::DELETE_SELECTED:
+            DeleteParticularBody(recentSelectedBody);
+            break;
+
+        case InputType::CLEAR_DYNAMIC:
+            ClearDynamicObjectOnScreen();
+            break;
+
+        case InputType::CULL:
+            RemoveOffScreenBodies(command.x, command.y);
+            break;
+
+        case InputType::SET_PARAM: {
+            float value = command.a;
+            switch (command.param) {
+                case InputParam::GRAVITY:       world.gravity = value; break;
+                case InputParam::RESTITUTION:   world.restitution = value; break;
+                case InputParam::FRICTION:      world.friction = value; break;
+                case InputParam::MAX_ITERATION: world.maxIteration = (int)value; break;
+                case InputParam::PAUSE:         pause = value != 0.f; break;
+                case InputParam::PENDULUM:      attachPendulum = value != 0.f; SyncPendulum(); break;
+                case InputParam::CONTINUOUS:    world.continuousCollision = value != 0.f; break;
+                case InputParam::SOLVER:        world.solver = static_cast<World::SolverType>((int)value); break;
+                case InputParam::SUBSTEPS:      world.substeps = std::max(1, (int)value); break;
+                case InputParam::CORRECTION:
+                    correctionValue = value;
+                    CollisionSolver::SetCorrectionValue(correctionValue);
+                    break;
+                case InputParam::GREAT_BALL_RADIUS:
+                    radius_ = value;
+                    if (greatBall) {
+                        greatBall->SetRadius(radius_);
+                        world.Refresh(greatBall);
+                    }
+                    break;
+                case InputParam::BODY_ROTATION:
+                    if (recentSelectedBody) {
+                        recentSelectedBody->rotation = value;
+                        world.Refresh(recentSelectedBody);
+                    }
+                    break;
+                case InputParam::BODY_WIDTH:
+                    if (recentSelectedBody) {
+                        recentSelectedBody->SetWidth(value);
+                        recentSelectedBody->UpdateShapeData();
+                        world.Refresh(recentSelectedBody);
+                    }
+                    break;
+                case InputParam::BODY_HEIGHT:
+                    if (recentSelectedBody) {
+                        recentSelectedBody->SetHeight(value);
+                        recentSelectedBody->UpdateShapeData();
+                        world.Refresh(recentSelectedBody);
+                    }
+                    break;
+            }
+            break;
+        }
     }
 }
 
@@ -527,10 +1097,10 @@ void Application::Shutdown() {
 }
 
 void Application::Destroy () {
-    for(auto body: bodies) {
-        delete body;
-    }
-    bodies.clear();
+    StopRecording();
+    stateWriter.Stop();
+    stateLoader.Stop();
+    world.Clear();
     
     // ImGui cleanup 
     ImGui_ImplOpenGL3_Shutdown();
@@ -551,42 +1121,48 @@ int Application::RandomNumber(int start, int end){
 }
 
 void Application::ClearOffScreenBodies(GLFWwindow* window) {
-    auto it = std::remove_if(bodies.begin(), bodies.end(),
-        [](Body* body) {
-            if (!body->IsStatic() && (
-                body->position.x < -400.f ||
-                body->position.x > screenWidth  + 400.f ||
-                body->position.y < -400.f ||
-                body->position.y > screenHeight + 400.f)) {
-                if (body == draggedBody)       { draggedBody = nullptr; isDragging = false; }
-                if (body == recentSelectedBody){ recentSelectedBody = nullptr; isRecentBodySelected = false; }
-                if (body == greatBall)          { greatBall = nullptr; }
-                delete body;
-                return true;
-            }
-            return false;
-        });
+    auto offScreen = [](Body* body) {
+        return !body->IsStatic() && (
+            body->position.x < -400.f ||
+            body->position.x > screenWidth  + 400.f ||
+            body->position.y < -400.f ||
+            body->position.y > screenHeight + 400.f);
+    };
 
-    if (it != bodies.end())
-        bodies.erase(it, bodies.end());
+    // Only record a cull on frames where it removes something
+    if (std::any_of(world.bodies.begin(), world.bodies.end(), offScreen))
+        Execute(InputCommand::Cull((float)screenWidth, (float)screenHeight));
+}
+
+void Application::RemoveOffScreenBodies(float width, float height) {
+    world.RemoveBodies([width, height](Body* body) {
+        if (!body->IsStatic() && (
+            body->position.x < -400.f ||
+            body->position.x > width  + 400.f ||
+            body->position.y < -400.f ||
+            body->position.y > height + 400.f)) {
+            if (body == draggedBody)       { draggedBody = nullptr; isDragging = false; }
+            if (body == recentSelectedBody){ recentSelectedBody = nullptr; isRecentBodySelected = false; }
+            if (body == greatBall)          { greatBall = nullptr; }
+            return true;
+        }
+        return false;
+    });
 }
 
 bool Application::ClearDynamicObjectOnScreen() {
-    auto it = std::remove_if(bodies.begin(), bodies.end(), [](Body* body) {
+    world.RemoveBodies([](Body* body) {
         if (!body) return false;
 
         if (!body->IsStatic()) {
             if (body == draggedBody)       { draggedBody = nullptr; isDragging = false; }
             if (body == recentSelectedBody){ recentSelectedBody = nullptr; isRecentBodySelected = false; }
             if (body == greatBall)          { greatBall = nullptr; }
-            delete body;
             return true;
         }
 
         return false;
     });
-
-    bodies.erase(it, bodies.end());
     return true;
 }
 
@@ -594,12 +1170,10 @@ bool Application::DeleteParticularBody(Body* body) {
    if(!body)
         return false;
 
-    auto it = std::find(bodies.begin(), bodies.end(), body);
-    if (it != bodies.end()) {
+    if (BodyIndex(body) >= 0) {
         if (body == draggedBody)  { draggedBody = nullptr; isDragging = false; }
         if (body == greatBall)     { greatBall = nullptr; }
-        delete *it;
-        bodies.erase(it);
+        world.RemoveBody(body);
         recentSelectedBody = nullptr;
         isRecentBodySelected = false;
         return true;
@@ -15,19 +15,29 @@
 
 #include <fstream>
 #include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <thread>
 #include "Physics/Body.h"
 #include "Physics/Shape.h"
 #include "Physics/CollisionDetection.h"
 #include "Physics/ContactInformation.h"
 #include "Physics/CollisionSolver.h"
+#include "Physics/Decomposition.h"
 #include "Physics/Constants.h"
-#include "Physics/WreckingBall/WreckingBall.h"
+#include "Physics/World.h"
 
+#include "Benchmarks.h"
+#include "Presets.h"
 #include "Renderer.h"
 #include "Utils.h"
 #include "GUI.h"
-
-#include "../../utils/json.hpp"
+#include "StateFile.h"
+#include "Replay.h"
+#include "Rewind.h"
+#include "StateWriter.h"
+#include "StateLoader.h"
 
 //#include "Pendulum.h"
 
@@ -42,7 +52,13 @@ class Application {
     static void Render(GLFWwindow* window); 
     static void SaveState(const std::string& filepath); 
     static void LoadState(const std::string& filepath);
-    static Body* SelectCircleInCanvas(double &x, double &y, Body* clickedBody); 
+    static void StartRecording(const std::string& filepath);
+    static void StopRecording();
+    static int  RunReplay(const std::string& filepath, int threads = 1);
+    // Headless timing and checks of each physics feature; names the failed ones
+    static int  RunBenchmarks(int pairs);
+    // Body under point, through the world's point query
+    static Body* PickBody(const Vec2& point);
     static void ClearOffScreenBodies(GLFWwindow* window); 
     static bool ClearDynamicObjectOnScreen(); 
     static bool DeleteParticularBody(Body* body); 
@@ -57,23 +73,51 @@ class Application {
     private:
     static int RandomNumber(int start, int end);
 
+    // Every scene-mutating input is executed as an InputCommand so it can be recorded and replayed
+    static void Execute(const InputCommand& command);
+    static void Apply(const InputCommand& command);
+    static void StepSimulation(float dt, bool dragging, Vec2 dragTarget);
+    // Pull body's grab point towards target through the world's mouse
+    // joint; null lets go
+    static void SyncMouseJoint(Body* body, const Vec2& target);
+    static MouseJoint* DragJoint();
+    // Record the scene's bodies, joints and debug primitives; no GL calls
+    static void DrawScene();
+    // Frames built headless through a NullRenderBackend, checked command by command
+    static bool CheckHeadlessFrames();
+    static void RemoveOffScreenBodies(float width, float height);
+    // Hang the bob from pendulumOrigin, or let it go, to match attachPendulum
+    static void SyncPendulum();
+    static DistanceJoint* Pendulum();
+    static bool RestoreSnapshot(const SnapshotView& view);
+    static SnapshotSettings CurrentSettings();
+    static void ReplaceScene(const SnapshotSettings& settings, std::vector<Body*>& bodies);
+    static void FinishLoad(StateLoader::Result& loaded);
+    static void SceneReplaced();
+    static void CaptureScene(SceneSnapshot& snapshot);
+    static ReplayKeyframe CaptureState(SceneSnapshot& snapshot, uint32_t flags);
+    static void WriteKeyframe(uint32_t flags);
+    static void CaptureRewind();
+    static void RewindTo(uint32_t step);
+    static void ApplyKeyframe(const ReplayKeyframe& keyframe);
+    static int  BodyIndex(const Body* body);
+    static Body* BodyAt(int index);
+
     // Application state
     static int screenWidth, screenHeight;
     static float radius;
     static float width, height;
     static float radius_;
-    static float gravity; 
-    static float restiutionValue; 
     static bool pause; 
-    static bool showNormal, showCollisionPoint; 
-    static int maxIteration; 
+    static bool showNormal, showCollisionPoint, showAABB, showBroadphase; 
     static float correctionValue;
-    static float frictionValue;
 
     // Physics objects
 
+    // Owns every body and runs the physics step
+    static World world;
+
     // ball
-    static std::vector<Body*> bodies;
     static Body* smallBall;
 
     // box 
@@ -93,18 +137,39 @@ class Application {
     static bool showSavedToast; 
     static bool showOverwriteModal;
     static bool showLoadFailToast;
+    static bool binaryState;
     static Body* greatBall;
     static Body* draggedBody;
     static Body* recentSelectedBody; 
-    static Vec2 dragOffset;
+    static Vec2 dragOffset; // grab point, in the dragged body's frame
     
     static ContactInformation contact;
-    static WreckingBall wb; 
+    static Vec2 pendulumOrigin;
+
+    // Deterministic mode: fixed dt steps and a per-step state hash
+    static bool deterministic;
+    static float stepAccumulator;
+    static uint64_t stateHash;
+
+    // Rewind history and where the last rewind left the simulation
+    static RewindBuffer rewind;
+    static SceneSnapshot rewindScratch;
+    static const RewindBuffer::Frame* rewindHead;
+    static size_t rewindHeadCommands;
+    static bool rewindEnabled;
+    static int rewindBudgetMB;
+    static int rewindInterval;
+
+    // Replay recording
+    static ReplayRecorder recorder;
+    static uint32_t stepCount;
 
     //State Save / Load 
     static std::string currentSceneName;
     static char        stateName[128];
     static char        pendingFilepath[256];
     static char        newSaveName[128];
+    static StateWriter stateWriter;
+    static StateLoader stateLoader;
     
 };
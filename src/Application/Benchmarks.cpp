@@ -0,0 +1,748 @@
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "Physics/CollisionDetection.h"
+#include "Physics/Decomposition.h"
+#include "Physics/Snapshot.h"
+#include "Physics/World.h"
+#include "Presets.h"
+#include "Rewind.h"
+
+namespace {
+    constexpr int ROUNDS = 20;
+
+    // Average cost of collide(i, contact) over every pair, ROUNDS times over
+    template <typename Collide>
+    double NsPerPair(int pairs, Collide collide) {
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++)
+            for (int i = 0; i < pairs; i++) {
+                ContactInformation contact;
+                collide(i, contact);
+            }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return ns / (double(ROUNDS) * pairs);
+    }
+
+    struct SolverRun { const char* name; World::SolverType solver; int passes; };
+    // The scenes that only need one run per solver take the cheapest of
+    // each, [0] and [3]
+    const SolverRun SOLVER_RUNS[] = {
+        { "iterative, 3 passes ", World::SolverType::ITERATIVE, 3 },
+        { "iterative, 10 passes", World::SolverType::ITERATIVE, 10 },
+        { "iterative, 30 passes", World::SolverType::ITERATIVE, 30 },
+        { "soft step, 2 substeps", World::SolverType::SOFT_STEP, 2 },
+        { "soft step, 4 substeps", World::SolverType::SOFT_STEP, 4 },
+        { "soft step, 8 substeps", World::SolverType::SOFT_STEP, 8 },
+    };
+
+    // An empty world solved the way run says
+    std::unique_ptr<World> MakeScene(const SolverRun& run) {
+        auto scene = std::make_unique<World>();
+        scene->solver = run.solver;
+        scene->maxIteration = run.passes;
+        scene->substeps = run.passes;
+        return scene;
+    }
+
+    // Static floor slab width pixels wide from x = 0, its top at y = top
+    Body* AddFloor(World& scene, float width, float top) {
+        Body* floor = new Body(BoxShape(width, 40.f), width * 0.5f, top + 20.f, 0.f, 0.f);
+        scene.AddBody(floor);
+        return floor;
+    }
+
+    // Random polygon and box pairs around one point, about half of them
+    // overlapping; SAT and GJK/EPA must agree on every one
+    bool BenchPolygonPairs(int pairs, std::mt19937& gen) {
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        auto makeBody = [&](float x, float y) -> Body* {
+            if (unit(gen) < 0.5f)
+                return new Body(PolygonShape(3 + (int)(unit(gen) * 6), 20.f + unit(gen) * 30.f), x, y, 1.f, unit(gen) * 6.28f);
+            return new Body(BoxShape(20.f + unit(gen) * 40.f, 20.f + unit(gen) * 40.f), x, y, 1.f, unit(gen) * 6.28f);
+        };
+
+        std::vector<Body*> a, b;
+        for (int i = 0; i < pairs; i++) {
+            float angle = unit(gen) * 6.28f, distance = unit(gen) * 90.f;
+            a.push_back(makeBody(400.f, 300.f));
+            b.push_back(makeBody(400.f + cosf(angle) * distance, 300.f + sinf(angle) * distance));
+            a.back()->shape->UpdateVertices(a.back()->rotation, a.back()->position);
+            b.back()->shape->UpdateVertices(b.back()->rotation, b.back()->position);
+        }
+
+        // Both paths must agree before their timings mean anything
+        std::vector<GJK::SimplexCache> caches(pairs);
+        int mismatches = 0, hits = 0;
+        float maxDepthError = 0.f;
+        for (int i = 0; i < pairs; i++) {
+            ContactInformation sat, gjk;
+            bool satHit = CollisionDetection::IsCollidingPolygonPolygon(a[i], b[i], sat);
+            bool gjkHit = CollisionDetection::IsCollidingConvex(a[i], b[i], gjk, &caches[i]);
+            if (satHit != gjkHit) mismatches++;
+            if (satHit && gjkHit) maxDepthError = std::max(maxDepthError, std::fabs(sat.depth - gjk.depth));
+            hits += satHit;
+        }
+
+        double satNs  = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingPolygonPolygon(a[i], b[i], c); });
+        double coldNs = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingConvex(a[i], b[i], c, nullptr); });
+        double warmNs = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingConvex(a[i], b[i], c, &caches[i]); });
+
+        std::cout << "[Bench] " << pairs << " polygon pairs, " << hits << " overlapping\n"
+                  << "[Bench] SAT:             " << satNs << " ns/pair\n"
+                  << "[Bench] GJK/EPA:         " << coldNs << " ns/pair\n"
+                  << "[Bench] GJK/EPA, cached: " << warmNs << " ns/pair\n"
+                  << "[Bench] " << mismatches << " disagreements, max depth difference " << maxDepthError << " px\n";
+
+        for (int i = 0; i < pairs; i++) {
+            delete a[i];
+            delete b[i];
+        }
+        return mismatches == 0;
+    }
+
+    // Capsule pairs against boxes of the same outer size, same placements;
+    // the capsule routine must agree with GJK/EPA
+    bool BenchCapsulePairs(int pairs, std::mt19937& gen) {
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        std::vector<Body*> a, b, boxA, boxB;
+        auto makePair = [&](std::vector<Body*>& capsules, std::vector<Body*>& boxes, float x, float y) {
+            float length = 10.f + unit(gen) * 40.f, radius = 8.f + unit(gen) * 12.f, rotation = unit(gen) * 6.28f;
+            capsules.push_back(new Body(CapsuleShape(length, radius), x, y, 1.f, rotation));
+            boxes.push_back(new Body(BoxShape(length + 2.f * radius, 2.f * radius), x, y, 1.f, rotation));
+            capsules.back()->shape->UpdateVertices(rotation, capsules.back()->position);
+            boxes.back()->shape->UpdateVertices(rotation, boxes.back()->position);
+        };
+        for (int i = 0; i < pairs; i++) {
+            float angle = unit(gen) * 6.28f, distance = unit(gen) * 90.f;
+            makePair(a, boxA, 400.f, 300.f);
+            makePair(b, boxB, 400.f + cosf(angle) * distance, 300.f + sinf(angle) * distance);
+        }
+
+        int mismatches = 0, hits = 0;
+        float maxDepthError = 0.f;
+        for (int i = 0; i < pairs; i++) {
+            ContactInformation exact, gjk;
+            bool exactHit = CollisionDetection::IsCollidingCapsuleCapsule(a[i], b[i], exact);
+            bool gjkHit = CollisionDetection::IsCollidingConvex(a[i], b[i], gjk, nullptr);
+            if (exactHit != gjkHit) mismatches++;
+            if (exactHit && gjkHit) maxDepthError = std::max(maxDepthError, std::fabs(exact.depth - gjk.depth));
+            hits += exactHit;
+        }
+
+        double capsuleNs    = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingCapsuleCapsule(a[i], b[i], c); });
+        double capsuleGjkNs = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingConvex(a[i], b[i], c, nullptr); });
+        double boxNs        = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingPolygonPolygon(boxA[i], boxB[i], c); });
+
+        std::cout << "[Bench] " << pairs << " capsule pairs, " << hits << " overlapping\n"
+                  << "[Bench] capsule-capsule: " << capsuleNs << " ns/pair\n"
+                  << "[Bench] same via GJK:    " << capsuleGjkNs << " ns/pair\n"
+                  << "[Bench] box-box SAT:     " << boxNs << " ns/pair\n"
+                  << "[Bench] " << mismatches << " disagreements, max depth difference " << maxDepthError << " px\n";
+
+        for (int i = 0; i < pairs; i++) {
+            delete a[i];
+            delete b[i];
+            delete boxA[i];
+            delete boxB[i];
+        }
+        return mismatches == 0;
+    }
+
+    // Boxes resting on terrain chains of growing length, against one 800px
+    // floor slab, then against a 50-part compound row and the same 50 boxes
+    // as bodies of their own, which must touch them as often
+    bool BenchChainsAndCompounds(int pairs, std::mt19937& gen) {
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        std::vector<Body*> boxes;
+        for (int i = 0; i < pairs; i++) {
+            float x = unit(gen) * 800.f;
+            boxes.push_back(new Body(BoxShape(20.f, 20.f), x, 300.f + 40.f * sinf(x * 0.005f) - 5.f, 1.f, 0.f));
+            boxes.back()->shape->UpdateVertices(0.f, boxes.back()->position);
+        }
+        Body slab(BoxShape(800.f, 20.f), 400.f, 310.f, 0.f, 0.f);
+        slab.shape->UpdateVertices(0.f, slab.position);
+        double slabNs = NsPerPair(pairs, [&](int i, ContactInformation& c) { return CollisionDetection::IsCollidingPolygonPolygon(&slab, boxes[i], c); });
+        std::cout << "[Bench] floor slab:      " << slabNs << " ns/body\n";
+
+        std::vector<ContactInformation> chainContacts;
+        for (int segments : { 80, 4096, 65536 }) {
+            // 10px segments; the boxes sit on the first 800px
+            std::vector<Vec2> points;
+            for (int i = 0; i <= segments; i++) points.push_back(Vec2(i * 10.f, 40.f * sinf(i * 0.05f)));
+            Body terrain(ChainShape(points), 0.f, 300.f, 0.f, 0.f);
+            terrain.shape->UpdateVertices(0.f, terrain.position);
+            double chainNs = NsPerPair(pairs, [&](int i, ContactInformation&) {
+                chainContacts.clear();
+                return CollisionDetection::CollideChain(&terrain, boxes[i], chainContacts) > 0;
+            });
+            std::cout << "[Bench] chain, " << std::setw(5) << segments << " seg: " << chainNs << " ns/body\n";
+        }
+
+        // As if welded together: the world tests each of those pairs
+        constexpr int PARTS = 50;
+        BoxShape partShape(16.f, 16.f);
+        std::vector<CompoundShape::Child> children;
+        std::vector<Body*> welded;
+        for (int k = 0; k < PARTS; k++) {
+            const float x = 8.f + 16.f * k;
+            children.push_back({ &partShape, Vec2(x - 400.f, 0.f), 0.f });
+            welded.push_back(new Body(partShape, x, 300.f, 1.f, 0.f));
+            welded.back()->shape->UpdateVertices(0.f, welded.back()->position);
+        }
+        Body compound(CompoundShape(children), 400.f, 300.f, 1.f, 0.f);
+        compound.shape->UpdateVertices(0.f, compound.position);
+
+        std::vector<ContactInformation> compoundContacts;
+        int weldedTouching = 0, compoundTouching = 0;
+        for (int i = 0; i < pairs; i++) {
+            for (Body* part : welded) {
+                ContactInformation contact;
+                weldedTouching += CollisionDetection::IsCollidingPolygonPolygon(part, boxes[i], contact);
+            }
+            compoundContacts.clear();
+            compoundTouching += CollisionDetection::CollideCompound(&compound, boxes[i], compoundContacts);
+        }
+        double weldedNs = NsPerPair(pairs, [&](int i, ContactInformation& c) {
+            bool hit = false;
+            for (Body* part : welded) hit = CollisionDetection::IsCollidingPolygonPolygon(part, boxes[i], c) || hit;
+            return hit;
+        });
+        double compoundNs = NsPerPair(pairs, [&](int i, ContactInformation&) {
+            compoundContacts.clear();
+            return CollisionDetection::CollideCompound(&compound, boxes[i], compoundContacts) > 0;
+        });
+        std::cout << "[Bench] " << PARTS << " welded bodies: " << weldedNs << " ns/body, " << weldedTouching << " contacts\n"
+                  << "[Bench] " << PARTS << "-part compound: " << compoundNs << " ns/body, " << compoundTouching << " contacts\n";
+        for (Body* part : welded) delete part;
+        for (Body* box : boxes) delete box;
+        return weldedTouching == compoundTouching;
+    }
+
+    // Concave presets: decomposing from scratch against a cache hit, and
+    // spawning a body from the cached compound
+    bool BenchDecomposition() {
+        bool decomposed = true;
+        for (int preset = 0; preset < OUTLINE_PRESETS; preset++) {
+            const std::vector<Vec2> outline = PresetOutline(preset, 100.f);
+            auto perCall = [&](auto&& fn) {
+                auto start = std::chrono::steady_clock::now();
+                for (int r = 0; r < ROUNDS * 100; r++) fn();
+                return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (ROUNDS * 100);
+            };
+            std::vector<std::vector<Vec2>> pieces;
+            double decomposeNs = perCall([&] { Decomposition::Decompose(outline, pieces); });
+            const CompoundShape* shape = Decomposition::FromOutline(outline);
+            double cachedNs = perCall([&] { Decomposition::FromOutline(outline); });
+            double spawnNs = shape ? perCall([&] { delete new Body(*shape, 0.f, 0.f, 1.f, 0.f); }) : 0.;
+            decomposed = decomposed && shape != nullptr;
+            std::cout << "[Bench] outline " << preset << ", " << outline.size() << " points -> " << pieces.size() << " pieces: "
+                      << decomposeNs << " ns decompose, " << cachedNs << " ns cached, " << spawnNs << " ns spawn\n";
+        }
+        return decomposed;
+    }
+
+    // Continuous collision: a resting scene pays one pass over velocities,
+    // a bullet fired at the floor pays its sweep and stays above it
+    bool BenchContinuous() {
+        auto sweepCost = [&](bool bullet, float& bulletY) {
+            World scene;
+            AddFloor(scene, 4000.f, 690.f);
+            for (int i = 0; i < 2000; i++)
+                scene.AddBody(new Body(BoxShape(16.f, 16.f), 2.f * i, 300.f, 1.f, 0.f));
+            Body* shot = nullptr;
+            if (bullet) {
+                shot = new Body(CircleShape(4.f), 1000.f, 500.f, 1.f, 0.f);
+                shot->bullet = true;
+                shot->velocity = Vec2(0.f, 20000.f);
+                scene.AddBody(shot);
+            }
+            scene.Integrate(World::FIXED_TIME_STEP);
+            auto start = std::chrono::steady_clock::now();
+            scene.SolveContinuous(World::FIXED_TIME_STEP);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            bulletY = shot ? shot->position.y : 0.f;
+            return us;
+        };
+        float bulletY = 0.f;
+        double restingUs = sweepCost(false, bulletY);
+        double bulletUs = sweepCost(true, bulletY);
+        std::cout << "[Bench] sweep, 2000 resting bodies: " << restingUs << " us, with a bullet: " << bulletUs
+                  << " us, bullet stopped at y=" << bulletY << "\n";
+        return bulletY < 690.f;
+    }
+
+    // Solvers: the tallest stack of boxes each holds for five seconds
+    // without toppling or sinking, and what a step of it costs. The soft
+    // step must stack at least MIN_SOFT_STACK high at every substep count,
+    // and as high as the iterative solver.
+    bool BenchStacks() {
+        auto stackHolds = [&](const SolverRun& run, int height, double& msPerStep) {
+            const float size = 30.f;
+            auto scene = MakeScene(run);
+            AddFloor(*scene, 800.f, 680.f);
+            for (int i = 0; i < height; i++)
+                scene->AddBody(new Body(BoxShape(size, size), 400.f, 680.f - size * (i + 0.5f), 1.f, 0.f));
+            const int steps = 300;
+            auto start = std::chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) scene->Step(World::FIXED_TIME_STEP);
+            msPerStep = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / steps;
+            const Body* top = scene->bodies.back();
+            const float sink = top->position.y - (680.f - size * (height - 0.5f));
+            bool holds = std::fabs(top->position.x - 400.f) < size * 0.25f && std::fabs(sink) < size * 0.5f;
+            for (const Body* body : scene->bodies) holds = holds && body->velocity.Magnitude() < 20.f;
+            return holds;
+        };
+        const int MIN_SOFT_STACK = 10;
+        int tallestIterative = 0, tallestSoft = 0;
+        bool softHolds = true;
+        for (const SolverRun& run : SOLVER_RUNS) {
+            int tallest = 0;
+            double ms = 0.;
+            for (int height = 2; height <= 30; height += 2) {
+                double stepMs = 0.;
+                if (!stackHolds(run, height, stepMs)) break;
+                tallest = height;
+                ms = stepMs;
+            }
+            int& best = run.solver == World::SolverType::SOFT_STEP ? tallestSoft : tallestIterative;
+            best = std::max(best, tallest);
+            if (run.solver == World::SolverType::SOFT_STEP) softHolds = softHolds && tallest >= MIN_SOFT_STACK;
+            std::cout << "[Bench] " << run.name << ": stack of " << tallest << ", " << ms << " ms/step, "
+                      << (ms > 0. ? tallest / ms : 0.) << " boxes per ms\n";
+        }
+        return softHolds && tallestSoft >= tallestIterative;
+    }
+
+    // Snapshots: a soft-step pile captured mid-fall, restored into a new
+    // world, must step on bit for bit with the world it was taken from,
+    // which drops its warm-start state on capture as the app does
+    bool BenchSnapshots() {
+        const SolverRun& run = SOLVER_RUNS[3];
+        auto live = MakeScene(run);
+        AddFloor(*live, 800.f, 680.f);
+        for (int i = 0; i < 10; i++)
+            live->AddBody(new Body(BoxShape(30.f, 30.f), 400.f + 3.f * i, 600.f - 40.f * i, 1.f, 0.1f * i));
+        for (int s = 0; s < 60; s++) live->Step(World::FIXED_TIME_STEP);
+
+        SceneSnapshot snapshot;
+        snapshot.Capture(*live);
+        live->ClearCaches();
+        auto restored = MakeScene(run);
+        std::vector<Body*> bodies;
+        if (!SceneSnapshot::CreateBodies(snapshot.View(), bodies)) return false;
+        for (Body* body : bodies) restored->AddBody(body);
+
+        const int steps = 120;
+        int matched = 0;
+        for (int s = 0; s < steps; s++) {
+            live->Step(World::FIXED_TIME_STEP);
+            restored->Step(World::FIXED_TIME_STEP);
+            if (live->StateHash() != restored->StateHash()) break;
+            matched++;
+        }
+        std::cout << "[Bench] " << run.name << ": restored pile matched " << matched << "/" << steps << " steps\n";
+        return matched == steps;
+    }
+
+    // Joints: a 500-link chain hanging from the world, its end kicked
+    // sideways, for five seconds; the widest any joint opens and the cost
+    bool BenchJoints() {
+        const int LINKS = 500;
+        const float LINK = 8.f;
+        // Every run, and the fewest passes and substeps the app offers
+        std::vector<SolverRun> runs(std::begin(SOLVER_RUNS), std::end(SOLVER_RUNS));
+        runs.push_back({ "iterative, 1 pass    ", World::SolverType::ITERATIVE, 1 });
+        runs.push_back({ "soft step, 1 substep ", World::SolverType::SOFT_STEP, 1 });
+        bool chained = true;
+        for (const SolverRun& run : runs) {
+            auto scene = MakeScene(run);
+            Body* previous = nullptr;
+            for (int i = 0; i < LINKS; i++) {
+                Body* link = new Body(CapsuleShape(LINK * 0.75f, 1.5f), 400.f, 100.f + LINK * (i + 0.5f), 0.2f, glm::radians(90.f));
+                scene->AddBody(link);
+                scene->AddJoint(new RevoluteJoint(previous, link, Vec2(400.f, 100.f + LINK * i)));
+                previous = link;
+            }
+            previous->velocity = Vec2(600.f, 0.f);
+            const int steps = 300;
+            float widest = 0.f;
+            double ms = 0.;
+            for (int s = 0; s < steps; s++) {
+                auto start = std::chrono::steady_clock::now();
+                scene->Step(World::FIXED_TIME_STEP);
+                ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                for (const Joint* joint : scene->joints)
+                    widest = std::max(widest, (joint->AnchorB() - joint->AnchorA()).Magnitude());
+            }
+            // Every link must stay on the next, with the end kicked into a whip,
+            // however few passes or substeps the chain gets
+            chained = chained && widest < LINK;
+            std::cout << "[Bench] " << run.name << ": " << LINKS << "-link chain, " << ms / steps << " ms/step, "
+                      << "widest joint " << widest << " px\n";
+        }
+        return chained;
+    }
+
+    // Dragging: a box pulled at a cursor that sweeps down through the floor
+    // and along it; the box must stay on top, however hard it is pulled
+    bool BenchDrag() {
+        bool held = true;
+        for (const SolverRun& run : SOLVER_RUNS) {
+            auto scene = MakeScene(run);
+            AddFloor(*scene, 800.f, 500.f);
+            Body* box = new Body(BoxShape(40.f, 40.f), 400.f, 300.f, 1.f, 0.f);
+            scene->AddBody(box);
+            MouseJoint* mouse = new MouseJoint(box, box->position, DRAG_MAX_ACCELERATION * box->mass);
+            scene->AddJoint(mouse);
+            float lowest = 0.f;
+            for (int s = 0; s < 240; s++) {
+                mouse->SetTarget(Vec2(400.f + 200.f * std::sin(s * 0.2f), 300.f + 70.f * std::min(s, 10)));
+                scene->Step(World::FIXED_TIME_STEP);
+                lowest = std::max(lowest, box->position.y);
+            }
+            held = held && box->position.y < 500.f;
+            std::cout << "[Bench] " << run.name << ": dragged into the floor, lowest centre y=" << lowest
+                      << ", rests at y=" << box->position.y << " (floor top y=500)\n";
+        }
+        return held;
+    }
+
+    // Picking: point queries in a scene of 100k turned boxes, polygons and
+    // circles, against a scan of every body through the same exact test
+    bool BenchPicking() {
+        World scene;
+        const int side = 316;
+        for (int i = 0; i < side * side; i++) {
+            const float x = 20.f * (i % side), y = 20.f * (i / side);
+            switch (i % 3) {
+                case 0:  scene.AddBody(new Body(BoxShape(18.f, 8.f), x, y, 1.f, 0.1f * i)); break;
+                case 1:  scene.AddBody(new Body(PolygonShape(3 + i % 4, 9.f), x, y, 1.f, 0.1f * i)); break;
+                default: scene.AddBody(new Body(CircleShape(7.f), x, y, 1.f, 0.f)); break;
+            }
+        }
+
+        const int queries = 10000;
+        std::vector<Vec2> points(queries);
+        uint32_t seed = 12345;
+        for (Vec2& point : points) {
+            seed = seed * 1664525u + 1013904223u;
+            point.x = 20.f * side * (seed >> 8) / 16777216.f;
+            seed = seed * 1664525u + 1013904223u;
+            point.y = 20.f * side * (seed >> 8) / 16777216.f;
+        }
+
+        Body* hits[16];
+        int found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const Vec2& point : points) found += scene.QueryPoint(point, hits, 16);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        const CircleShape probe(0.f);
+        int scanMismatches = 0;
+        for (int q = 0; q < 200; q++) {
+            int indexed = scene.QueryPoint(points[q], hits, 16), scanned = 0;
+            for (Body* body : scene.bodies) {
+                if (!body->shape->GetAABB(body->position).Contains(points[q])) continue;
+                const GJK::Result gap = GJK::Distance(*body->shape, body->position, probe, points[q], nullptr);
+                if (gap.overlap || gap.distance <= 0.f) scanned++;
+            }
+            if (indexed != scanned) scanMismatches++;
+        }
+        std::cout << "[Bench] pick among " << scene.bodies.size() << " bodies: " << us / queries << " us/query, "
+                  << found << " hits, " << scanMismatches << " disagreements with a full scan\n";
+        return scanMismatches == 0;
+    }
+
+    // Rays: a frame's worth of 6 m sight lines through 10k mixed bodies,
+    // batched on one thread and split across four whatever the machine has,
+    // against casting one by one and the split batch against the one-thread
+    // batch
+    bool BenchRays() {
+        bool rayed = true;
+        World scene;
+        const int side = 100;
+        for (int i = 0; i < side * side; i++) {
+            const float x = 30.f * (i % side), y = 30.f * (i / side);
+            switch (i % 4) {
+                case 0:  scene.AddBody(new Body(BoxShape(18.f, 8.f), x, y, 1.f, 0.37f * i)); break;
+                case 1:  scene.AddBody(new Body(PolygonShape(3 + i % 4, 9.f), x, y, 1.f, 0.37f * i)); break;
+                case 2:  scene.AddBody(new Body(CapsuleShape(12.f, 4.f), x, y, 1.f, 0.37f * i)); break;
+                default: scene.AddBody(new Body(CircleShape(7.f), x, y, 1.f, 0.f)); break;
+            }
+        }
+
+        std::vector<World::Ray> rays(10000);
+        uint32_t seed = 777;
+        auto next = [&seed] { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.f; };
+        for (World::Ray& ray : rays) {
+            ray.origin = Vec2(30.f * side * next(), 30.f * side * next());
+            const float angle = 6.2831853f * next();
+            ray.translation = Vec2(std::cos(angle), std::sin(angle)) * (6.f * Constants::PIXELS_PER_METER);
+        }
+
+        std::vector<World::RayResult> results(rays.size()), unsplit;
+        int hits = 0;
+        for (const World::Ray& ray : rays) {
+            World::RayResult single;
+            hits += scene.RayCast(ray.origin, ray.translation, World::RayMode::CLOSEST, &single, 1);
+        }
+        for (int count : { 1, 4 }) {
+            scene.threadCount = count;
+            auto start = std::chrono::steady_clock::now();
+            scene.RayCastBatch(rays.data(), (int)rays.size(), World::RayMode::CLOSEST, results.data());
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            for (size_t i = 0; i < rays.size(); i++) {
+                World::RayResult single;
+                scene.RayCast(rays[i].origin, rays[i].translation, World::RayMode::CLOSEST, &single, 1);
+                rayed = rayed && single.body == results[i].body && single.fraction == results[i].fraction;
+            }
+            if (count == 1)
+                unsplit = results;
+            for (size_t i = 0; i < rays.size(); i++) {
+                const World::RayResult& a = unsplit[i];
+                const World::RayResult& b = results[i];
+                rayed = rayed && a.body == b.body && a.fraction == b.fraction && a.point.x == b.point.x
+                              && a.point.y == b.point.y && a.normal.x == b.normal.x && a.normal.y == b.normal.y;
+            }
+            std::cout << "[Bench] " << rays.size() << " rays, " << count << " thread(s): " << us << " us, "
+                      << hits << " hits\n";
+        }
+        return rayed;
+    }
+
+    // Threads: a pile of more bodies than one thread takes, stepped with the
+    // parallel loops on one thread and split across two and four, whatever
+    // the machine has. Every step must hash the same at every count.
+    bool BenchThreads() {
+        bool matched = true;
+        const int BODIES = 4608, STEPS = 40;
+        for (const SolverRun& run : { SOLVER_RUNS[0], SOLVER_RUNS[3] }) {
+            std::vector<uint64_t> hashes;
+            for (int threads : { 1, 2, 4 }) {
+                auto scene = MakeScene(run);
+                scene->threadCount = threads;
+                AddFloor(*scene, 4000.f, 980.f);
+                for (int i = 0; i < BODIES; i++)
+                    scene->AddBody(new Body(BoxShape(18.f, 18.f), 10.f + 20.f * (i % 190), 940.f - 20.f * (i / 190), 1.f, 0.f));
+
+                double ms = 0.;
+                int firstMismatch = -1;
+                for (int s = 0; s < STEPS; s++) {
+                    auto start = std::chrono::steady_clock::now();
+                    scene->Step(World::FIXED_TIME_STEP);
+                    ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    if (threads == 1)
+                        hashes.push_back(scene->StateHash());
+                    else if (firstMismatch < 0 && scene->StateHash() != hashes[s])
+                        firstMismatch = s;
+                }
+                matched = matched && firstMismatch < 0;
+                std::cout << "[Bench] " << run.name << ": " << BODIES << "-box pile, " << threads << " thread(s), "
+                          << ms / STEPS << " ms/step, ";
+                if (threads == 1) std::cout << "reference hashes\n";
+                else if (firstMismatch < 0) std::cout << "all " << STEPS << " hashes match\n";
+                else std::cout << "hash differs from step " << firstMismatch << "\n";
+            }
+        }
+        return matched;
+    }
+
+    // Contact events: a pile of 2000 boxes settling. At every step the pairs
+    // reported touching must be those begun and not yet ended.
+    bool BenchContactEvents() {
+        bool evented = true;
+        for (const SolverRun& run : { SOLVER_RUNS[0], SOLVER_RUNS[3] }) {
+            auto scene = MakeScene(run);
+            AddFloor(*scene, 4000.f, 980.f);
+            for (int i = 0; i < 2000; i++)
+                scene->AddBody(new Body(BoxShape(18.f, 18.f), 10.f + 20.f * (i % 190), 940.f - 20.f * (i / 190), 1.f, 0.f));
+
+            size_t open = 0, peak = 0;
+            double ms = 0.;
+            const int steps = 120;
+            for (int s = 0; s < steps; s++) {
+                auto start = std::chrono::steady_clock::now();
+                scene->Step(World::FIXED_TIME_STEP);
+                ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                const World::ContactEvents& events = scene->contactEvents;
+                evented = evented && open - events.end.size() == events.persist.size();
+                open = events.begin.size() + events.persist.size();
+                peak = std::max(peak, open);
+            }
+            std::cout << "[Bench] " << run.name << ": 2000-box pile, " << ms / steps << " ms/step, "
+                      << peak << " touching pairs at most, " << open << " at rest\n";
+        }
+        return evented;
+    }
+
+    // Sensors: balls fall through a trigger zone onto the floor. They must
+    // land exactly as without the zone, and every enter end with an exit
+    // or the ball still inside.
+    bool BenchSensors() {
+        bool sensed = true;
+        for (const SolverRun& run : { SOLVER_RUNS[0], SOLVER_RUNS[3] }) {
+            std::vector<Vec2> landed[2];
+            int enters = 0, exits = 0;
+            size_t inside = 0;
+            for (int withZone = 0; withZone < 2; withZone++) {
+                auto scene = MakeScene(run);
+                AddFloor(*scene, 800.f, 580.f);
+                Body* zone = nullptr;
+                if (withZone) {
+                    BoxShape area(600.f, 100.f);
+                    area.sensor = true;
+                    zone = new Body(area, 400.f, 300.f, 0.f, 0.f);
+                    scene->AddBody(zone);
+                }
+                std::vector<Body*> balls;
+                for (int i = 0; i < 200; i++) {
+                    balls.push_back(new Body(CircleShape(8.f), 120.f + 28.f * (i % 20), 40.f - 25.f * (i / 20), 1.f, 0.f));
+                    scene->AddBody(balls.back());
+                }
+                for (int s = 0; s < 240; s++) {
+                    scene->Step(World::FIXED_TIME_STEP);
+                    enters += (int)scene->sensorEvents.enter.size();
+                    exits += (int)scene->sensorEvents.exit.size();
+                    for (const World::ContactEvent& event : scene->contactEvents.begin)
+                        sensed = sensed && event.a != zone && event.b != zone;
+                }
+                for (Body* ball : balls) {
+                    landed[withZone].push_back(ball->position);
+                    if (zone && ball->position.y > 250.f - 8.f && ball->position.y < 350.f + 8.f) inside++;
+                }
+            }
+            sensed = sensed && landed[0] == landed[1] && enters - exits == (int)inside && enters >= 200;
+            std::cout << "[Bench] " << run.name << ": 200 balls through a sensor, " << enters << " enters, "
+                      << exits << " exits, " << inside << " inside\n";
+        }
+        return sensed;
+    }
+
+    // Collision filtering: 1500 debris circles dropped overlapping, in a
+    // category that only meets the floor, plus two boxes overlapping in a
+    // negative group. No filtered pair may ever touch, and every body must
+    // reach the floor.
+    bool BenchFiltering() {
+        bool filtered = true;
+        for (const SolverRun& run : { SOLVER_RUNS[0], SOLVER_RUNS[3] }) {
+            auto scene = MakeScene(run);
+            Body* floor = AddFloor(*scene, 4000.f, 980.f);
+            CollisionFilter debris;
+            debris.categoryBits = 0x0002;
+            debris.maskBits = 0x0001;
+            for (int i = 0; i < 1500; i++) {
+                Body* body = new Body(CircleShape(10.f), 100.f + 12.f * (i % 300), 900.f - 12.f * (i / 300), 1.f, 0.f);
+                body->filter = debris;
+                scene->AddBody(body);
+            }
+            for (int i = 0; i < 2; i++) {
+                Body* body = new Body(BoxShape(60.f, 30.f), 3800.f + 20.f * i, 900.f, 1.f, 0.f);
+                body->filter.groupIndex = -1;
+                scene->AddBody(body);
+            }
+
+            auto keptApart = [](const Body* a, const Body* b) { return !a->filter.ShouldCollide(b->filter); };
+            double ms = 0.;
+            const int steps = 120;
+            std::vector<const Body*> landed;
+            for (int s = 0; s < steps; s++) {
+                auto start = std::chrono::steady_clock::now();
+                scene->Step(World::FIXED_TIME_STEP);
+                ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                for (const World::ContactEvent& event : scene->contactEvents.begin) {
+                    filtered = filtered && !keptApart(event.a, event.b);
+                    if (event.a == floor || event.b == floor) landed.push_back(event.a == floor ? event.b : event.a);
+                }
+            }
+            std::sort(landed.begin(), landed.end());
+            landed.erase(std::unique(landed.begin(), landed.end()), landed.end());
+            filtered = filtered && landed.size() == 1502;
+            std::cout << "[Bench] " << run.name << ": 1500 filtered debris, " << ms / steps << " ms/step, "
+                      << landed.size() << " bodies reached the floor\n";
+        }
+        return filtered;
+    }
+
+    // Rewinding: a filtered scene captured every ten steps, one body
+    // retagged before each capture, must come back from every frame, full
+    // or delta, with the bodies and filters it was captured with
+    bool BenchRewind() {
+        auto scene = MakeScene(SOLVER_RUNS[0]);
+        AddFloor(*scene, 800.f, 680.f);
+        for (int i = 0; i < 20; i++) {
+            Body* body = new Body(CircleShape(10.f), 100.f + 30.f * i, 600.f, 1.f, 0.f);
+            body->filter.categoryBits = static_cast<uint16_t>(1u << (i % 4));
+            scene->AddBody(body);
+        }
+
+        const uint32_t FRAMES = 8, INTERVAL = 10;
+        RewindBuffer rewind;
+        rewind.fullInterval = 4;
+        std::vector<SceneSnapshot> captured(FRAMES);
+        for (uint32_t frame = 0; frame < FRAMES; frame++) {
+            for (uint32_t s = 0; s < INTERVAL; s++) scene->Step(World::FIXED_TIME_STEP);
+            scene->bodies[1 + frame]->filter.groupIndex = static_cast<int16_t>(-1 - static_cast<int>(frame));
+            captured[frame].Capture(*scene);
+            rewind.Capture(frame * INTERVAL, ReplayKeyframe {}, captured[frame]);
+        }
+
+        auto same = [](const auto& a, const auto& b) {
+            return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+        };
+        bool restored = true;
+        int deltas = 0;
+        SceneSnapshot out;
+        for (uint32_t frame = 0; frame < FRAMES; frame++) {
+            const RewindBuffer::Frame* seeked = rewind.Seek(frame * INTERVAL, out);
+            restored = restored && seeked && same(out.bodies, captured[frame].bodies) &&
+                       same(out.filters, captured[frame].filters);
+            deltas += seeked && seeked->delta;
+        }
+        std::cout << "[Bench] rewind: " << FRAMES << " frames (" << deltas << " deltas) of a retagged scene, "
+                  << (restored ? "all restored" : "NOT restored") << " with their filters\n";
+        return restored;
+    }
+}
+
+void Benchmarks::RunPhysics(int pairs, std::vector<Check>& checks)
+{
+    // One generator for the narrowphase pairs, drawn from in this order
+    std::mt19937 gen(42);
+    checks.push_back({ "polygon pairs",         BenchPolygonPairs(pairs, gen) });
+    checks.push_back({ "capsule pairs",         BenchCapsulePairs(pairs, gen) });
+    checks.push_back({ "chains and compounds",  BenchChainsAndCompounds(pairs, gen) });
+    checks.push_back({ "decomposition",         BenchDecomposition() });
+    checks.push_back({ "continuous collision",  BenchContinuous() });
+    checks.push_back({ "stacking",              BenchStacks() });
+    checks.push_back({ "snapshots",             BenchSnapshots() });
+    checks.push_back({ "joints",                BenchJoints() });
+    checks.push_back({ "dragging",              BenchDrag() });
+    checks.push_back({ "picking",               BenchPicking() });
+    checks.push_back({ "rays",                  BenchRays() });
+    checks.push_back({ "threads",               BenchThreads() });
+    checks.push_back({ "contact events",        BenchContactEvents() });
+    checks.push_back({ "sensors",               BenchSensors() });
+    checks.push_back({ "collision filtering",   BenchFiltering() });
+    checks.push_back({ "rewind",                BenchRewind() });
+}
+
+int Benchmarks::Report(const std::vector<Check>& checks)
+{
+    int failed = 0;
+    for (const Check& check : checks) {
+        if (check.passed) continue;
+        std::cout << "[Bench] FAILED: " << check.name << "\n";
+        failed++;
+    }
+    return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+// Headless timing and checks of each physics feature (--bench). Each check
+// builds its own scenes, prints what it measured and reports whether the
+// feature did what it promises.
+namespace Benchmarks {
+    struct Check {
+        const char* name;
+        bool        passed;
+    };
+
+    // Runs every physics check, always in the same order, appending one
+    // Check each
+    void RunPhysics(int pairs, std::vector<Check>& checks);
+
+    // Names the failed checks; 0 when all passed, 2 otherwise
+    int Report(const std::vector<Check>& checks);
+}
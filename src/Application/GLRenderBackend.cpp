@@ -0,0 +1,285 @@
+#include "GLRenderBackend.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include "Physics/Constants.h"
+
+namespace {
+
+const float rectVertices[8] = {
+    -0.5f, -0.5f,
+     0.5f, -0.5f,
+     0.5f,  0.5f,
+    -0.5f,  0.5f
+};
+
+const char* vertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;
+uniform mat4 uModel;
+uniform mat4 uProj;
+void main() {
+    gl_Position = uProj * uModel * vec4(aPos, 0.0, 1.0);
+})";
+
+const char* fragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+uniform vec3 uColor;
+void main() {
+    FragColor = vec4(uColor, 1.0);
+})";
+
+const char* lineVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uProj;
+out vec3 vColor;
+void main() {
+    vColor = aColor.rgb;
+    gl_Position = uProj * vec4(aPos, 0.0, 1.0);
+})";
+
+const char* lineFragmentShaderSource = R"(
+#version 330 core
+in vec3 vColor;
+out vec4 FragColor;
+void main() {
+    FragColor = vec4(vColor, 1.0);
+})";
+
+}
+
+// === Internal Utility Functions ===
+std::vector<float> GLRenderBackend::GenerateCircleOutline(int segments) {
+    std::vector<float> vertices;
+    for (int i = 0; i < segments; ++i) {
+        float theta = 2.0f * Constants::PI * i / segments;
+        vertices.push_back(std::cos(theta));
+        vertices.push_back(std::sin(theta));
+    }
+    return vertices;
+}
+
+GLuint GLRenderBackend::CompileShaderProgram(const char* vsSource, const char* fsSource) {
+    auto compile = [](GLenum type, const char* src) -> GLuint {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        return shader;
+    };
+
+    GLuint vs = compile(GL_VERTEX_SHADER, vsSource);
+    GLuint fs = compile(GL_FRAGMENT_SHADER, fsSource);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    return program;
+}
+
+// === Lifetime ===
+void GLRenderBackend::Init(int screenWidth, int screenHeight) {
+    Resize(screenWidth, screenHeight);
+
+    shaderProgram = CompileShaderProgram(vertexShaderSource, fragmentShaderSource);
+    modelLoc = glGetUniformLocation(shaderProgram, "uModel");
+    projLoc  = glGetUniformLocation(shaderProgram, "uProj");
+    colorLoc = glGetUniformLocation(shaderProgram, "uColor");
+
+    lineShaderProgram = CompileShaderProgram(lineVertexShaderSource, lineFragmentShaderSource);
+    lineProjLoc = glGetUniformLocation(lineShaderProgram, "uProj");
+
+    // Circle VAO
+    std::vector<float> circle = GenerateCircleOutline(CIRCLE_SEGMENTS);
+    glGenVertexArrays(1, &circleVAO);
+    glGenBuffers(1, &circleVBO);
+    glBindVertexArray(circleVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
+    glBufferData(GL_ARRAY_BUFFER, circle.size() * sizeof(float), circle.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+
+    // Rectangle VAO
+    glGenVertexArrays(1, &rectVAO);
+    glGenBuffers(1, &rectVBO);
+    glBindVertexArray(rectVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, rectVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(rectVertices), rectVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+
+    // Streaming line VAO
+    glGenVertexArrays(1, &lineVAO);
+    glGenBuffers(1, &lineVBO);
+    glBindVertexArray(lineVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(LineVertex), (void*)offsetof(LineVertex, color));
+    glEnableVertexAttribArray(1);
+    ReserveLineBuffer(1 << 16);
+
+    boundVAO = 0;
+    glBindVertexArray(0);
+}
+
+void GLRenderBackend::Resize(int screenWidth, int screenHeight) {
+    projection = glm::ortho(0.0f, float(screenWidth), float(screenHeight), 0.0f, -1.0f, 1.0f);
+}
+
+void GLRenderBackend::Shutdown() {
+    glDeleteBuffers(1, &circleVBO);
+    glDeleteVertexArrays(1, &circleVAO);
+    glDeleteBuffers(1, &rectVBO);
+    glDeleteVertexArrays(1, &rectVAO);
+    glDeleteBuffers(1, &lineVBO);
+    glDeleteVertexArrays(1, &lineVAO);
+    glDeleteProgram(shaderProgram);
+    glDeleteProgram(lineShaderProgram);
+    lineBatch.clear();
+}
+
+// === State tracking ===
+void GLRenderBackend::UseProgram(GLuint program) {
+    if (boundProgram == program) return;
+    glUseProgram(program);
+    boundProgram = program;
+
+    // Projection only changes on resize, upload it once per program per frame
+    GLint loc = (program == lineShaderProgram) ? lineProjLoc : projLoc;
+    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(projection));
+}
+
+void GLRenderBackend::BindVertexArray(GLuint vao) {
+    if (boundVAO == vao) return;
+    glBindVertexArray(vao);
+    boundVAO = vao;
+}
+
+// === Execution ===
+void GLRenderBackend::Execute(const RenderCommandList& list) {
+    glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // ImGui and other code may have touched GL state since the last frame
+    boundProgram = 0;
+    boundVAO = 0;
+
+    for (const RenderCommand& cmd : list.Commands()) {
+        switch (cmd.shape) {
+            case RenderShape::CIRCLE:
+                FlushLines();
+                DrawMesh(cmd, circleVAO, CIRCLE_SEGMENTS);
+                break;
+            case RenderShape::RECTANGLE:
+                FlushLines();
+                DrawMesh(cmd, rectVAO, 4);
+                break;
+            case RenderShape::POLYGON:
+            case RenderShape::LINE:
+                QueueOutline(cmd, list.Points());
+                break;
+        }
+    }
+    FlushLines();
+}
+
+void GLRenderBackend::DrawMesh(const RenderCommand& cmd, GLuint vao, GLsizei vertexCount) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(cmd.x, cmd.y, 0.0f));
+    if (cmd.rotation != 0.0f)
+        model = glm::rotate(model, cmd.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+    model = glm::scale(model, glm::vec3(cmd.scaleX, cmd.scaleY, 1.0f));
+
+    glm::vec3 color = RenderCommandList::UnpackColor(cmd.color);
+
+    UseProgram(shaderProgram);
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform3f(colorLoc, color.r, color.g, color.b);
+
+    BindVertexArray(vao);
+    glDrawArrays(GL_LINE_LOOP, 0, vertexCount);
+}
+
+void GLRenderBackend::QueueOutline(const RenderCommand& cmd, const std::vector<Vec2>& points) {
+    const Vec2* pts = points.data() + cmd.firstPoint;
+
+    if (cmd.shape == RenderShape::LINE) {
+        lineBatch.push_back({ pts[0].x, pts[0].y, cmd.color });
+        lineBatch.push_back({ pts[1].x, pts[1].y, cmd.color });
+        return;
+    }
+
+    // Expand the closed outline into independent segments so polygons and
+    // lines share one GL_LINES batch
+    for (uint32_t i = 0; i < cmd.pointCount; ++i) {
+        const Vec2& p1 = pts[i];
+        const Vec2& p2 = pts[(i + 1) % cmd.pointCount];
+        lineBatch.push_back({ p1.x, p1.y, cmd.color });
+        lineBatch.push_back({ p2.x, p2.y, cmd.color });
+    }
+}
+
+void GLRenderBackend::ReserveLineBuffer(GLsizeiptr vertexCount) {
+    lineBufferCapacity = vertexCount;
+    lineBufferHead = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+    glBufferData(GL_ARRAY_BUFFER, lineBufferCapacity * sizeof(LineVertex), nullptr, GL_STREAM_DRAW);
+}
+
+void GLRenderBackend::FlushLines() {
+    if (lineBatch.empty()) return;
+
+    GLsizeiptr count = static_cast<GLsizeiptr>(lineBatch.size());
+
+    BindVertexArray(lineVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+
+    // Grow once if a frame outgrows the ring, otherwise wrap around by
+    // orphaning the store so the driver never stalls on in-flight draws
+    if (count > lineBufferCapacity) {
+        GLsizeiptr capacity = lineBufferCapacity;
+        while (capacity < count) capacity *= 2;
+        ReserveLineBuffer(capacity);
+    } else if (lineBufferHead + count > lineBufferCapacity) {
+        ReserveLineBuffer(lineBufferCapacity);
+    }
+
+    // The range past the head has never been handed to the GPU since the last
+    // orphan, so it can be written without synchronisation
+    const GLintptr offset = lineBufferHead * sizeof(LineVertex);
+    const GLsizeiptr size = count * sizeof(LineVertex);
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst) {
+        std::memcpy(dst, lineBatch.data(), size);
+        // False if the store was lost while mapped; upload it again below
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) dst = nullptr;
+    }
+    if (!dst) {
+        // Slower, as the driver may wait for draws still reading the
+        // buffer, but the lines still show
+        if (!mapFailed)
+            std::cerr << "[Render] Could not map the line buffer, uploading lines with glBufferSubData instead\n";
+        mapFailed = true;
+        glBufferSubData(GL_ARRAY_BUFFER, offset, size, lineBatch.data());
+    }
+
+    UseProgram(lineShaderProgram);
+    glDrawArrays(GL_LINES, static_cast<GLint>(lineBufferHead), static_cast<GLsizei>(count));
+    lineBufferHead += count;
+
+    lineBatch.clear();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../glad/glad.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "RenderBackend.h"
+
+// OpenGL 3.3 backend. Circles and rectangles reuse static unit meshes,
+// polygon outlines and lines are streamed through a ring-buffer VBO.
+class GLRenderBackend : public RenderBackend {
+public:
+    void Init(int screenWidth, int screenHeight) override;
+    void Resize(int screenWidth, int screenHeight) override;
+    void Execute(const RenderCommandList& list) override;
+    void Shutdown() override;
+
+private:
+    struct LineVertex {
+        float x, y;
+        uint32_t color; // RGBA8, normalized in the vertex fetch
+    };
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    void DrawMesh(const RenderCommand& cmd, GLuint vao, GLsizei vertexCount);
+    void QueueOutline(const RenderCommand& cmd, const std::vector<Vec2>& points);
+    void FlushLines();
+    void ReserveLineBuffer(GLsizeiptr vertexCount);
+
+    static std::vector<float> GenerateCircleOutline(int segments);
+    static GLuint CompileShaderProgram(const char* vsSource, const char* fsSource);
+
+    glm::mat4 projection {1.0f};
+
+    // Mesh program: unit geometry transformed by uModel
+    GLuint shaderProgram = 0;
+    GLint  modelLoc = -1, projLoc = -1, colorLoc = -1;
+    GLuint circleVAO = 0, circleVBO = 0;
+    GLuint rectVAO = 0, rectVBO = 0;
+
+    // Streaming line program
+    GLuint lineShaderProgram = 0;
+    GLint  lineProjLoc = -1;
+    GLuint lineVAO = 0, lineVBO = 0;
+    GLsizeiptr lineBufferCapacity = 0; // in vertices
+    GLsizeiptr lineBufferHead = 0;     // next free vertex in the ring
+    std::vector<LineVertex> lineBatch;
+    bool mapFailed = false;            // reported once, then lines go through glBufferSubData
+
+    // Currently bound state, so sorted commands skip redundant GL calls
+    GLuint boundProgram = 0;
+    GLuint boundVAO = 0;
+
+    static constexpr int CIRCLE_SEGMENTS = 100;
+};
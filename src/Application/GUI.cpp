@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <thread>
 
 // Static member definitions
 bool  GUI::show_panel    = true;
@@ -10,6 +12,7 @@ float GUI::panel_x       = 0.0f;
 float GUI::addBoxWidth   = 100.f;
 float GUI::addBoxHeight  = 20.f;
 float GUI::localRotation = 0.f;
+int   GUI::outlinePreset = 0;
 
 float GUI::EaseOut(float a, float b, float t) {
     t = 1 - powf(1 - t, 3);
@@ -83,16 +86,48 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
         ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.0f, 0.3f, 0.0f, 1.f));
     }
     if (ImGui::Button(isPaused ? "Resume" : "Pause", ImVec2(-1, 32)))
-        ctx.pause = !ctx.pause;
+        ctx.onCommand(InputCommand::SetParam(InputParam::PAUSE, isPaused ? 0.f : 1.f));
     ImGui::PopStyleColor(3);
     ImGui::Spacing();
 
-    ImGui::SliderFloat("Gravity",     &ctx.gravity,     -10.f, 10.f);
-    ImGui::SliderFloat("Restitution", &ctx.restitution,  0.0f,  1.f);
-    ImGui::SliderFloat("Friction",    &ctx.friction,     0.0f,  1.f);
-    ImGui::InputInt("Max Iterations", &ctx.maxIteration, 1);
-    if (ImGui::SliderFloat("Correction", &ctx.correctionValue, 0.0f, 1.f))
-        CollisionSolver::SetCorrectionValue(ctx.correctionValue);
+    // Widgets edit copies; the change itself is applied through a command
+    float gravity      = ctx.gravity;
+    float restitution  = ctx.restitution;
+    float friction     = ctx.friction;
+    int   maxIteration = ctx.maxIteration;
+    float correction   = ctx.correctionValue;
+    if (ImGui::SliderFloat("Gravity",     &gravity,     -10.f, 10.f))
+        ctx.onCommand(InputCommand::SetParam(InputParam::GRAVITY, gravity));
+    if (ImGui::SliderFloat("Restitution", &restitution,  0.0f,  1.f))
+        ctx.onCommand(InputCommand::SetParam(InputParam::RESTITUTION, restitution));
+    if (ImGui::SliderFloat("Friction",    &friction,     0.0f,  1.f))
+        ctx.onCommand(InputCommand::SetParam(InputParam::FRICTION, friction));
+    if (ImGui::InputInt("Max Iterations", &maxIteration, 1))
+        ctx.onCommand(InputCommand::SetParam(InputParam::MAX_ITERATION, (float)maxIteration));
+    if (ImGui::SliderFloat("Correction", &correction, 0.0f, 1.f))
+        ctx.onCommand(InputCommand::SetParam(InputParam::CORRECTION, correction));
+    bool continuous = ctx.continuousCollision;
+    if (ImGui::Checkbox("Continuous Collision", &continuous))
+        ctx.onCommand(InputCommand::SetParam(InputParam::CONTINUOUS, continuous ? 1.f : 0.f));
+
+    // Soft step finds contacts once and substeps them; iterations do not apply
+    static const char* solverNames[] = { "Iterative", "Soft Step" };
+    int solver   = static_cast<int>(ctx.solver);
+    int substeps = ctx.substeps;
+    if (ImGui::Combo("Solver", &solver, solverNames, IM_ARRAYSIZE(solverNames)))
+        ctx.onCommand(InputCommand::SetParam(InputParam::SOLVER, (float)solver));
+    if (ctx.solver == World::SolverType::SOFT_STEP && ImGui::SliderInt("Substeps", &substeps, 1, 16))
+        ctx.onCommand(InputCommand::SetParam(InputParam::SUBSTEPS, (float)substeps));
+
+    // Thread count only splits per-body work, results do not depend on it
+    ImGui::Checkbox("Deterministic (fixed dt)", &ctx.deterministic);
+    static const int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    ImGui::SliderInt("Physics Threads", &ctx.physicsThreads, 1, maxThreads);
+    if (ctx.deterministic) {
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.45f, 0.45f, 0.55f, 1.f));
+        ImGui::Text("State hash: %016llx", (unsigned long long)ctx.stateHash);
+        ImGui::PopStyleColor();
+    }
 
     ImGui::Spacing();
 
@@ -104,6 +139,11 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
     ImGui::SameLine();
     if (ImGui::Button(ctx.showCollisionPoint ? "Hide Contacts" : "Show Contacts", ImVec2(-1, 28)))
         ctx.showCollisionPoint = !ctx.showCollisionPoint;
+    if (ImGui::Button(ctx.showAABB ? "Hide AABBs" : "Show AABBs", ImVec2(160, 28)))
+        ctx.showAABB = !ctx.showAABB;
+    ImGui::SameLine();
+    if (ImGui::Button(ctx.showBroadphase ? "Hide Broadphase" : "Show Broadphase", ImVec2(-1, 28)))
+        ctx.showBroadphase = !ctx.showBroadphase;
     ImGui::PopStyleColor(3);
 
     // --- Great ball ---
@@ -111,14 +151,15 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
     ImGui::SeparatorText("Great Ball");
     ImGui::Spacing();
 
-    if (ImGui::SliderFloat("Circle Radius", &ctx.radius_, 10.f, 200.f))
-        if (ctx.greatBall) ctx.greatBall->SetRadius(ctx.radius_);
+    float radius = ctx.radius_;
+    if (ImGui::SliderFloat("Circle Radius", &radius, 10.f, 200.f))
+        ctx.onCommand(InputCommand::SetParam(InputParam::GREAT_BALL_RADIUS, radius));
 
     ImGui::PushStyleColor(ImGuiCol_Button,        ImVec4(0.3f,  0.2f, 0.5f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.5f,  0.3f, 0.8f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.2f,  0.1f, 0.4f, 1.f));
     if (ImGui::Button(ctx.attachPendulum ? "Detach Pendulum" : "Attach Pendulum", ImVec2(-1, 28)))
-        ctx.attachPendulum = !ctx.attachPendulum;
+        ctx.onCommand(InputCommand::SetParam(InputParam::PENDULUM, ctx.attachPendulum ? 0.f : 1.f));
     ImGui::PopStyleColor(3);
 
     // --- Body builder ---
@@ -129,11 +170,17 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
     ImGui::PushStyleColor(ImGuiCol_Button,        ImVec4(0.15f, 0.35f, 0.55f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.25f, 0.50f, 0.80f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.10f, 0.25f, 0.40f, 1.f));
-    if (ImGui::Button("+ Add Box", ImVec2(120, 30))) {
-        Body* addBox = new Body(BoxShape(addBoxWidth, addBoxHeight), 200.f, 200.f, 1.f, localRotation);
-        ctx.recentSelectedBody = addBox;
-        ctx.bodies.push_back(addBox);
-    }
+    if (ImGui::Button("+ Add Box", ImVec2(120, 30)))
+        ctx.onCommand(InputCommand::AddBox(addBoxWidth, addBoxHeight, localRotation));
+    ImGui::SameLine();
+    if (ImGui::Button("+ Add Capsule", ImVec2(120, 30)))
+        ctx.onCommand(InputCommand::AddCapsule(addBoxWidth, addBoxHeight, localRotation));
+    ImGui::SameLine();
+    if (ImGui::Button("+ Add L-Shape", ImVec2(120, 30)))
+        ctx.onCommand(InputCommand::AddLShape(addBoxWidth, addBoxHeight, localRotation));
+    // Cycles through the concave presets, one per click
+    if (ImGui::Button("+ Add Concave", ImVec2(120, 30)))
+        ctx.onCommand(InputCommand::AddOutline(outlinePreset++, addBoxWidth, localRotation));
     ImGui::PopStyleColor(3);
 
     ImGui::SameLine();
@@ -142,7 +189,7 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.80f, 0.20f, 0.20f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.40f, 0.08f, 0.08f, 1.f));
     if (ImGui::Button("Clear All", ImVec2(-1, 30)))
-        ctx.onClearAll();
+        ctx.onCommand(InputCommand::ClearDynamic());
     ImGui::PopStyleColor(3);
 
     ImGui::Spacing();
@@ -158,16 +205,12 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
         ImGui::Spacing();
 
         if (ImGui::SliderAngle("Rotation", &localRotation, -90.f, 90.f))
-            ctx.recentSelectedBody->rotation = localRotation;
+            ctx.onCommand(InputCommand::SetParam(InputParam::BODY_ROTATION, localRotation));
 
-        if (ImGui::InputFloat("Width", &addBoxWidth, 1.f, 10.f, "%.1f")) {
-            ctx.recentSelectedBody->SetWidth(addBoxWidth);
-            ctx.recentSelectedBody->UpdateShapeData();
-        }
-        if (ImGui::InputFloat("Height", &addBoxHeight, 1.f, 10.f, "%.1f")) {
-            ctx.recentSelectedBody->SetHeight(addBoxHeight);
-            ctx.recentSelectedBody->UpdateShapeData();
-        }
+        if (ImGui::InputFloat("Width", &addBoxWidth, 1.f, 10.f, "%.1f"))
+            ctx.onCommand(InputCommand::SetParam(InputParam::BODY_WIDTH, addBoxWidth));
+        if (ImGui::InputFloat("Height", &addBoxHeight, 1.f, 10.f, "%.1f"))
+            ctx.onCommand(InputCommand::SetParam(InputParam::BODY_HEIGHT, addBoxHeight));
 
         ImGui::Spacing();
 
@@ -175,7 +218,7 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
         ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.80f, 0.20f, 0.20f, 1.f));
         ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.40f, 0.08f, 0.08f, 1.f));
         if (ImGui::Button("Delete Selected", ImVec2(-1, 28)))
-            ctx.onDeleteBody(ctx.recentSelectedBody);
+            ctx.onCommand(InputCommand::DeleteSelected());
         ImGui::PopStyleColor(3);
 
         ImGui::EndChild();
@@ -189,9 +232,11 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
 
     ImGui::SetNextItemWidth(-1);
     ImGui::InputText("##stateName", ctx.stateName, 128);
+    ImGui::Checkbox("Binary format (.rbs)", &ctx.binaryState);
 
     ImGui::Spacing();
-    std::string filepath = std::string("states/") + ctx.stateName + ".json";
+    const char* extension = ctx.binaryState ? StateFile::BINARY_EXTENSION : StateFile::JSON_EXTENSION;
+    std::string filepath = std::string("states/") + ctx.stateName + extension;
 
     ImGui::PushStyleColor(ImGuiCol_Button,        ImVec4(0.10f, 0.50f, 0.15f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.15f, 0.70f, 0.20f, 1.f));
@@ -201,10 +246,7 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
             ctx.showOverwriteModal = true;
             strncpy(ctx.pendingFilepath, filepath.c_str(), 256);
         } else {
-            std::filesystem::create_directories("states");
             ctx.onSave(filepath);
-            ctx.showSavedToast = true;
-            ctx.toastTimer = 2.5f;
         }
     }
     ImGui::PopStyleColor(3);
@@ -214,6 +256,7 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
     ImGui::PushStyleColor(ImGuiCol_Button,        ImVec4(0.10f, 0.25f, 0.60f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.15f, 0.40f, 0.90f, 1.f));
     ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.05f, 0.15f, 0.45f, 1.f));
+    if (ctx.loading) ImGui::BeginDisabled();
     if (ImGui::Button("Load State", ImVec2(-1, 34))) {
         if (std::filesystem::exists(filepath))
             ctx.onLoad(filepath);
@@ -222,11 +265,66 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
             ctx.toastTimer = 2.5f;
         }
     }
+    if (ctx.loading) ImGui::EndDisabled();
     ImGui::PopStyleColor(3);
 
+    // The scene keeps running until the loaded one is swapped in
+    if (ctx.loading) {
+        ImGui::ProgressBar(ctx.loadProgress, ImVec2(-80, 0));
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(-1, 0)))
+            ctx.onCancelLoad();
+    }
+
+    ImGui::Spacing();
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.45f, 0.45f, 0.55f, 1.f));
+    ImGui::Text("Path: states/%s%s", ctx.stateName, extension);
+    ImGui::PopStyleColor();
+
+    // --- Rewind ---
+    ImGui::Spacing();
+    ImGui::SeparatorText("Rewind");
     ImGui::Spacing();
+
+    ImGui::Checkbox("Keep history", &ctx.rewindEnabled);
+    ImGui::SliderInt("Budget (MB)", &ctx.rewindBudgetMB, 8, 512);
+    ImGui::SliderInt("Snapshot every", &ctx.rewindInterval, 1, 60, "%d steps");
+
+    if (ctx.rewindEnabled && ctx.rewindNewest > ctx.rewindOldest) {
+        // Scrubbing pauses the simulation at the chosen step
+        int step = (int)ctx.currentStep;
+        ImGui::SetNextItemWidth(-1);
+        if (ImGui::SliderInt("##rewindStep", &step, (int)ctx.rewindOldest, (int)ctx.rewindNewest, "Step %d"))
+            ctx.onRewind((uint32_t)step);
+
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.45f, 0.45f, 0.55f, 1.f));
+        ImGui::Text("%zu snapshots, %.1f MB", ctx.rewindFrames, ctx.rewindBytes / (1024.f * 1024.f));
+        ImGui::PopStyleColor();
+    }
+
+    // --- Replay recording ---
+    ImGui::Spacing();
+    ImGui::SeparatorText("Replay");
+    ImGui::Spacing();
+
+    if (ctx.recording) {
+        ImGui::PushStyleColor(ImGuiCol_Button,        ImVec4(0.65f, 0.12f, 0.10f, 1.f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.90f, 0.20f, 0.15f, 1.f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.45f, 0.08f, 0.06f, 1.f));
+    } else {
+        ImGui::PushStyleColor(ImGuiCol_Button,        ImVec4(0.18f, 0.18f, 0.28f, 1.f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.28f, 0.28f, 0.45f, 1.f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.10f, 0.10f, 0.20f, 1.f));
+    }
+    if (ImGui::Button(ctx.recording ? "Stop Recording" : "Start Recording", ImVec2(-1, 30)))
+        ctx.onToggleRecording(std::string("states/") + ctx.stateName + ReplayFormat::EXTENSION);
+    ImGui::PopStyleColor(3);
+
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.45f, 0.45f, 0.55f, 1.f));
-    ImGui::Text("Path: states/%s.json", ctx.stateName);
+    if (ctx.recording)
+        ImGui::Text("Recording: %.1f KB written", ctx.recordedBytes / 1024.f);
+    else
+        ImGui::Text("Path: states/%s%s", ctx.stateName, ReplayFormat::EXTENSION);
     ImGui::PopStyleColor();
 
     // --- Overwrite modal ---
@@ -263,11 +361,8 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
         ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.90f, 0.20f, 0.15f, 1.f));
         ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.45f, 0.08f, 0.06f, 1.f));
         if (ImGui::Button("Overwrite", ImVec2(110, 34))) {
-            std::filesystem::create_directories("states");
             ctx.onSave(std::string(ctx.pendingFilepath));
             ctx.showOverwriteModal = false;
-            ctx.showSavedToast    = true;
-            ctx.toastTimer        = 2.5f;
             ImGui::CloseCurrentPopup();
         }
         ImGui::PopStyleColor(3);
@@ -284,15 +379,12 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
         ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.20f, 0.50f, 0.90f, 1.f));
         ImGui::PushStyleColor(ImGuiCol_ButtonActive,  ImVec4(0.05f, 0.25f, 0.50f, 1.f));
         if (ImGui::Button("Save As", ImVec2(-1, 34))) {
-            std::string newPath = "states/" + std::string(ctx.newSaveName) + ".json";
+            std::string newPath = "states/" + std::string(ctx.newSaveName) + extension;
             if (!std::filesystem::exists(newPath)) {
-                std::filesystem::create_directories("states");
                 ctx.onSave(newPath);
                 strncpy(ctx.stateName, ctx.newSaveName, 128);
                 memset(ctx.newSaveName, 0, 128);
                 ctx.showOverwriteModal = false;
-                ctx.showSavedToast    = true;
-                ctx.toastTimer        = 2.5f;
                 ImGui::CloseCurrentPopup();
             } else {
                 memset(ctx.newSaveName, 0, 128);
@@ -341,10 +433,10 @@ void GUI::Render([[maybe_unused]] GLFWwindow* window, SimContext& ctx) {
 
         if (isSuccess) {
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.3f, 1.f, 0.45f, 1.f));
-            ImGui::Text("State saved: %s.json", ctx.stateName);
+            ImGui::Text("State saved: %s%s", ctx.stateName, extension);
         } else {
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.f, 0.35f, 0.35f, 1.f));
-            ImGui::Text("File not found: %s.json", ctx.stateName);
+            ImGui::Text("Could not load: %s%s", ctx.stateName, extension);
         }
         ImGui::PopStyleColor();
         ImGui::End();
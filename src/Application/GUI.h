@@ -12,17 +12,39 @@
 
 #include "Physics/Body.h"
 #include "Physics/CollisionSolver.h"
+#include "Physics/World.h"
+#include "StateFile.h"
+#include "Replay.h"
 
-// All simulation state that the GUI reads or writes.
+// All simulation state that the GUI reads. Changes that affect the simulation
+// go through onCommand so they can be recorded for replay.
 struct SimContext {
     bool&   pause;
     bool&   showNormal;
     bool&   showCollisionPoint;
+    bool&   showAABB;
+    bool&   showBroadphase;
     bool&   attachPendulum;
     bool&   isRecentBodySelected;
     bool&   showSavedToast;
     bool&   showLoadFailToast;
     bool&   showOverwriteModal;
+    bool&   binaryState;
+    bool    loading;
+    float   loadProgress;
+    bool    recording;
+    size_t  recordedBytes;
+    bool&   deterministic;
+    int&    physicsThreads;
+    uint64_t stateHash;
+    bool&   rewindEnabled;
+    int&    rewindBudgetMB;
+    int&    rewindInterval;
+    uint32_t rewindOldest;
+    uint32_t rewindNewest;
+    uint32_t currentStep;
+    size_t  rewindBytes;
+    size_t  rewindFrames;
 
     float&  gravity;
     float&  restitution;
@@ -32,6 +54,9 @@ struct SimContext {
     float&  toastTimer;
 
     int&    maxIteration;
+    bool&   continuousCollision;
+    World::SolverType& solver;
+    int&    substeps;
 
     std::vector<Body*>&  bodies;
     Body*&               greatBall;
@@ -41,10 +66,12 @@ struct SimContext {
     char*   pendingFilepath; // char[256]
     char*   newSaveName;     // char[128]
 
-    std::function<void(const std::string&)> onSave;
-    std::function<void(const std::string&)> onLoad;
-    std::function<bool()>                   onClearAll;
-    std::function<bool(Body*)>              onDeleteBody;
+    std::function<void(const std::string&)> onSave;   // queued; the saved toast shows once written
+    std::function<void(const std::string&)> onLoad;   // runs on a worker; the scene swaps once it finished
+    std::function<void()>                   onCancelLoad;
+    std::function<void(const std::string&)> onToggleRecording;
+    std::function<void(const InputCommand&)> onCommand;
+    std::function<void(uint32_t)>           onRewind;
 };
 
 class GUI {
@@ -60,4 +87,5 @@ private:
     static float addBoxWidth;
     static float addBoxHeight;
     static float localRotation;
+    static int   outlinePreset;
 };
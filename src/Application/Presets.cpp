@@ -0,0 +1,28 @@
+#include "Presets.h"
+
+#include <cmath>
+
+std::vector<Vec2> PresetOutline(int preset, float size) {
+    const float h = size * 0.5f, t = size / 6.f;
+    switch (preset % OUTLINE_PRESETS) {
+        case 0: { // five-pointed star
+            std::vector<Vec2> points;
+            const float pi = 3.14159265f;
+            for (int i = 0; i < 10; i++) {
+                const float angle = -pi * 0.5f + pi * i / 5.f;
+                const float r = i % 2 == 0 ? h : h * 0.4f;
+                points.push_back(Vec2(cosf(angle) * r, sinf(angle) * r));
+            }
+            return points;
+        }
+        case 1: // cup, open at the top
+            return { Vec2(-h, -h), Vec2(-h + t, -h), Vec2(-h + t, h - t), Vec2(h - t, h - t),
+                     Vec2(h - t, -h), Vec2(h, -h), Vec2(h, h), Vec2(-h, h) };
+        case 2: // arrow pointing right
+            return { Vec2(-h, -t), Vec2(0.f, -t), Vec2(0.f, -h), Vec2(h, 0.f),
+                     Vec2(0.f, h), Vec2(0.f, t), Vec2(-h, t) };
+        default: // cross
+            return { Vec2(-t, -h), Vec2(t, -h), Vec2(t, -t), Vec2(h, -t), Vec2(h, t), Vec2(t, t),
+                     Vec2(t, h), Vec2(-t, h), Vec2(-t, t), Vec2(-h, t), Vec2(-h, -t), Vec2(-t, -t) };
+    }
+}
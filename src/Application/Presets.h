@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "Math/Vec2.h"
+#include "Physics/Constants.h"
+
+// Scene parameters the app and the benchmarks share, so a check measures
+// what a user gets
+
+// Hardest a drag may accelerate a body (px/s^2): ten times gravity, so
+// a body lifts at once, yet pushed into a floor it only presses on it
+constexpr float DRAG_MAX_ACCELERATION = 100.f * Constants::PIXELS_PER_METER;
+
+// Concave outlines the "+ Add Concave" button cycles through
+constexpr int OUTLINE_PRESETS = 4;
+
+// Preset outline fitting a size x size square about the origin; the
+// same preset and size always give bit-identical points, so repeat
+// spawns hit the decomposition cache
+std::vector<Vec2> PresetOutline(int preset, float size);
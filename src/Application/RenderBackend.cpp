@@ -0,0 +1,24 @@
+#include "RenderBackend.h"
+
+void NullRenderBackend::Init(int screenWidth, int screenHeight) {
+    width = screenWidth;
+    height = screenHeight;
+    frameCount = 0;
+    shapeCounts.fill(0);
+}
+
+void NullRenderBackend::Resize(int screenWidth, int screenHeight) {
+    width = screenWidth;
+    height = screenHeight;
+}
+
+void NullRenderBackend::Execute(const RenderCommandList& list) {
+    lastFrame = list;
+    for (const RenderCommand& cmd : list.Commands())
+        shapeCounts[static_cast<size_t>(cmd.shape)]++;
+    frameCount++;
+}
+
+void NullRenderBackend::Shutdown() {
+    lastFrame.Clear();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "RenderCommand.h"
+
+// Executes a sorted RenderCommandList. The GL backend draws it, the null
+// backend only records it, which lets frame building run without a GPU.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual void Init(int screenWidth, int screenHeight) = 0;
+    virtual void Resize(int screenWidth, int screenHeight) = 0;
+    virtual void Execute(const RenderCommandList& list) = 0;
+    virtual void Shutdown() = 0;
+};
+
+// Headless backend: keeps a copy of the last executed frame and running
+// per-shape counters for tests and benchmarks.
+class NullRenderBackend : public RenderBackend {
+public:
+    void Init(int screenWidth, int screenHeight) override;
+    void Resize(int screenWidth, int screenHeight) override;
+    void Execute(const RenderCommandList& list) override;
+    void Shutdown() override;
+
+    const RenderCommandList& LastFrame() const { return lastFrame; }
+    size_t FrameCount() const { return frameCount; }
+    size_t ShapeCount(RenderShape shape) const { return shapeCounts[static_cast<size_t>(shape)]; }
+
+private:
+    RenderCommandList lastFrame;
+    size_t frameCount = 0;
+    std::array<size_t, 4> shapeCounts {};
+    int width = 0, height = 0;
+};
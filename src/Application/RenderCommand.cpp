@@ -0,0 +1,76 @@
+#include "RenderCommand.h"
+
+#include <algorithm>
+
+void RenderCommandList::Clear() {
+    commands.clear();
+    points.clear();
+}
+
+void RenderCommandList::Reserve(size_t commandCount, size_t pointCount) {
+    commands.reserve(commandCount);
+    points.reserve(pointCount);
+}
+
+uint32_t RenderCommandList::PackColor(glm::vec3 color) {
+    auto channel = [](float v) -> uint32_t {
+        v = std::min(std::max(v, 0.0f), 1.0f);
+        return static_cast<uint32_t>(v * 255.0f + 0.5f);
+    };
+    return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) | (0xFFu << 24);
+}
+
+glm::vec3 RenderCommandList::UnpackColor(uint32_t color) {
+    return glm::vec3(
+        (color & 0xFF) / 255.0f,
+        ((color >> 8) & 0xFF) / 255.0f,
+        ((color >> 16) & 0xFF) / 255.0f);
+}
+
+RenderCommand& RenderCommandList::Push(RenderShape shape, RenderLayer layer, glm::vec3 color) {
+    RenderCommand cmd {};
+    cmd.shape   = shape;
+    cmd.layer   = layer;
+    cmd.sortKey = (static_cast<uint32_t>(layer) << 8) | static_cast<uint32_t>(shape);
+    cmd.color   = PackColor(color);
+    commands.push_back(cmd);
+    return commands.back();
+}
+
+void RenderCommandList::AddCircle(Vec2 pos, float radius, glm::vec3 color, RenderLayer layer) {
+    RenderCommand& cmd = Push(RenderShape::CIRCLE, layer, color);
+    cmd.x = pos.x;
+    cmd.y = pos.y;
+    cmd.scaleX = radius;
+    cmd.scaleY = radius;
+}
+
+void RenderCommandList::AddRectangle(Vec2 pos, float width, float height, float angleRadians, glm::vec3 color, RenderLayer layer) {
+    RenderCommand& cmd = Push(RenderShape::RECTANGLE, layer, color);
+    cmd.x = pos.x;
+    cmd.y = pos.y;
+    cmd.rotation = angleRadians;
+    cmd.scaleX = width;
+    cmd.scaleY = height;
+}
+
+void RenderCommandList::AddPolygon(const std::vector<Vec2>& pts, int count, glm::vec3 color, RenderLayer layer) {
+    if (count < 2) return;
+    RenderCommand& cmd = Push(RenderShape::POLYGON, layer, color);
+    cmd.firstPoint = static_cast<uint32_t>(points.size());
+    cmd.pointCount = static_cast<uint32_t>(count);
+    points.insert(points.end(), pts.begin(), pts.begin() + count);
+}
+
+void RenderCommandList::AddLine(Vec2 p1, Vec2 p2, glm::vec3 color, RenderLayer layer) {
+    RenderCommand& cmd = Push(RenderShape::LINE, layer, color);
+    cmd.firstPoint = static_cast<uint32_t>(points.size());
+    cmd.pointCount = 2;
+    points.push_back(p1);
+    points.push_back(p2);
+}
+
+void RenderCommandList::Sort() {
+    std::stable_sort(commands.begin(), commands.end(),
+        [](const RenderCommand& a, const RenderCommand& b) { return a.sortKey < b.sortKey; });
+}
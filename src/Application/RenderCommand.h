@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "Math/Vec2.h"
+
+// Primitive kinds understood by every backend. Outline kinds (POLYGON, LINE)
+// sort last so a backend can stream them in one batch.
+enum class RenderShape : uint8_t {
+    CIRCLE,
+    RECTANGLE,
+    POLYGON,
+    LINE
+};
+
+// Coarse draw order. Commands are sorted by layer first, then by shape.
+enum RenderLayer : uint8_t {
+    LAYER_WORLD     = 0,
+    LAYER_HIGHLIGHT = 1,
+    LAYER_DEBUG     = 2
+};
+
+struct RenderCommand {
+    uint32_t    sortKey;
+    RenderShape shape;
+    RenderLayer layer;
+
+    // Transform: translation, rotation (radians) and per-axis scale.
+    // Circles use scaleX as radius, rectangles use scaleX/scaleY as size.
+    float x, y;
+    float rotation;
+    float scaleX, scaleY;
+
+    // Packed RGBA8
+    uint32_t color;
+
+    // POLYGON / LINE: range inside RenderCommandList::Points()
+    uint32_t firstPoint;
+    uint32_t pointCount;
+};
+
+// Compact per-frame list of draw commands. Recording never touches a
+// graphics API; a RenderBackend executes the sorted list afterwards.
+class RenderCommandList {
+public:
+    void Clear();
+    void Reserve(size_t commandCount, size_t pointCount);
+
+    void AddCircle(Vec2 pos, float radius, glm::vec3 color, RenderLayer layer);
+    void AddRectangle(Vec2 pos, float width, float height, float angleRadians, glm::vec3 color, RenderLayer layer);
+    void AddPolygon(const std::vector<Vec2>& points, int count, glm::vec3 color, RenderLayer layer);
+    void AddLine(Vec2 p1, Vec2 p2, glm::vec3 color, RenderLayer layer);
+
+    // Group commands by layer, then by shape, keeping submission order otherwise
+    void Sort();
+
+    const std::vector<RenderCommand>& Commands() const { return commands; }
+    const std::vector<Vec2>&          Points() const   { return points; }
+    size_t Size() const { return commands.size(); }
+
+    static uint32_t PackColor(glm::vec3 color);
+    static glm::vec3 UnpackColor(uint32_t color);
+
+private:
+    RenderCommand& Push(RenderShape shape, RenderLayer layer, glm::vec3 color);
+
+    std::vector<RenderCommand> commands;
+    std::vector<Vec2>          points;
+};
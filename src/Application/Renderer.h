@@ -1,53 +1,45 @@
 #pragma once
 
-#include "../glad/glad.h"
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <memory>
 #include <vector>
 
 #include "Math/Vec2.h"
-#include "Physics/Body.h"
-#include "Physics/Constants.h"
+#include "RenderCommand.h"
+#include "RenderBackend.h"
+#include "Physics/DebugDraw.h"
 
 class Renderer {
 public:
-    // Initialize the renderer with the window size
-    static void InitRenderer(int screenWidth, int screenHeight);
+    // Initialize the renderer with the window size. Without an explicit
+    // backend the OpenGL one is used; pass a NullRenderBackend to run headless.
+    static void InitRenderer(int screenWidth, int screenHeight, std::unique_ptr<RenderBackend> backend = nullptr);
     
     // Update the projection matrix if window size changes
     static void UpdateProjection(int screenWidth, int screenHeight);
     
-    // Clean up OpenGL resources
+    // Clean up backend resources
     static void CleanupRenderer();
 
-    // Drawing functions
-    static void DrawCircle(Vec2 pos, float radius, glm::vec3 color);
-    static void DrawRectangle(Vec2 pos, float width, float height, glm::vec3 color, float angleRadians);
-    static void DrawPolygon(const std::vector<Vec2>& points, int count, glm::vec3 color);
-    static void DrawLine(Vec2 p1, Vec2 p2, glm::vec3 color);
+    // Frame bracket: BeginFrame clears the command list, EndFrame sorts it
+    // and hands it to the backend
+    static void BeginFrame();
+    static void EndFrame();
+
+    // Drawing functions (recorded, executed at EndFrame)
+    static void DrawCircle(Vec2 pos, float radius, glm::vec3 color, RenderLayer layer = LAYER_WORLD);
+    static void DrawRectangle(Vec2 pos, float width, float height, glm::vec3 color, float angleRadians, RenderLayer layer = LAYER_WORLD);
+    static void DrawPolygon(const std::vector<Vec2>& points, int count, glm::vec3 color, RenderLayer layer = LAYER_WORLD);
+    static void DrawLine(Vec2 p1, Vec2 p2, glm::vec3 color, RenderLayer layer = LAYER_WORLD);
     static void DrawRect(int x, int y, int width, int height, glm::vec3 color); 
 
+    // Record everything the physics step wrote into the debug sink
+    static void DrawDebug(const DebugDraw& debugDraw);
+
+    static const RenderCommandList& GetCommandList();
+    static RenderBackend* GetBackend();
+
 private:
-    // Shader and buffer objects
-    static GLuint shaderProgram;
-    static GLuint circleVAO, circleVBO;
-    static GLuint rectVAO, rectVBO;
-    static const float rectVertices[8];
-    
-    // Shader sources
-    static const char* vertexShaderSource;
-    static const char* fragmentShaderSource;
-    
-    // Projection matrix
-    static glm::mat4 projection;
-    static glm::vec3 color;
-    
-    // Private utility functions
-    static std::vector<float> generateCircleOutline(int segments);
-    static GLuint compileShaderProgram();
-};
\ No newline at end of file
+    static RenderCommandList commands;
+    static std::unique_ptr<RenderBackend> backend;
+};
@@ -0,0 +1,249 @@
+#include "Replay.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "StateFile.h"
+
+namespace {
+    constexpr char   MAGIC[4] = { 'R', 'B', 'R', 'L' };
+    constexpr size_t SUBMIT_THRESHOLD = 64 * 1024;
+}
+
+// === InputCommand factories ===
+InputCommand InputCommand::Step(float dt, bool dragging, Vec2 dragTarget) {
+    InputCommand cmd {};
+    cmd.type = InputType::STEP;
+    cmd.button = dragging ? 1 : 0;
+    cmd.x = dragTarget.x;
+    cmd.y = dragTarget.y;
+    cmd.a = dt;
+    return cmd;
+}
+
+InputCommand InputCommand::MousePress(int button, int mods, float x, float y, int polygonSides) {
+    InputCommand cmd {};
+    cmd.type = InputType::MOUSE_PRESS;
+    cmd.button = static_cast<uint8_t>(button);
+    cmd.mods = static_cast<uint8_t>(mods);
+    cmd.value = polygonSides;
+    cmd.x = x;
+    cmd.y = y;
+    return cmd;
+}
+
+InputCommand InputCommand::MouseRelease(int button) {
+    InputCommand cmd {};
+    cmd.type = InputType::MOUSE_RELEASE;
+    cmd.button = static_cast<uint8_t>(button);
+    return cmd;
+}
+
+InputCommand InputCommand::AddBox(float width, float height, float rotation) {
+    InputCommand cmd {};
+    cmd.type = InputType::ADD_BOX;
+    cmd.a = width;
+    cmd.b = height;
+    cmd.c = rotation;
+    return cmd;
+}
+
+InputCommand InputCommand::AddCapsule(float width, float height, float rotation) {
+    InputCommand cmd {};
+    cmd.type = InputType::ADD_CAPSULE;
+    cmd.a = width;
+    cmd.b = height;
+    cmd.c = rotation;
+    return cmd;
+}
+
+InputCommand InputCommand::AddLShape(float width, float height, float rotation) {
+    InputCommand cmd {};
+    cmd.type = InputType::ADD_L_SHAPE;
+    cmd.a = width;
+    cmd.b = height;
+    cmd.c = rotation;
+    return cmd;
+}
+
+InputCommand InputCommand::AddOutline(int preset, float size, float rotation) {
+    InputCommand cmd {};
+    cmd.type = InputType::ADD_OUTLINE;
+    cmd.value = preset;
+    cmd.a = size;
+    cmd.c = rotation;
+    return cmd;
+}
+
+InputCommand InputCommand::DeleteSelected() {
+    InputCommand cmd {};
+    cmd.type = InputType::DELETE_SELECTED;
+    return cmd;
+}
+
+InputCommand InputCommand::ClearDynamic() {
+    InputCommand cmd {};
+    cmd.type = InputType::CLEAR_DYNAMIC;
+    return cmd;
+}
+
+InputCommand InputCommand::SetParam(InputParam param, float value) {
+    InputCommand cmd {};
+    cmd.type = InputType::SET_PARAM;
+    cmd.param = param;
+    cmd.a = value;
+    return cmd;
+}
+
+InputCommand InputCommand::Cull(float screenWidth, float screenHeight) {
+    InputCommand cmd {};
+    cmd.type = InputType::CULL;
+    cmd.x = screenWidth;
+    cmd.y = screenHeight;
+    return cmd;
+}
+
+// === ReplayRecorder ===
+ReplayRecorder::~ReplayRecorder() {
+    Stop();
+}
+
+bool ReplayRecorder::Start(const std::string& path) {
+    Stop();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    uint32_t version = ReplayFormat::VERSION;
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    std::fwrite(&version, sizeof(version), 1, file);
+
+    commands.clear();
+    staging.clear();
+    pending.clear();
+    stopRequested = false;
+    bytesWritten = sizeof(MAGIC) + sizeof(version);
+    framesSinceKeyframe = 0;
+    recording = true;
+
+    writer = std::thread(&ReplayRecorder::WriterLoop, this);
+    return true;
+}
+
+void ReplayRecorder::Stop() {
+    if (!recording) return;
+
+    FlushCommands();
+    Submit(true);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    std::fclose(file);
+    file = nullptr;
+    recording = false;
+}
+
+void ReplayRecorder::AppendChunk(uint32_t tag, const void* payload, size_t size) {
+    uint32_t header[2] = { tag, static_cast<uint32_t>(size) };
+    size_t base = staging.size();
+    staging.resize(base + sizeof(header) + size);
+    std::memcpy(staging.data() + base, header, sizeof(header));
+    if (size) std::memcpy(staging.data() + base + sizeof(header), payload, size);
+}
+
+void ReplayRecorder::FlushCommands() {
+    if (commands.empty()) return;
+    AppendChunk(ReplayFormat::TAG_CMDS, commands.data(), commands.size() * sizeof(InputCommand));
+    commands.clear();
+}
+
+void ReplayRecorder::Keyframe(const ReplayKeyframe& keyframe, const SnapshotView& snapshot) {
+    if (!recording) return;
+
+    // Commands recorded so far happened before this keyframe
+    FlushCommands();
+
+    std::vector<unsigned char> payload(sizeof(ReplayKeyframe));
+    std::memcpy(payload.data(), &keyframe, sizeof(ReplayKeyframe));
+    StateFile::Serialize(snapshot, payload);
+    AppendChunk(ReplayFormat::TAG_KEYF, payload.data(), payload.size());
+
+    framesSinceKeyframe = 0;
+    Submit(true);
+}
+
+void ReplayRecorder::EndFrame() {
+    if (!recording) return;
+    framesSinceKeyframe++;
+    FlushCommands();
+    Submit(false);
+}
+
+void ReplayRecorder::Submit(bool force) {
+    if (staging.empty() || (!force && staging.size() < SUBMIT_THRESHOLD)) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty()) pending.swap(staging);
+        else pending.insert(pending.end(), staging.begin(), staging.end());
+    }
+    staging.clear();
+    wake.notify_one();
+}
+
+void ReplayRecorder::WriterLoop() {
+    std::vector<unsigned char> local;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopRequested || !pending.empty(); });
+            if (pending.empty() && stopRequested) return;
+            local.swap(pending);
+        }
+
+        std::fwrite(local.data(), 1, local.size(), file);
+        std::fflush(file);
+        bytesWritten += local.size();
+        local.clear();
+    }
+}
+
+// === ReplayReader ===
+bool ReplayReader::Open(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+
+    std::streamsize size = in.tellg();
+    if (size < 8) return false;
+    in.seekg(0);
+
+    buffer.resize(static_cast<size_t>(size));
+    if (!in.read(reinterpret_cast<char*>(buffer.data()), size)) return false;
+
+    uint32_t version;
+    std::memcpy(&version, buffer.data() + sizeof(MAGIC), sizeof(version));
+    if (std::memcmp(buffer.data(), MAGIC, sizeof(MAGIC)) != 0 || version != ReplayFormat::VERSION)
+        return false;
+
+    cursor = 8;
+    return true;
+}
+
+bool ReplayReader::Next(Chunk& chunk) {
+    if (cursor + 8 > buffer.size()) return false;
+
+    uint32_t header[2];
+    std::memcpy(header, buffer.data() + cursor, sizeof(header));
+    if (cursor + 8 + header[1] > buffer.size()) return false; // truncated tail
+
+    chunk.tag  = header[0];
+    chunk.data = buffer.data() + cursor + 8;
+    chunk.size = header[1];
+    cursor += 8 + header[1];
+    return true;
+}
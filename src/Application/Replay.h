@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Math/Vec2.h"
+#include "Physics/Snapshot.h"
+
+// Every scene-mutating input goes through one InputCommand, so live input
+// and replay playback share a single code path (Application::Apply).
+enum class InputType : uint8_t {
+    STEP,            // advance the simulation: a = dt, x/y = cursor the dragged body is pulled to if button != 0
+    MOUSE_PRESS,     // button, mods, x/y = framebuffer cursor, value = polygon sides
+    MOUSE_RELEASE,   // button
+    ADD_BOX,         // a = width, b = height, c = rotation
+    DELETE_SELECTED,
+    CLEAR_DYNAMIC,
+    SET_PARAM,       // param, a = value
+    CULL,            // x/y = screen size used to cull off-screen bodies
+    ADD_CAPSULE,     // a = width, b = height, c = rotation
+    ADD_L_SHAPE,     // a = width, b = height, c = rotation
+    ADD_OUTLINE      // value = preset, a = size, c = rotation
+};
+
+enum class InputParam : uint8_t {
+    GRAVITY,
+    RESTITUTION,
+    FRICTION,
+    MAX_ITERATION,
+    CORRECTION,
+    GREAT_BALL_RADIUS,
+    PENDULUM,
+    PAUSE,
+    BODY_ROTATION,   // applied to the selected body
+    BODY_WIDTH,
+    BODY_HEIGHT,
+    CONTINUOUS,      // a != 0 sweeps fast bodies to their first impact
+    SOLVER,          // a = World::SolverType
+    SUBSTEPS
+};
+
+struct InputCommand {
+    InputType  type;
+    InputParam param;
+    uint8_t    button;
+    uint8_t    mods;
+    int32_t    value;
+    float      x, y;
+    float      a, b, c;
+
+    static InputCommand Step(float dt, bool dragging, Vec2 dragTarget);
+    static InputCommand MousePress(int button, int mods, float x, float y, int polygonSides);
+    static InputCommand MouseRelease(int button);
+    static InputCommand AddBox(float width, float height, float rotation);
+    static InputCommand AddCapsule(float width, float height, float rotation);
+    static InputCommand AddLShape(float width, float height, float rotation);
+    static InputCommand AddOutline(int preset, float size, float rotation);
+    static InputCommand DeleteSelected();
+    static InputCommand ClearDynamic();
+    static InputCommand SetParam(InputParam param, float value);
+    static InputCommand Cull(float screenWidth, float screenHeight);
+};
+
+static_assert(sizeof(InputCommand) == 28, "InputCommand layout is part of the replay format");
+
+// Application state a keyframe needs on top of the scene snapshot
+struct ReplayKeyframe {
+    uint32_t frame;
+    uint32_t flags;            // REPLAY_KEYFRAME_*
+    int32_t  greatBall;        // body indices, -1 for none
+    int32_t  selectedBody;
+    int32_t  draggedBody;
+    float    dragOffsetX, dragOffsetY;
+    float    correction;
+    float    pendulumLength;   // the pendulum joint, which snapshots leave out; 0 without one
+    float    pendulumImpulse;
+    float    mouseTargetX, mouseTargetY;   // the mouse joint, which snapshots leave out too;
+    float    mouseImpulseX, mouseImpulseY; // set with REPLAY_KEYFRAME_MOUSE_JOINT
+    uint32_t stateHash;        // low 32 bits of World::StateHash
+};
+
+enum ReplayKeyframeFlags : uint32_t {
+    REPLAY_KEYFRAME_RESET       = 1u << 0, // scene was replaced (load), restore instead of verify
+    REPLAY_KEYFRAME_SELECTED    = 1u << 1, // isRecentBodySelected
+    REPLAY_KEYFRAME_MOUSE_JOINT = 1u << 2  // draggedBody is pulled by the mouse joint
+};
+
+static_assert(sizeof(ReplayKeyframe) == 60, "ReplayKeyframe layout is part of the replay format");
+
+// Replay log (.rbr): an 8-byte file header followed by chunks of
+// { uint32 tag, uint32 size, payload }. CMDS chunks hold InputCommand
+// arrays, KEYF chunks hold a ReplayKeyframe followed by a binary snapshot.
+namespace ReplayFormat {
+    constexpr uint32_t VERSION   = 3;
+    constexpr uint32_t TAG_CMDS  = 0x53444D43; // "CMDS"
+    constexpr uint32_t TAG_KEYF  = 0x4659454B; // "KEYF"
+    constexpr const char* EXTENSION = ".rbr";
+}
+
+// Records commands into memory and streams them to disk on a worker thread.
+// The calling thread only appends to a vector; file I/O never blocks a frame.
+class ReplayRecorder {
+public:
+    ReplayRecorder() = default;
+    ~ReplayRecorder();
+    ReplayRecorder(const ReplayRecorder&) = delete;
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+    bool Start(const std::string& path);
+    void Stop();
+    bool IsRecording() const { return recording; }
+
+    void Record(const InputCommand& command) { if (recording) commands.push_back(command); }
+    void Keyframe(const ReplayKeyframe& keyframe, const SnapshotView& snapshot);
+
+    // Close the current command chunk, hand it over once enough has accumulated
+    void EndFrame();
+
+    uint32_t FramesSinceKeyframe() const { return framesSinceKeyframe; }
+    size_t   BytesWritten() const { return bytesWritten; }
+
+private:
+    void AppendChunk(uint32_t tag, const void* payload, size_t size);
+    void FlushCommands();
+    void Submit(bool force);
+    void WriterLoop();
+
+    bool recording = false;
+    uint32_t framesSinceKeyframe = 0;
+
+    std::vector<InputCommand>  commands;  // current frame(s), not yet chunked
+    std::vector<unsigned char> staging;   // chunks owned by the calling thread
+
+    // Shared with the writer thread
+    std::mutex                 mutex;
+    std::condition_variable    wake;
+    std::vector<unsigned char> pending;
+    bool                       stopRequested = false;
+    std::atomic<size_t>        bytesWritten { 0 };
+
+    std::thread writer;
+    FILE* file = nullptr;
+};
+
+// Reads a replay log chunk by chunk
+class ReplayReader {
+public:
+    struct Chunk {
+        uint32_t tag;
+        const unsigned char* data;
+        size_t size;
+    };
+
+    bool Open(const std::string& path);
+    bool Next(Chunk& chunk);
+
+private:
+    std::vector<unsigned char> buffer;
+    size_t cursor = 0;
+};
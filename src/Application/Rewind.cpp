@@ -0,0 +1,186 @@
+#include "Rewind.h"
+
+#include <cstring>
+
+namespace {
+    constexpr size_t WORDS_PER_BODY   = sizeof(BodyRecord) / sizeof(uint32_t);
+    constexpr size_t WORDS_PER_FILTER = sizeof(FilterRecord) / sizeof(uint32_t);
+
+    // Runs of { unchanged count, changed count, changed words... }
+    void EncodeDelta(const uint32_t* current, const uint32_t* base, size_t count, std::vector<uint32_t>& out) {
+        size_t i = 0;
+        while (i < count) {
+            size_t same = i;
+            while (i < count && current[i] == base[i]) i++;
+            size_t changed = i;
+            while (i < count && current[i] != base[i]) i++;
+
+            out.push_back(static_cast<uint32_t>(changed - same));
+            out.push_back(static_cast<uint32_t>(i - changed));
+            out.insert(out.end(), current + changed, current + i);
+        }
+    }
+
+    void DecodeDelta(const std::vector<uint32_t>& runs, const uint32_t* base, size_t count, uint32_t* out) {
+        std::memcpy(out, base, count * sizeof(uint32_t));
+        size_t position = 0;
+        for (size_t r = 0; r + 1 < runs.size();) {
+            position += runs[r];
+            uint32_t changed = runs[r + 1];
+            std::memcpy(out + position, runs.data() + r + 2, changed * sizeof(uint32_t));
+            position += changed;
+            r += 2 + changed;
+        }
+    }
+
+    template <typename Record>
+    bool SameRecords(const std::vector<Record>& a, const std::vector<Record>& b) {
+        return a.size() == b.size() &&
+               (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(Record)) == 0);
+    }
+}
+
+size_t RewindBuffer::Frame::Bytes() const {
+    return sizeof(Frame) +
+           shapes.capacity() * sizeof(ShapeRecord) +
+           points.capacity() * sizeof(PointRecord) +
+           parts.capacity() * sizeof(PartRecord) +
+           words.capacity() * sizeof(uint32_t) +
+           commands.capacity() * sizeof(InputCommand);
+}
+
+void RewindBuffer::Clear() {
+    frames.clear();
+    bytesUsed = 0;
+    newestStep = 0;
+    sinceFull = 0;
+}
+
+const RewindBuffer::Frame* RewindBuffer::BaseOf(size_t index) const {
+    for (size_t i = index + 1; i-- > 0;)
+        if (!frames[i].delta) return &frames[i];
+    return nullptr;
+}
+
+void RewindBuffer::Capture(uint32_t step, const ReplayKeyframe& state, const SceneSnapshot& snapshot) {
+    // Close the previous frame's input list before it is measured
+    if (!frames.empty()) {
+        frames.back().commands.shrink_to_fit();
+        bytesUsed += frames.back().commands.capacity() * sizeof(InputCommand);
+    }
+
+    Frame frame;
+    frame.step      = step;
+    frame.state     = state;
+    frame.settings  = snapshot.settings;
+    frame.shapes    = snapshot.shapes;
+    frame.points    = snapshot.points;
+    frame.parts     = snapshot.parts;
+    frame.bodyCount   = static_cast<uint32_t>(snapshot.bodies.size());
+    frame.filterCount = static_cast<uint32_t>(snapshot.filters.size());
+
+    const uint32_t* current = reinterpret_cast<const uint32_t*>(snapshot.bodies.data());
+    const size_t    count   = snapshot.bodies.size() * WORDS_PER_BODY;
+    const uint32_t* filters = reinterpret_cast<const uint32_t*>(snapshot.filters.data());
+    const size_t    filterWords = snapshot.filters.size() * WORDS_PER_FILTER;
+
+    // A delta needs a base with the same body list, filter table and shape table
+    const Frame* base = frames.empty() ? nullptr : BaseOf(frames.size() - 1);
+    frame.delta = base && sinceFull + 1 < fullInterval &&
+                  base->bodyCount == frame.bodyCount && base->filterCount == frame.filterCount &&
+                  SameRecords(base->shapes, frame.shapes) &&
+                  SameRecords(base->points, frame.points) && SameRecords(base->parts, frame.parts);
+
+    if (frame.delta) {
+        // The filters' runs carry on from where the bodies' end
+        EncodeDelta(current, base->words.data(), count, frame.words);
+        EncodeDelta(filters, base->words.data() + count, filterWords, frame.words);
+        frame.words.shrink_to_fit();
+        sinceFull++;
+    } else {
+        frame.words.assign(current, current + count);
+        frame.words.insert(frame.words.end(), filters, filters + filterWords);
+        sinceFull = 0;
+    }
+
+    bytesUsed += sizeof(Frame) + frame.shapes.capacity() * sizeof(ShapeRecord) +
+                 frame.points.capacity() * sizeof(PointRecord) + frame.parts.capacity() * sizeof(PartRecord) +
+                 frame.words.capacity() * sizeof(uint32_t);
+    frames.push_back(std::move(frame));
+    newestStep = step;
+
+    Evict();
+}
+
+void RewindBuffer::Record(const InputCommand& command) {
+    if (frames.empty()) return;
+    frames.back().commands.push_back(command);
+    if (command.type == InputType::STEP) newestStep++;
+}
+
+const RewindBuffer::Frame* RewindBuffer::Seek(uint32_t step, SceneSnapshot& out) const {
+    if (frames.empty() || step < frames.front().step || step > newestStep) return nullptr;
+
+    size_t index = frames.size() - 1;
+    while (frames[index].step > step) index--;
+
+    const Frame& frame = frames[index];
+    out.settings = frame.settings;
+    out.shapes   = frame.shapes;
+    out.points   = frame.points;
+    out.parts    = frame.parts;
+    out.bodies.resize(frame.bodyCount);
+    out.filters.resize(frame.filterCount);
+
+    const size_t count = frame.bodyCount * WORDS_PER_BODY;
+    const size_t total = count + frame.filterCount * WORDS_PER_FILTER;
+    std::vector<uint32_t> decoded;
+    const uint32_t* words = frame.words.data();
+    if (frame.delta) {
+        decoded.resize(total);
+        DecodeDelta(frame.words, BaseOf(index)->words.data(), total, decoded.data());
+        words = decoded.data();
+    }
+    if (count)
+        std::memcpy(out.bodies.data(), words, count * sizeof(uint32_t));
+    if (total > count)
+        std::memcpy(out.filters.data(), words + count, (total - count) * sizeof(uint32_t));
+
+    return &frame;
+}
+
+void RewindBuffer::TruncateAfter(const Frame* frame, size_t commandCount) {
+    size_t index = 0;
+    while (index < frames.size() && &frames[index] != frame) index++;
+    if (index == frames.size()) return;
+
+    frames.erase(frames.begin() + index + 1, frames.end());
+    Frame& last = frames.back();
+    last.commands.resize(commandCount);
+
+    newestStep = last.step;
+    for (const InputCommand& command : last.commands)
+        if (command.type == InputType::STEP) newestStep++;
+
+    sinceFull = 0;
+    for (size_t i = frames.size(); i-- > 0 && frames[i].delta;) sinceFull++;
+
+    bytesUsed = 0;
+    for (const Frame& f : frames) bytesUsed += f.Bytes();
+}
+
+void RewindBuffer::Evict() {
+    // Keep the newest frame even if it alone is over budget. If the budget
+    // cannot hold one full snapshot and its deltas, the history empties and
+    // restarts with the next full snapshot.
+    while (bytesUsed > budgetBytes && frames.size() > 1) {
+        bytesUsed -= frames.front().Bytes();
+        frames.pop_front();
+
+        // Deltas cannot outlive their full snapshot
+        while (!frames.empty() && frames.front().delta) {
+            bytesUsed -= frames.front().Bytes();
+            frames.pop_front();
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "Physics/Snapshot.h"
+#include "Replay.h"
+
+// In-memory history of the last stretch of simulation, for scrubbing back.
+//
+// Every `interval` steps a snapshot of the scene is stored together with the
+// inputs executed after it, so any step in range is rebuilt exactly by
+// restoring the nearest earlier snapshot and re-applying those inputs.
+//
+// Snapshots are either full (the raw BodyRecords, then the FilterRecords if
+// the scene has any) or deltas against the last full one: only the 32-bit
+// words that changed are kept, as runs. Mass, material, shape and filter
+// fields rarely change, and resting bodies not at all, so deltas are a
+// fraction of a full snapshot. The oldest snapshots are
+// dropped to stay inside budgetBytes.
+class RewindBuffer {
+public:
+    struct Frame {
+        uint32_t                  step;       // snapshot taken right after this step
+        ReplayKeyframe            state;      // interaction state, as in a replay keyframe
+        SnapshotSettings          settings;
+        std::vector<ShapeRecord>  shapes;
+        std::vector<PointRecord>  points;     // chain points of the shape table
+        std::vector<PartRecord>   parts;      // compound parts of the shape table
+        uint32_t                  bodyCount;
+        uint32_t                  filterCount; // 0 or bodyCount
+        bool                      delta;
+        std::vector<uint32_t>     words;      // raw Body- then FilterRecords, or runs of changed words
+        std::vector<InputCommand> commands;   // executed after the snapshot
+
+        size_t Bytes() const;
+    };
+
+    size_t   budgetBytes  = 64u * 1024u * 1024u;
+    uint32_t interval     = 10; // steps between snapshots
+    uint32_t fullInterval = 8;  // every Nth snapshot is stored in full
+
+    void Clear();
+    bool Empty() const { return frames.empty(); }
+
+    uint32_t OldestStep() const { return frames.empty() ? 0 : frames.front().step; }
+    uint32_t NewestStep() const { return newestStep; }
+    size_t   BytesUsed() const { return bytesUsed; }
+    size_t   FrameCount() const { return frames.size(); }
+
+    void Capture(uint32_t step, const ReplayKeyframe& state, const SceneSnapshot& snapshot);
+
+    // Append an input executed after the newest snapshot
+    void Record(const InputCommand& command);
+
+    // Decode the nearest snapshot at or before step into out. The caller then
+    // re-applies the frame's commands up to step. nullptr if step is out of range.
+    const Frame* Seek(uint32_t step, SceneSnapshot& out) const;
+
+    // Forget everything after the first commandCount inputs of frame, once
+    // the simulation moves on from a rewound position
+    void TruncateAfter(const Frame* frame, size_t commandCount);
+
+private:
+    const Frame* BaseOf(size_t index) const;
+    void Evict();
+
+    std::deque<Frame> frames;
+    size_t   bytesUsed = 0;
+    uint32_t newestStep = 0;
+    uint32_t sinceFull = 0;
+};
@@ -0,0 +1,705 @@
+#include "StateFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+
+#include "../../utils/json.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// === MappedFile ===
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const unsigned char*>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    data = nullptr;
+    size = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+#else
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+
+    data = static_cast<const unsigned char*>(view);
+    size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data) munmap(const_cast<unsigned char*>(data), size);
+    data = nullptr;
+    size = 0;
+}
+#endif
+
+// === Binary state format ===
+namespace {
+    constexpr char     MAGIC[4]   = { 'R', 'B', 'S', 'S' };
+    constexpr uint32_t ENDIAN_TAG = 0x01020304;
+    // Header sizes of older versions, which lack the tables after them
+    constexpr uint32_t HEADER_SIZE_V1 = offsetof(StateFileHeader, pointCount);
+    constexpr uint32_t HEADER_SIZE_V2 = offsetof(StateFileHeader, partCount);
+    constexpr uint32_t HEADER_SIZE_V3 = offsetof(StateFileHeader, filterCount);
+
+    // 0 for versions this build can't read
+    uint32_t HeaderSize(uint32_t version) {
+        switch (version) {
+            case 1:                  return HEADER_SIZE_V1;
+            case 2:                  return HEADER_SIZE_V2;
+            case 3:                  return HEADER_SIZE_V3;
+            case StateFile::VERSION: return sizeof(StateFileHeader);
+            default:                 return 0;
+        }
+    }
+
+    // Whether count records starting at offset lie within size bytes; both
+    // come from the file, so no sum is formed that could wrap around
+    bool TableFits(uint64_t offset, uint64_t count, uint64_t recordSize, uint64_t size) {
+        return offset <= size && count <= (size - offset) / recordSize;
+    }
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    StateFileHeader MakeHeader(const SnapshotView& snapshot) {
+        StateFileHeader header {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version      = StateFile::VERSION;
+        header.headerSize   = sizeof(StateFileHeader);
+        header.endianTag    = ENDIAN_TAG;
+        header.settings     = snapshot.settings;
+        header.shapeCount   = static_cast<uint32_t>(snapshot.shapeCount);
+        header.bodyCount    = static_cast<uint32_t>(snapshot.bodyCount);
+        header.pointCount   = static_cast<uint32_t>(snapshot.pointCount);
+        header.partCount    = static_cast<uint32_t>(snapshot.partCount);
+        header.filterCount  = static_cast<uint32_t>(snapshot.filterCount);
+        header.shapeOffset  = sizeof(StateFileHeader);
+        header.pointOffset  = AlignUp(header.shapeOffset + snapshot.shapeCount * sizeof(ShapeRecord), alignof(PointRecord));
+        header.partOffset   = AlignUp(header.pointOffset + snapshot.pointCount * sizeof(PointRecord), alignof(PartRecord));
+        header.filterOffset = AlignUp(header.partOffset + snapshot.partCount * sizeof(PartRecord), alignof(FilterRecord));
+        header.bodyOffset   = AlignUp(header.filterOffset + snapshot.filterCount * sizeof(FilterRecord), 16);
+        return header;
+    }
+}
+
+bool StateFile::IsBinaryPath(const std::string& path) {
+    return std::filesystem::path(path).extension() == BINARY_EXTENSION;
+}
+
+void StateFile::Serialize(const SnapshotView& snapshot, std::vector<unsigned char>& out) {
+    StateFileHeader header = MakeHeader(snapshot);
+
+    size_t base = out.size();
+    out.resize(base + header.bodyOffset + snapshot.bodyCount * sizeof(BodyRecord), 0);
+
+    unsigned char* dst = out.data() + base;
+    std::memcpy(dst, &header, sizeof(header));
+    if (snapshot.shapeCount)
+        std::memcpy(dst + header.shapeOffset, snapshot.shapes, snapshot.shapeCount * sizeof(ShapeRecord));
+    if (snapshot.pointCount)
+        std::memcpy(dst + header.pointOffset, snapshot.points, snapshot.pointCount * sizeof(PointRecord));
+    if (snapshot.partCount)
+        std::memcpy(dst + header.partOffset, snapshot.parts, snapshot.partCount * sizeof(PartRecord));
+    if (snapshot.filterCount)
+        std::memcpy(dst + header.filterOffset, snapshot.filters, snapshot.filterCount * sizeof(FilterRecord));
+    if (snapshot.bodyCount)
+        std::memcpy(dst + header.bodyOffset, snapshot.bodies, snapshot.bodyCount * sizeof(BodyRecord));
+}
+
+bool StateFile::WriteBinary(const std::string& path, const SnapshotView& snapshot) {
+    StateFileHeader header = MakeHeader(snapshot);
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    static const unsigned char padding[16] = {};
+    size_t shapePad  = header.pointOffset - (header.shapeOffset + snapshot.shapeCount * sizeof(ShapeRecord));
+    size_t pointPad  = header.partOffset - (header.pointOffset + snapshot.pointCount * sizeof(PointRecord));
+    size_t partPad   = header.filterOffset - (header.partOffset + snapshot.partCount * sizeof(PartRecord));
+    size_t filterPad = header.bodyOffset - (header.filterOffset + snapshot.filterCount * sizeof(FilterRecord));
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && snapshot.shapeCount)
+        ok = std::fwrite(snapshot.shapes, sizeof(ShapeRecord), snapshot.shapeCount, file) == snapshot.shapeCount;
+    if (ok && shapePad)
+        ok = std::fwrite(padding, 1, shapePad, file) == shapePad;
+    if (ok && snapshot.pointCount)
+        ok = std::fwrite(snapshot.points, sizeof(PointRecord), snapshot.pointCount, file) == snapshot.pointCount;
+    if (ok && pointPad)
+        ok = std::fwrite(padding, 1, pointPad, file) == pointPad;
+    if (ok && snapshot.partCount)
+        ok = std::fwrite(snapshot.parts, sizeof(PartRecord), snapshot.partCount, file) == snapshot.partCount;
+    if (ok && partPad)
+        ok = std::fwrite(padding, 1, partPad, file) == partPad;
+    if (ok && snapshot.filterCount)
+        ok = std::fwrite(snapshot.filters, sizeof(FilterRecord), snapshot.filterCount, file) == snapshot.filterCount;
+    if (ok && filterPad)
+        ok = std::fwrite(padding, 1, filterPad, file) == filterPad;
+    if (ok && snapshot.bodyCount)
+        ok = std::fwrite(snapshot.bodies, sizeof(BodyRecord), snapshot.bodyCount, file) == snapshot.bodyCount;
+
+    ok = (std::fclose(file) == 0) && ok;
+    return ok;
+}
+
+// === JSON state format ===
+namespace {
+    // Pointer iterator that publishes how far the parser has read
+    struct TrackedIterator {
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = char;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const char*;
+        using reference         = const char&;
+
+        const char*  position;
+        const char** cursor;
+
+        reference operator*() const { return *position; }
+        TrackedIterator& operator++() { *cursor = ++position; return *this; }
+        TrackedIterator operator++(int) { TrackedIterator old = *this; ++*this; return old; }
+        bool operator==(const TrackedIterator& other) const { return position == other.position; }
+        bool operator!=(const TrackedIterator& other) const { return position != other.position; }
+    };
+
+    // Builds bodies straight from parser events; no DOM is ever materialized
+    class StateSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+    public:
+        StateSaxHandler(SnapshotSettings& settings, std::vector<Body*>& bodies,
+                        StateFile::LoadProgress* progress, const char* begin, const char* const* cursor)
+            : settings(settings), bodies(bodies), progress(progress), begin(begin), cursor(cursor) {}
+
+        bool null() override { return true; }
+        bool boolean(bool value) override { Set(value ? 1.0 : 0.0); return true; }
+        bool number_integer(number_integer_t value) override { Set(static_cast<double>(value)); return true; }
+        bool number_unsigned(number_unsigned_t value) override { Set(static_cast<double>(value)); return true; }
+        bool number_float(number_float_t value, const string_t&) override { Set(value); return true; }
+        bool binary(binary_t&) override { return true; }
+
+        bool string(string_t& value) override {
+            PendingBody* target = Target();
+            if (target && field == Field::SHAPE) target->shape = value;
+            return true;
+        }
+
+        bool start_object(std::size_t) override {
+            depth++;
+            if (depth == 3 && inBodies) record = PendingBody {};
+            if (depth == 5 && inParts) record.parts.emplace_back();
+            return true;
+        }
+
+        bool end_object() override {
+            depth--;
+            if (depth == 2 && inBodies) {
+                BuildBody();
+                // Report once per record; stopping here aborts the parse
+                if (progress) {
+                    progress->bytesRead.store(static_cast<size_t>(*cursor - begin), std::memory_order_relaxed);
+                    if (progress->cancel.load(std::memory_order_relaxed)) return false;
+                }
+            }
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            depth++;
+            if (depth == 2 && field == Field::BODIES) inBodies = true;
+            if (depth == 4 && inBodies && field == Field::PARTS) inParts = true;
+            return true;
+        }
+
+        bool end_array() override {
+            if (depth == 2) inBodies = false;
+            if (depth == 4) inParts = false;
+            depth--;
+            return true;
+        }
+
+        bool key(string_t& name) override {
+            static const std::unordered_map<std::string, Field> fields = {
+                { "globalGravity",     Field::GLOBAL_GRAVITY },
+                { "globalRestitution", Field::GLOBAL_RESTITUTION },
+                { "globalRestituion",  Field::GLOBAL_RESTITUTION }, // older files
+                { "globalFriction",    Field::GLOBAL_FRICTION },
+                { "maxIteration",      Field::MAX_ITERATION },
+                { "paused",            Field::PAUSED },
+                { "pause",             Field::PAUSED },             // older files
+                { "pendulumAttached",  Field::PENDULUM },
+                { "bodies",            Field::BODIES },
+                { "x",                 Field::X },
+                { "y",                 Field::Y },
+                { "rotation",          Field::ROTATION },
+                { "velocityX",         Field::VELOCITY_X },
+                { "velocityY",         Field::VELOCITY_Y },
+                { "angularVelocity",   Field::ANGULAR_VELOCITY },
+                { "mass",              Field::MASS },
+                { "restitution",       Field::RESTITUTION },
+                { "friction",          Field::FRICTION },
+                { "gravity",           Field::GRAVITY },
+                { "bullet",            Field::BULLET },
+                { "sensor",            Field::SENSOR },
+                { "categoryBits",      Field::CATEGORY_BITS },
+                { "maskBits",          Field::MASK_BITS },
+                { "groupIndex",        Field::GROUP_INDEX },
+                { "shape",             Field::SHAPE },
+                { "radius",            Field::RADIUS },
+                { "size",              Field::RADIUS },             // polygon radius in older files
+                { "width",             Field::WIDTH },
+                { "height",            Field::HEIGHT },
+                { "length",            Field::LENGTH },
+                { "numSides",          Field::SIDES },
+                { "points",            Field::POINTS },
+                { "loop",              Field::LOOP },
+                { "parts",             Field::PARTS },
+            };
+            auto it = fields.find(name);
+            field = it != fields.end() ? it->second : Field::NONE;
+            return true;
+        }
+
+        bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& error) override {
+            errorPosition = position;
+            errorMessage = error.what();
+            return false;
+        }
+
+        std::size_t errorPosition = 0;
+        std::string errorMessage;
+
+    private:
+        enum class Field {
+            NONE, BODIES,
+            GLOBAL_GRAVITY, GLOBAL_RESTITUTION, GLOBAL_FRICTION, MAX_ITERATION, PAUSED, PENDULUM,
+            X, Y, ROTATION, VELOCITY_X, VELOCITY_Y, ANGULAR_VELOCITY,
+            MASS, RESTITUTION, FRICTION, GRAVITY, BULLET, SENSOR, CATEGORY_BITS, MASK_BITS, GROUP_INDEX,
+            SHAPE, RADIUS, WIDTH, HEIGHT, LENGTH, SIDES, POINTS, LOOP, PARTS
+        };
+
+        struct PendingBody {
+            float x = 0.f, y = 0.f, rotation = 0.f;
+            float velocityX = 0.f, velocityY = 0.f, angularVelocity = 0.f;
+            float mass = 1.f, restitution = 1.f, friction = 0.5f, gravity = 10.f;
+            float radius = 40.f, width = 0.f, height = 0.f, length = 0.f; // 40 is the polygon spawn radius
+            int   sides = 0;
+            bool  loop = false;
+            bool  bullet = false;
+            bool  sensor = false;
+            CollisionFilter filter;
+            std::vector<float> coordinates; // chain points or hull vertices as x, y pairs
+            std::vector<PendingBody> parts;  // compound children; x, y, rotation and the shape only
+            std::string shape;
+        };
+
+        // Record the current field belongs to: the body, or the compound part being read
+        PendingBody* Target() {
+            if (!inBodies) return nullptr;
+            if (depth == 3) return &record;
+            if (depth == 5 && inParts && !record.parts.empty()) return &record.parts.back();
+            return nullptr;
+        }
+
+        void Set(double value) {
+            const float v = static_cast<float>(value);
+            if (depth == 1) {
+                switch (field) {
+                    case Field::GLOBAL_GRAVITY:     settings.gravity = v; break;
+                    case Field::GLOBAL_RESTITUTION: settings.restitution = v; break;
+                    case Field::GLOBAL_FRICTION:    settings.friction = v; break;
+                    case Field::MAX_ITERATION:      settings.maxIteration = static_cast<int32_t>(value); break;
+                    case Field::PAUSED:             SetFlag(SETTINGS_PAUSED, value != 0.0); break;
+                    case Field::PENDULUM:           SetFlag(SETTINGS_PENDULUM_ATTACHED, value != 0.0); break;
+                    default: break;
+                }
+            } else if (PendingBody* target = Target()) {
+                switch (field) {
+                    case Field::X:                target->x = v; break;
+                    case Field::Y:                target->y = v; break;
+                    case Field::ROTATION:         target->rotation = v; break;
+                    case Field::VELOCITY_X:       target->velocityX = v; break;
+                    case Field::VELOCITY_Y:       target->velocityY = v; break;
+                    case Field::ANGULAR_VELOCITY: target->angularVelocity = v; break;
+                    case Field::MASS:             target->mass = v; break;
+                    case Field::RESTITUTION:      target->restitution = v; break;
+                    case Field::FRICTION:         target->friction = v; break;
+                    case Field::GRAVITY:          target->gravity = v; break;
+                    case Field::BULLET:           target->bullet = value != 0.0; break;
+                    case Field::SENSOR:           target->sensor = value != 0.0; break;
+                    case Field::CATEGORY_BITS:    target->filter.categoryBits = static_cast<uint16_t>(value); break;
+                    case Field::MASK_BITS:        target->filter.maskBits = static_cast<uint16_t>(value); break;
+                    case Field::GROUP_INDEX:      target->filter.groupIndex = static_cast<int16_t>(value); break;
+                    case Field::RADIUS:           target->radius = v; break;
+                    case Field::WIDTH:            target->width = v; break;
+                    case Field::HEIGHT:           target->height = v; break;
+                    case Field::LENGTH:           target->length = v; break;
+                    case Field::SIDES:            target->sides = static_cast<int>(value); break;
+                    case Field::LOOP:             target->loop = value != 0.0; break;
+                    default: break;
+                }
+            } else if (depth == 5 && inBodies && !inParts && field == Field::POINTS) {
+                record.coordinates.push_back(v); // one [x, y] array per point
+            } else if (depth == 7 && inParts && field == Field::POINTS && !record.parts.empty()) {
+                record.parts.back().coordinates.push_back(v); // hull vertices of a compound part
+            }
+        }
+
+        void SetFlag(uint32_t flag, bool on) {
+            settings.flags = on ? (settings.flags | flag) : (settings.flags & ~flag);
+        }
+
+        // Null for an unknown or incomplete shape
+        static Shape* BuildShape(const PendingBody& r) {
+            if (r.shape == "circle") return new CircleShape(r.radius);
+            if (r.shape == "box") return new BoxShape(r.width, r.height);
+            if (r.shape == "polygon" && r.sides >= 3) return new PolygonShape(r.sides, r.radius);
+            if (r.shape == "capsule") return new CapsuleShape(r.length, r.radius);
+            if (r.shape == "hull" && r.coordinates.size() >= 6) {
+                std::vector<Vec2> vertices;
+                for (size_t i = 0; i + 1 < r.coordinates.size(); i += 2)
+                    vertices.push_back(Vec2(r.coordinates[i], r.coordinates[i + 1]));
+                return new PolygonShape(vertices);
+            }
+            if (r.shape == "chain" && r.coordinates.size() >= 4) {
+                std::vector<Vec2> points;
+                for (size_t i = 0; i + 1 < r.coordinates.size(); i += 2)
+                    points.push_back(Vec2(r.coordinates[i], r.coordinates[i + 1]));
+                return new ChainShape(points, r.loop);
+            }
+            if (r.shape == "compound") {
+                // Unknown parts are skipped; the compound drops chain and compound ones
+                std::vector<std::unique_ptr<Shape>> shapes;
+                std::vector<CompoundShape::Child> children;
+                for (const PendingBody& part : r.parts) {
+                    shapes.emplace_back(BuildShape(part));
+                    if (shapes.back()) children.push_back({ shapes.back().get(), Vec2(part.x, part.y), part.rotation });
+                }
+                return children.empty() ? nullptr : new CompoundShape(children);
+            }
+            return nullptr;
+        }
+
+        void BuildBody() {
+            const PendingBody& r = record;
+            std::unique_ptr<Shape> shape(BuildShape(r));
+            if (!shape) return; // unknown shape, skipped as before
+            Body* body = new Body(*shape, r.x, r.y, r.mass, r.rotation);
+
+            body->velocity        = Vec2(r.velocityX, r.velocityY);
+            body->angularVelocity = r.angularVelocity;
+            body->restitution     = r.restitution;
+            body->friction        = r.friction;
+            body->gravity         = r.gravity;
+            body->bullet          = r.bullet;
+            body->shape->sensor   = r.sensor;
+            body->filter          = r.filter;
+            bodies.push_back(body);
+        }
+
+        SnapshotSettings&        settings;
+        std::vector<Body*>&      bodies;
+        StateFile::LoadProgress* progress;
+        const char*              begin;
+        const char* const*       cursor;
+
+        int         depth = 0;
+        bool        inBodies = false;
+        bool        inParts = false;
+        Field       field = Field::NONE;
+        PendingBody record;
+    };
+}
+
+bool StateFile::ReadJson(const std::string& path, SnapshotSettings& settings, std::vector<Body*>& bodies,
+                         LoadProgress* progress) {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    if (progress) progress->totalBytes = file.Size();
+
+    // Reserve the body store up front; a saved body takes well over 256 bytes
+    const size_t firstNew = bodies.size();
+    bodies.reserve(firstNew + file.Size() / 256);
+
+    const char* begin  = reinterpret_cast<const char*>(file.Data());
+    const char* cursor = begin;
+    TrackedIterator first { begin, &cursor };
+    TrackedIterator last  { begin + file.Size(), &cursor };
+
+    StateSaxHandler handler(settings, bodies, progress, begin, &cursor);
+    if (!nlohmann::json::sax_parse(first, last, &handler)) {
+        if (!progress || !progress->cancel)
+            std::cerr << "[State] JSON error at byte " << handler.errorPosition << ": " << handler.errorMessage << "\n";
+        for (size_t i = firstNew; i < bodies.size(); i++) delete bodies[i];
+        bodies.resize(firstNew);
+        return false;
+    }
+    if (progress) progress->bytesRead = file.Size();
+    return true;
+}
+
+bool StateFile::WriteJson(const std::string& path, const SnapshotView& snapshot) {
+    nlohmann::json j;
+    j["globalGravity"] = snapshot.settings.gravity;
+    j["globalRestitution"] = snapshot.settings.restitution;
+    j["globalFriction"] = snapshot.settings.friction;
+    j["maxIteration"] = snapshot.settings.maxIteration;
+    j["paused"] = (snapshot.settings.flags & SETTINGS_PAUSED) != 0;
+    j["pendulumAttached"] = (snapshot.settings.flags & SETTINGS_PENDULUM_ATTACHED) != 0;
+
+    // Where each shape's points and parts start in their tables
+    std::vector<size_t> firstPoint(snapshot.shapeCount, 0), firstPart(snapshot.shapeCount, 0);
+    for (size_t i = 0, point = 0, part = 0; i < snapshot.shapeCount; i++) {
+        firstPoint[i] = point;
+        firstPart[i] = part;
+        point += SceneSnapshot::PointsUsed(snapshot.shapes[i], snapshot.parts + part, snapshot.partCount - std::min(part, snapshot.partCount));
+        if (snapshot.shapes[i].type == SNAPSHOT_COMPOUND && snapshot.shapes[i].sides > 0)
+            part += snapshot.shapes[i].sides;
+    }
+
+    auto writePoints = [&](nlohmann::json& b, size_t first, int32_t count) {
+        if (count < 0 || first + count > snapshot.pointCount) return false;
+        nlohmann::json points = nlohmann::json::array();
+        for (int32_t k = 0; k < count; k++) {
+            const PointRecord& p = snapshot.points[first + k];
+            points.push_back({ p.x, p.y });
+        }
+        b["points"] = std::move(points);
+        return true;
+    };
+
+    // Convex shapes, hull vertices from point on; false for any other
+    auto writeConvexShape = [&](nlohmann::json& b, const ShapeRecord& shape, size_t point) {
+        switch (shape.type) {
+            case SNAPSHOT_HULL:
+                b["shape"] = "hull";
+                return writePoints(b, point, shape.sides);
+            case SNAPSHOT_CIRCLE:
+                b["shape"] = "circle";
+                b["radius"] = shape.a;
+                return true;
+            case SNAPSHOT_BOX:
+                b["shape"] = "box";
+                b["width"] = shape.a;
+                b["height"] = shape.b;
+                return true;
+            case SNAPSHOT_POLYGON:
+                b["shape"] = "polygon";
+                b["numSides"] = shape.sides;
+                b["radius"] = shape.a;
+                return true;
+            case SNAPSHOT_CAPSULE:
+                b["shape"] = "capsule";
+                b["length"] = shape.b;
+                b["radius"] = shape.a;
+                return true;
+        }
+        return false;
+    };
+
+    nlohmann::json bodyArray = nlohmann::json::array();
+    for (size_t i = 0; i < snapshot.bodyCount; i++) {
+        const BodyRecord& r = snapshot.bodies[i];
+        if (r.shapeIndex >= snapshot.shapeCount) return false;
+        const ShapeRecord& shape = snapshot.shapes[r.shapeIndex];
+
+        nlohmann::json b;
+        // --- Transform ---
+        b["x"] = r.x;
+        b["y"] = r.y;
+        b["rotation"] = r.rotation;
+
+        // --- Motion ---
+        b["velocityX"] = r.velocityX;
+        b["velocityY"] = r.velocityY;
+        b["angularVelocity"] = r.angularVelocity;
+
+        // --- Physics properties ---
+        b["mass"] = r.mass;
+        b["restitution"] = r.restitution;
+        b["friction"] = r.friction;
+        b["gravity"] = r.gravity;
+        if (r.flags & BODY_BULLET) b["bullet"] = true;
+        if (r.flags & BODY_SENSOR) b["sensor"] = true;
+        if (i < snapshot.filterCount) {
+            const FilterRecord& f = snapshot.filters[i];
+            if (f.categoryBits != 0x0001) b["categoryBits"] = f.categoryBits;
+            if (f.maskBits != 0xFFFF) b["maskBits"] = f.maskBits;
+            if (f.groupIndex != 0) b["groupIndex"] = f.groupIndex;
+        }
+
+        // --- Shape ---
+        switch (shape.type) {
+            case SNAPSHOT_CHAIN: {
+                b["shape"] = "chain";
+                if (!writePoints(b, firstPoint[r.shapeIndex], shape.sides)) return false;
+                b["loop"] = shape.a != 0.f;
+                break;
+            }
+            case SNAPSHOT_COMPOUND: {
+                const size_t first = firstPart[r.shapeIndex];
+                if (shape.sides < 0 || first + shape.sides > snapshot.partCount) return false;
+                nlohmann::json parts = nlohmann::json::array();
+                size_t point = firstPoint[r.shapeIndex];
+                for (int32_t k = 0; k < shape.sides; k++) {
+                    const PartRecord& p = snapshot.parts[first + k];
+                    nlohmann::json part;
+                    if (!writeConvexShape(part, p.shape, point)) return false;
+                    point += SceneSnapshot::PointsUsed(p.shape, nullptr, 0);
+                    part["x"] = p.x;
+                    part["y"] = p.y;
+                    part["rotation"] = p.angle;
+                    parts.push_back(std::move(part));
+                }
+                b["shape"] = "compound";
+                b["parts"] = std::move(parts);
+                break;
+            }
+            default:
+                // Hull vertices out of range mean a broken snapshot
+                if (!writeConvexShape(b, shape, firstPoint[r.shapeIndex]) && shape.type == SNAPSHOT_HULL) return false;
+                break;
+        }
+
+        bodyArray.push_back(std::move(b));
+    }
+    j["bodies"] = std::move(bodyArray);
+
+    std::ofstream file(path);
+    if (!file) return false;
+    file << j.dump(4);
+    file.close();
+    return !file.fail();
+}
+
+#ifdef _WIN32
+bool StateFile::ReplaceFile(const std::string& from, const std::string& to) {
+    HANDLE file = CreateFileA(from.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    bool flushed = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+
+    return flushed && MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+#else
+bool StateFile::ReplaceFile(const std::string& from, const std::string& to) {
+    int fd = open(from.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool flushed = fsync(fd) == 0;
+    close(fd);
+
+    return flushed && std::rename(from.c_str(), to.c_str()) == 0;
+}
+#endif
+
+bool StateFile::Parse(const unsigned char* data, size_t size, SnapshotView& view) {
+    if (size < HEADER_SIZE_V1) return false;
+
+    StateFileHeader header {};
+    std::memcpy(&header, data, HEADER_SIZE_V1);
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (header.endianTag != ENDIAN_TAG) return false;
+
+    // Fields past an older header stay zero: those tables are empty
+    const uint32_t headerSize = HeaderSize(header.version);
+    if (headerSize == 0 || header.headerSize != headerSize || size < headerSize) return false;
+    std::memcpy(&header, data, headerSize);
+
+    // Bounds and alignment checks before handing out pointers into the buffer
+    if (!TableFits(header.shapeOffset,  header.shapeCount,  sizeof(ShapeRecord),  size) ||
+        !TableFits(header.pointOffset,  header.pointCount,  sizeof(PointRecord),  size) ||
+        !TableFits(header.partOffset,   header.partCount,   sizeof(PartRecord),   size) ||
+        !TableFits(header.filterOffset, header.filterCount, sizeof(FilterRecord), size) ||
+        !TableFits(header.bodyOffset,   header.bodyCount,   sizeof(BodyRecord),   size)) return false;
+    if (header.filterCount != 0 && header.filterCount != header.bodyCount) return false;
+    if (header.shapeOffset % alignof(ShapeRecord) != 0 || header.pointOffset % alignof(PointRecord) != 0 ||
+        header.partOffset % alignof(PartRecord) != 0 || header.filterOffset % alignof(FilterRecord) != 0 ||
+        header.bodyOffset % alignof(BodyRecord) != 0) return false;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(BodyRecord) != 0) return false;
+
+    view.settings    = header.settings;
+    view.shapes      = reinterpret_cast<const ShapeRecord*>(data + header.shapeOffset);
+    view.shapeCount  = header.shapeCount;
+    view.points      = header.pointCount ? reinterpret_cast<const PointRecord*>(data + header.pointOffset) : nullptr;
+    view.pointCount  = header.pointCount;
+    view.parts       = header.partCount ? reinterpret_cast<const PartRecord*>(data + header.partOffset) : nullptr;
+    view.partCount   = header.partCount;
+    view.filters     = header.filterCount ? reinterpret_cast<const FilterRecord*>(data + header.filterOffset) : nullptr;
+    view.filterCount = header.filterCount;
+    view.bodies      = reinterpret_cast<const BodyRecord*>(data + header.bodyOffset);
+    view.bodyCount   = header.bodyCount;
+    return true;
+}
+
+bool StateFile::ReadBinary(const MappedFile& file, SnapshotView& view) {
+    return Parse(file.Data(), file.Size(), view);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Physics/Snapshot.h"
+
+// Binary state format (.rbs), little-endian, written in one pass:
+//
+//   StateFileHeader
+//   ShapeRecord[shapeCount]   at shapeOffset
+//   PointRecord[pointCount]   at pointOffset (version 2)
+//   PartRecord[partCount]     at partOffset (version 3)
+//   FilterRecord[filterCount] at filterOffset (version 4), 0 or bodyCount
+//   BodyRecord[bodyCount]     at bodyOffset
+//
+// Loading maps the file and reads records in place, no parsing step.
+// Older files end the header before the tables they lack: version 1 before
+// pointCount (no chains), version 2 before partCount (no compounds),
+// version 3 before filterCount (every body keeps the default filter).
+struct StateFileHeader {
+    char             magic[4];     // "RBSS"
+    uint32_t         version;
+    uint32_t         headerSize;
+    uint32_t         endianTag;    // 0x01020304 as written by the saving machine
+    SnapshotSettings settings;
+    uint32_t         shapeCount;
+    uint32_t         bodyCount;
+    uint64_t         shapeOffset;
+    uint64_t         bodyOffset;
+    uint32_t         pointCount;
+    uint32_t         reserved;
+    uint64_t         pointOffset;
+    uint32_t         partCount;
+    uint32_t         reserved2;
+    uint64_t         partOffset;
+    uint32_t         filterCount;
+    uint32_t         reserved3;
+    uint64_t         filterOffset;
+};
+
+static_assert(sizeof(StateFileHeader) == 112, "StateFileHeader layout is part of the state format");
+
+// Read-only memory mapping of a whole file (mmap / MapViewOfFile)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+namespace StateFile {
+    constexpr uint32_t VERSION = 4;
+    constexpr const char* BINARY_EXTENSION = ".rbs";
+    constexpr const char* JSON_EXTENSION = ".json";
+
+    bool IsBinaryPath(const std::string& path);
+
+    // Append the binary encoding of snapshot to out
+    void Serialize(const SnapshotView& snapshot, std::vector<unsigned char>& out);
+    // Validate an encoded snapshot and point view at its records in place
+    bool Parse(const unsigned char* data, size_t size, SnapshotView& view);
+
+    bool WriteBinary(const std::string& path, const SnapshotView& snapshot);
+    // Same scene as the JSON state format
+    bool WriteJson(const std::string& path, const SnapshotView& snapshot);
+
+    // Shared with a load running on another thread
+    struct LoadProgress {
+        std::atomic<size_t> bytesRead { 0 };
+        std::atomic<size_t> totalBytes { 0 };
+        std::atomic<bool>   cancel { false };
+    };
+
+    // Stream a JSON state file, appending a new body per record to bodies.
+    // settings keeps its values for keys the file does not have. On a parse
+    // error or a cancel bodies is left as it was.
+    bool ReadJson(const std::string& path, SnapshotSettings& settings, std::vector<Body*>& bodies,
+                  LoadProgress* progress = nullptr);
+
+    // Flush from to disk and rename it over to, replacing it atomically
+    bool ReplaceFile(const std::string& from, const std::string& to);
+
+    // Validate a mapped binary file and point view at its records
+    bool ReadBinary(const MappedFile& file, SnapshotView& view);
+}
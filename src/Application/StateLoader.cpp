@@ -0,0 +1,78 @@
+#include "StateLoader.h"
+
+#include <chrono>
+#include <iostream>
+
+StateLoader::~StateLoader() {
+    Stop();
+}
+
+bool StateLoader::Load(const std::string& path, const SnapshotSettings& settings) {
+    if (Busy()) return false;
+
+    pending = Result {};
+    pending.path     = path;
+    pending.settings = settings;
+
+    progress.bytesRead  = 0;
+    progress.totalBytes = 0;
+    progress.cancel     = false;
+    finished = false;
+
+    worker = std::thread(&StateLoader::Run, this);
+    return true;
+}
+
+float StateLoader::Progress() const {
+    size_t total = progress.totalBytes.load(std::memory_order_relaxed);
+    size_t read  = progress.bytesRead.load(std::memory_order_relaxed);
+    return total ? static_cast<float>(read) / static_cast<float>(total) : 0.f;
+}
+
+bool StateLoader::Poll(Result& result) {
+    if (!Busy() || !finished) return false;
+    worker.join();
+    result = std::move(pending);
+    pending = Result {};
+    return true;
+}
+
+void StateLoader::Stop() {
+    if (!Busy()) return;
+    Cancel();
+    worker.join();
+    for (Body* body : pending.bodies) delete body;
+    pending = Result {};
+}
+
+void StateLoader::Run() {
+    auto start = std::chrono::steady_clock::now();
+
+    if (StateFile::IsBinaryPath(pending.path)) {
+        MappedFile file;
+        SnapshotView view;
+        if (file.Open(pending.path) && StateFile::ReadBinary(file, view)) {
+            progress.totalBytes = file.Size();
+            if (SceneSnapshot::CreateBodies(view, pending.bodies)) {
+                pending.settings = view.settings;
+                pending.ok = true;
+            } else {
+                std::cerr << "[State] Corrupt body records in: " << pending.path << "\n";
+            }
+            progress.bytesRead = file.Size();
+        }
+    } else {
+        pending.ok = StateFile::ReadJson(pending.path, pending.settings, pending.bodies, &progress);
+    }
+
+    // A cancel that lands after the last record still discards the load
+    if (progress.cancel) {
+        for (Body* body : pending.bodies) delete body;
+        pending.bodies.clear();
+        pending.ok = false;
+        pending.cancelled = true;
+    }
+
+    pending.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Physics/Body.h"
+#include "Physics/Snapshot.h"
+#include "StateFile.h"
+
+// Loads a state file on a worker thread into its own body list. The caller
+// polls for the finished result between frames and swaps it into the world,
+// so the scene keeps running during the load and a failed or cancelled load
+// never touches it. One load runs at a time.
+class StateLoader {
+public:
+    struct Result {
+        std::string        path;
+        bool               ok;
+        bool               cancelled;
+        SnapshotSettings   settings;
+        std::vector<Body*> bodies;       // owned by the caller once polled
+        double             milliseconds;
+    };
+
+    StateLoader() = default;
+    ~StateLoader();
+    StateLoader(const StateLoader&) = delete;
+    StateLoader& operator=(const StateLoader&) = delete;
+
+    // settings are the current ones, kept for keys the file does not have.
+    // false if a load is already running.
+    bool Load(const std::string& path, const SnapshotSettings& settings);
+
+    bool  Busy() const { return worker.joinable(); }
+    // Fraction of the file parsed so far
+    float Progress() const;
+    void  Cancel() { progress.cancel = true; }
+
+    // The finished load, if any (called from the main thread)
+    bool Poll(Result& result);
+
+    // Cancel a running load and drop its bodies
+    void Stop();
+
+private:
+    void Run();
+
+    std::thread             worker;
+    std::atomic<bool>       finished { false };
+    StateFile::LoadProgress progress;
+    Result                  pending;
+};
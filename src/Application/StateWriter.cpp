@@ -0,0 +1,76 @@
+#include "StateWriter.h"
+
+#include <chrono>
+#include <filesystem>
+
+#include "StateFile.h"
+
+StateWriter::~StateWriter() {
+    Stop();
+}
+
+void StateWriter::Save(const std::string& path, SceneSnapshot&& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({ path, std::move(snapshot) });
+        stopRequested = false;
+        if (!worker.joinable())
+            worker = std::thread(&StateWriter::WorkerLoop, this);
+    }
+    wake.notify_one();
+}
+
+bool StateWriter::Poll(Result& result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (results.empty()) return false;
+    result = std::move(results.front());
+    results.pop_front();
+    return true;
+}
+
+void StateWriter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!worker.joinable()) return;
+        stopRequested = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void StateWriter::WorkerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopRequested || !jobs.empty(); });
+            if (jobs.empty()) return; // stop requested and queue drained
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::error_code error;
+        std::filesystem::path parent = std::filesystem::path(job.path).parent_path();
+        if (!parent.empty())
+            std::filesystem::create_directories(parent, error);
+
+        const std::string temporary = job.path + ".tmp";
+        const SnapshotView view = job.snapshot.View();
+        bool ok = StateFile::IsBinaryPath(job.path) ? StateFile::WriteBinary(temporary, view)
+                                                    : StateFile::WriteJson(temporary, view);
+        ok = ok && StateFile::ReplaceFile(temporary, job.path);
+        if (!ok)
+            std::filesystem::remove(temporary, error);
+
+        Result result;
+        result.path         = job.path;
+        result.ok           = ok;
+        result.bodyCount    = view.bodyCount;
+        result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Physics/Snapshot.h"
+
+// Saves scene snapshots on a worker thread. The caller only captures the
+// snapshot; encoding (JSON or binary, by extension) and file I/O happen on
+// the worker. Each file is written to "<path>.tmp" and renamed over the
+// target, so an interrupted save never leaves a half-written state file.
+class StateWriter {
+public:
+    struct Result {
+        std::string path;
+        bool        ok;
+        size_t      bodyCount;
+        double      milliseconds;
+    };
+
+    StateWriter() = default;
+    ~StateWriter();
+    StateWriter(const StateWriter&) = delete;
+    StateWriter& operator=(const StateWriter&) = delete;
+
+    void Save(const std::string& path, SceneSnapshot&& snapshot);
+
+    // Next finished save, if any (called from the main thread)
+    bool Poll(Result& result);
+
+    // Finish every queued save and stop the worker
+    void Stop();
+
+private:
+    struct Job {
+        std::string   path;
+        SceneSnapshot snapshot;
+    };
+
+    void WorkerLoop();
+
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::deque<Job>         jobs;
+    std::deque<Result>      results;
+    bool                    stopRequested = false;
+    std::thread             worker;
+};
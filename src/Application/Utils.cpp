@@ -1,26 +1,6 @@
 #include "Utils.h"
 
 
-bool Utils::IsPointInCircle(int pointX, int pointY, int circleX, int circleY, int radius) {
-    int deltaX = pointX - circleX;
-    int deltaY = pointY - circleY;
-    int distanceSquared = deltaX * deltaX + deltaY * deltaY;
-
-    return distanceSquared <= (radius * radius);
-}
-
-bool Utils::IsPointInBox(int pointX, int pointY, Body* body, BoxShape* boxShape) {
-    // Note: Ensure Body has a position member with x and y
-    // and BoxShape has width and height
-    float halfWidth = boxShape->width / 2.0f;
-    float halfHeight = boxShape->height / 2.0f;
-
-    return (pointX >= body->position.x - halfWidth &&
-        pointX <= body->position.x + halfWidth &&
-        pointY >= body->position.y - halfHeight &&
-        pointY <= body->position.y + halfHeight);
-}
-
 Monitors Utils::GetMonitor(GLFWwindow* window) {
     Monitors monitor;
 
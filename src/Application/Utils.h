@@ -20,9 +20,5 @@ public:
     // Disallow creating instances of this class
     Utils() = delete;
 
-    static bool IsPointInCircle(int pointX, int pointY, int circleX, int circleY, int radius);
-
-    static bool IsPointInBox(int pointX, int pointY, Body* body, BoxShape* boxShape);
-
     static Monitors GetMonitor(GLFWwindow* window);
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#include <cstdio>
+#include <cstdlib>
 #endif
 
 #ifdef _WIN32
@@ -19,11 +21,25 @@ int main(int argc, char** argv)
     (void)hPrevInstance;
     (void)lpCmdLine;   
     (void)nShowCmd;
-#else
-    (void)argc;
-    (void)argv;
+    // The CRT splits the command line for WinMain too
+    const int argc = __argc;
+    char** argv = __argv;
+    // A GUI-subsystem process has no console; headless runs report to the
+    // one they were started from
+    if (argc >= 2 && AttachConsole(ATTACH_PARENT_PROCESS)) {
+        std::freopen("CONOUT$", "w", stdout);
+        std::freopen("CONOUT$", "w", stderr);
+    }
 #endif
 
+    // Headless playback of a recorded session: --replay states/<name>.rbr [threads]
+    if (argc >= 3 && std::string(argv[1]) == "--replay")
+        return Application::RunReplay(argv[2], argc >= 4 ? std::max(1, std::atoi(argv[3])) : 1);
+
+    // Physics timings and checks: --bench [pairs]
+    if (argc >= 2 && std::string(argv[1]) == "--bench")
+        return Application::RunBenchmarks(argc >= 3 ? std::max(1, std::atoi(argv[2])) : 20000);
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include "Math/Vec2.h"
+
+// Axis-aligned bounding box in world (pixel) space.
+struct AABB {
+    Vec2 min;
+    Vec2 max;
+
+    bool Overlaps(const AABB& other) const {
+        return !(max.x < other.min.x || min.x > other.max.x ||
+                 max.y < other.min.y || min.y > other.max.y);
+    }
+
+    bool Contains(const AABB& other) const {
+        return min.x <= other.min.x && min.y <= other.min.y &&
+               max.x >= other.max.x && max.y >= other.max.y;
+    }
+
+    bool Contains(const Vec2& point) const {
+        return point.x >= min.x && point.x <= max.x &&
+               point.y >= min.y && point.y <= max.y;
+    }
+
+    float Perimeter() const {
+        return 2.0f * ((max.x - min.x) + (max.y - min.y));
+    }
+
+    Vec2 Center() const {
+        return Vec2((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f);
+    }
+
+    static AABB Union(const AABB& a, const AABB& b) {
+        AABB result;
+        result.min = Vec2(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y));
+        result.max = Vec2(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y));
+        return result;
+    }
+};
@@ -3,8 +3,9 @@
 #include <iostream>
 
 Body::Body(const Shape& shape, float x, float y, float mass, float rotation): shape(shape.Clone()), position(Vec2(x, y)), velocity(Vec2(0, 0)),
-      acceleration(Vec2(0, 0)), sumForces(Vec2(0, 0)), sumTorque(0.0), isColliding(false), mass(mass), restitution(1.0), gravity(10.0), friction(0.5), x(x), y(y), rotation(rotation), allowRotation(false)
+      acceleration(Vec2(0, 0)), sumForces(Vec2(0, 0)), sumTorque(0.0), mass(mass), restitution(1.0), gravity(10.0), friction(0.5), x(x), y(y), rotation(rotation), angularVelocity(0.0), angularAcceleration(0.0), allowRotation(false)
 {
+    this->shape->sensor = shape.sensor;
     if (mass != 0.0) {
         this->invMass = 1.0 / mass;
     } else {
@@ -50,8 +51,7 @@ void Body::ApplyImpulse(const Vec2 &j, const Vec2 &contactVector) {
 void Body::Update(const float &deltatime){
         IntegrateLinear(deltatime);
         IntegrateAngular(deltatime);
-        bool isPolygon = shape->GetType() == POLYGON || shape->GetType() == BOX; 
-        if(isPolygon) {
+        if(IsPolygon(shape->GetType())) {
             PolygonShape* polygonShape = (PolygonShape*) shape; 
             polygonShape->UpdateVertices(rotation, position); 
         }
@@ -105,16 +105,36 @@ float Body::GetRadius(){
 }
 
 void Body::SetWidth(float width){
+    if (shape->GetType() == CAPSULE) {
+        // Width spans the whole capsule, end caps included
+        CapsuleShape* capsule = static_cast<CapsuleShape*>(shape);
+        capsule->length = std::fmax(0.f, width - 2.f * capsule->radius);
+        return;
+    }
+    if (shape->GetType() != BOX) return;
     BoxShape* boxShape = static_cast<BoxShape*>(shape); 
     boxShape->width = width;  
 }
 
 void Body::SetHeight(float height){
+    if (shape->GetType() == CAPSULE) {
+        CapsuleShape* capsule = static_cast<CapsuleShape*>(shape);
+        float width = capsule->length + 2.f * capsule->radius;
+        capsule->radius = height * 0.5f;
+        capsule->length = std::fmax(0.f, width - height);
+        return;
+    }
+    if (shape->GetType() != BOX) return;
     BoxShape* boxShape = static_cast<BoxShape*>(shape); 
     boxShape->height = height; 
 }
 
 void Body::UpdateShapeData() {
+    if (shape->GetType() == CAPSULE) {
+        shape->UpdateVertices(rotation, position);
+        return;
+    }
+    if (shape->GetType() != BOX) return;
     BoxShape* boxShape = static_cast<BoxShape*>(shape);
 
     boxShape->localVertices = boxShape->GenerateBoxVertices(boxShape->width, boxShape->height); 
@@ -131,3 +151,10 @@ void Body::SetRadius(float &r){
 void Body::SetStatic(bool value) {
     invMass = value ? 0.0f : 1.0f; 
 }
+
+void Body::SetMass(float mass) {
+    this->mass = mass;
+    invMass = mass != 0.0f ? 1.0f / mass : 0.0f;
+    I = shape->GetMomentOfInertia() * mass;
+    invI = I != 0.0f ? 1.0f / I : 0.0f;
+}
@@ -1,9 +1,26 @@
 #pragma once
 
+#include <cstdint>
+
 #include "glm/glm.hpp"
 #include "Math/Vec2.h"
 #include "Shape.h"
 
+// Which bodies a body may touch, tested before any shape is. Two bodies in
+// the same non-zero group always collide if it is positive and never if it
+// is negative; otherwise each must be in a category the other's mask takes.
+struct CollisionFilter {
+  uint16_t categoryBits = 0x0001;
+  uint16_t maskBits     = 0xFFFF;
+  int16_t  groupIndex   = 0;
+
+  bool ShouldCollide(const CollisionFilter& other) const {
+    if (groupIndex == other.groupIndex && groupIndex != 0) return groupIndex > 0;
+    return (maskBits & other.categoryBits) != 0 && (categoryBits & other.maskBits) != 0;
+  }
+  bool IsDefault() const { return categoryBits == 0x0001 && maskBits == 0xFFFF && groupIndex == 0; }
+};
+
 struct Body {
   // Linear motion
   Vec2 position;
@@ -29,8 +46,10 @@ struct Body {
   float I;
   float invI;
   float friction; 
-  bool isColliding;
   bool allowRotation; 
+  bool bullet = false; // always swept for impacts, however slowly it moves
+  int  proxy = -1;     // leaf in the world's index, set by World::AddBody
+  CollisionFilter filter;
 
   float x, y; 
 
@@ -55,6 +74,8 @@ struct Body {
   void IntegrateVelocities(const float dt);
 
   void SetStatic(bool value);
+  // New mass, with inverse mass and inertia to match; 0 makes the body static
+  void SetMass(float mass);
   void SetWidth(float width);
   void SetHeight(float height);
   void UpdateShapeData();
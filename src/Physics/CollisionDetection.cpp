@@ -1,27 +1,512 @@
 #include "CollisionDetection.h"
 #include "Shape.h"
 
-bool CollisionDetection::isColliding(Body* a, Body* b, ContactInformation &contact){
-   bool aIsCircle = a->shape->GetType() == CIRCLE;
-    bool bIsCircle = b->shape->GetType() == CIRCLE;
-    bool aIsPolygon = a->shape->GetType() == POLYGON || a->shape->GetType() == BOX;
-    bool bIsPolygon = b->shape->GetType() == POLYGON || b->shape->GetType() == BOX;
+#include <algorithm>
+#include <cmath>
 
-    if (aIsCircle && bIsCircle) {
-        return isCircleCircleColliding(a, b, contact);
+namespace {
+    // Largest separation of other's vertices from one of polygon's faces,
+    // and that face
+    float MaxFaceSeparation(const PolygonShape& polygon, const PolygonShape& other, int& face) {
+        float best = -std::numeric_limits<float>::infinity();
+        const int count = static_cast<int>(polygon.worldVertices.size());
+        for (int i = 0; i < count; i++) {
+            const Vec2& vertex = polygon.worldVertices[i];
+            const Vec2 normal = polygon.GetEdge(i).Normal();
+            float smallest = std::numeric_limits<float>::infinity();
+            for (const Vec2& point : other.worldVertices)
+                smallest = std::min(smallest, (point - vertex).Dot(normal));
+            if (smallest > best) {
+                best = smallest;
+                face = i;
+            }
+        }
+        return best;
+    }
+
+    Vec2 ClosestPointOnSegment(const Vec2& point, const Vec2& start, const Vec2& end) {
+        Vec2 segment = end - start;
+        float lengthSquared = segment.MagnitudeSquared();
+        if (lengthSquared == 0.0f) return start;
+        float t = std::clamp((point - start).Dot(segment) / lengthSquared, 0.0f, 1.0f);
+        return start + segment * t;
+    }
+
+    // Closest points between segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection 5.1.9)
+    void ClosestPointsBetweenSegments(const Vec2& p1, const Vec2& q1, const Vec2& p2, const Vec2& q2, Vec2& c1, Vec2& c2) {
+        const Vec2 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+        const float a = d1.MagnitudeSquared(), e = d2.MagnitudeSquared(), f = d2.Dot(r);
+        float s = 0.0f, t = 0.0f;
+        if (a == 0.0f && e == 0.0f) {
+            // both are points
+        } else if (a == 0.0f) {
+            t = std::clamp(f / e, 0.0f, 1.0f);
+        } else {
+            const float c = d1.Dot(r);
+            if (e == 0.0f) {
+                s = std::clamp(-c / a, 0.0f, 1.0f);
+            } else {
+                const float b = d1.Dot(d2);
+                const float denominator = a * e - b * b;
+                s = denominator != 0.0f ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f) {
+                    t = 0.0f;
+                    s = std::clamp(-c / a, 0.0f, 1.0f);
+                } else if (t > 1.0f) {
+                    t = 1.0f;
+                    s = std::clamp((b - c) / a, 0.0f, 1.0f);
+                }
+            }
+        }
+        c1 = p1 + d1 * s;
+        c2 = p2 + d2 * t;
+    }
+
+    // Contact between two discs centered on the closest points of the shapes' cores
+    bool RoundedContact(Body* a, Body* b, const Vec2& centerA, float radiusA, const Vec2& centerB, float radiusB,
+                        const Vec2& fallbackNormal, ContactInformation& contact) {
+        const Vec2 ab = centerB - centerA;
+        const float radii = radiusA + radiusB;
+        const float distanceSquared = ab.MagnitudeSquared();
+        if (distanceSquared >= radii * radii) return false;
+
+        const float distance = std::sqrt(distanceSquared);
+        contact.a = a;
+        contact.b = b;
+        contact.normal = distance > 0.0f ? ab / distance : fallbackNormal;
+        contact.depth = radii - distance;
+        contact.start = centerB - contact.normal * radiusB;
+        contact.end = centerA + contact.normal * radiusA;
+        return true;
+    }
+
+    Vec2 SegmentNormal(const Vec2& start, const Vec2& end) {
+        Vec2 segment = end - start;
+        return segment.MagnitudeSquared() > 0.0f ? segment.Normal() : Vec2(0.0f, 1.0f);
+    }
+
+    // Below this the closest points of two cores give no usable direction
+    constexpr float CORE_TOUCH_SQUARED = 1e-6f;
+
+    // Separating axis between two cores, measured from a to b. pointB is
+    // where b's core reaches deepest against the axis, which places the contact.
+    struct CoreAxis {
+        float separation = -std::numeric_limits<float>::max();
+        Vec2  normal;
+        Vec2  pointB;
+    };
+
+    // Axis normal to a face of a: a's extent along it is known, b's comes from its points
+    void ConsiderAxisOfA(CoreAxis& best, const Vec2& normal, float extentA, const Vec2* pointsB, size_t countB) {
+        size_t deepest = 0;
+        for (size_t i = 1; i < countB; i++)
+            if (pointsB[i].Dot(normal) < pointsB[deepest].Dot(normal)) deepest = i;
+        float separation = pointsB[deepest].Dot(normal) - extentA;
+        if (separation > best.separation) best = { separation, normal, pointsB[deepest] };
+    }
+
+    // Both normals of b's segment: b's extent is its line, a's comes from its points
+    void ConsiderSegmentOfB(CoreAxis& best, const Vec2& start, const Vec2& end, const Vec2* pointsA, size_t countA) {
+        Vec2 normal = SegmentNormal(start, end);
+        for (int side = 0; side < 2; side++, normal = normal * -1.0f) {
+            size_t deepest = 0;
+            for (size_t i = 1; i < countA; i++)
+                if (pointsA[i].Dot(normal) > pointsA[deepest].Dot(normal)) deepest = i;
+            float separation = start.Dot(normal) - pointsA[deepest].Dot(normal);
+            if (separation > best.separation) best = { separation, normal, pointsA[deepest] + normal * separation };
+        }
+    }
+
+    // Contact from the best axis: start on b's surface, end on a's
+    void AxisContact(Body* a, Body* b, const CoreAxis& axis, float radii, float radiusB, ContactInformation& contact) {
+        contact.a = a;
+        contact.b = b;
+        contact.normal = axis.normal;
+        contact.depth = radii - axis.separation;
+        contact.start = axis.pointB - axis.normal * radiusB;
+        contact.end = contact.start + axis.normal * contact.depth;
+    }
+
+    // Two rounded segments: closest points, or SAT on the segment normals when the cores cross
+    bool CoresContact(Body* a, Body* b, const Vec2& a0, const Vec2& a1, float radiusA,
+                      const Vec2& b0, const Vec2& b1, float radiusB, ContactInformation& contact) {
+        Vec2 aClosest, bClosest;
+        ClosestPointsBetweenSegments(a0, a1, b0, b1, aClosest, bClosest);
+        if ((bClosest - aClosest).MagnitudeSquared() > CORE_TOUCH_SQUARED)
+            return RoundedContact(a, b, aClosest, radiusA, bClosest, radiusB, SegmentNormal(a0, a1), contact);
+
+        // Crossing cores: push out along the normal of either segment, whichever is shorter
+        const Vec2 aEnds[2] = { a0, a1 };
+        const Vec2 bEnds[2] = { b0, b1 };
+        CoreAxis axis;
+        Vec2 normal = SegmentNormal(a0, a1);
+        for (int side = 0; side < 2; side++, normal = normal * -1.0f)
+            ConsiderAxisOfA(axis, normal, a0.Dot(normal), bEnds, 2);
+        ConsiderSegmentOfB(axis, b0, b1, aEnds, 2);
+
+        AxisContact(a, b, axis, radiusA + radiusB, radiusB, contact);
+        return true;
+    }
+
+    // Polygon a against the rounded segment core0-core1 of b
+    bool PolygonCoreContact(Body* a, Body* b, const PolygonShape* polygon, const Vec2& core0, const Vec2& core1,
+                            float radius, ContactInformation& contact) {
+        const std::vector<Vec2>& vertices = polygon->worldVertices;
+        const size_t count = vertices.size();
+        if (count < 3) return false;
+
+        // SAT between the polygon and the core: the polygon's faces and the segment's normal
+        const Vec2 ends[2] = { core0, core1 };
+        CoreAxis axis;
+        for (size_t i = 0; i < count; i++) {
+            Vec2 normal = polygon->GetNormal(i);
+            ConsiderAxisOfA(axis, normal, vertices[i].Dot(normal), ends, 2);
+        }
+        ConsiderSegmentOfB(axis, core0, core1, vertices.data(), count);
+        if (axis.separation >= radius) return false;
+
+        if (axis.separation > 0.0f) {
+            // Core outside the polygon: the closest points give the exact depth, corners included
+            float bestDistanceSquared = std::numeric_limits<float>::max();
+            Vec2 polygonPoint, segmentPoint;
+            for (size_t i = 0; i < count; i++) {
+                Vec2 onEdge, onSegment;
+                ClosestPointsBetweenSegments(vertices[i], vertices[(i + 1) % count], core0, core1, onEdge, onSegment);
+                float distanceSquared = (onSegment - onEdge).MagnitudeSquared();
+                if (distanceSquared < bestDistanceSquared) {
+                    bestDistanceSquared = distanceSquared;
+                    polygonPoint = onEdge;
+                    segmentPoint = onSegment;
+                }
+            }
+            if (bestDistanceSquared > CORE_TOUCH_SQUARED)
+                return RoundedContact(a, b, polygonPoint, 0.0f, segmentPoint, radius, axis.normal, contact);
+        }
+
+        // Core touching or crossing the polygon
+        AxisContact(a, b, axis, radius, radius, contact);
+        return true;
+    }
+
+    void FlipContact(ContactInformation& contact) {
+        std::swap(contact.a, contact.b);
+        std::swap(contact.start, contact.end);
+        contact.normal = contact.normal * -1.0f;
+    }
+
+    // Two-sided contact between the segment start-end of a chain (as a) and a convex body
+    bool SegmentContact(Body* chain, Body* other, const Vec2& start, const Vec2& end, ContactInformation& contact) {
+        switch (other->shape->GetType()) {
+            case CIRCLE: {
+                const CircleShape* circle = static_cast<CircleShape*>(other->shape);
+                return RoundedContact(chain, other, ClosestPointOnSegment(other->position, start, end), 0.0f,
+                                      other->position, circle->radius, SegmentNormal(start, end), contact);
+            }
+            case CAPSULE: {
+                const CapsuleShape* capsule = static_cast<CapsuleShape*>(other->shape);
+                return CoresContact(chain, other, start, end, 0.0f, capsule->worldA, capsule->worldB, capsule->radius, contact);
+            }
+            case POLYGON:
+            case BOX:
+                if (!PolygonCoreContact(other, chain, static_cast<PolygonShape*>(other->shape), start, end, 0.0f, contact))
+                    return false;
+                FlipContact(contact);
+                return true;
+            default: {
+                // Anything else through GJK, the segment as a capsule without radius
+                CapsuleShape segment(0.0f, 0.0f);
+                segment.worldA = start;
+                segment.worldB = end;
+                GJK::Result result = GJK::Query(segment, start, *other->shape, other->position, nullptr);
+                if (!result.overlap || result.depth <= 0.0f) return false;
+                contact.a = chain;
+                contact.b = other;
+                contact.depth = result.depth;
+                contact.normal = result.normal;
+                contact.start = result.pointB;
+                contact.end = result.pointA;
+                return true;
+            }
+        }
+    }
+
+    // Contact normals within this cosine of a segment's normal are face contacts
+    constexpr float FACE_NORMAL_COSINE = 0.999f;
+    // Sine of the bend below which a join between segments counts as flat
+    constexpr float FLAT_JOIN_SINE = 0.01f;
+
+    // Whether v lies in the wedge swept from `from` to `to` the short way
+    bool InWedge(const Vec2& v, const Vec2& from, const Vec2& to) {
+        return from.Cross(to) >= 0.0f ? from.Cross(v) >= 0.0f && v.Cross(to) >= 0.0f
+                                      : from.Cross(v) <= 0.0f && v.Cross(to) <= 0.0f;
+    }
+
+    // Contact measured along the segment's own normal, from the body's deepest point
+    bool FaceContact(Body* chain, Body* other, const Vec2& start, const Vec2& normal, ContactInformation& contact) {
+        const Vec2 deepest = other->shape->Support(normal * -1.0f, other->position);
+        const float depth = (start - deepest).Dot(normal);
+        if (depth <= 0.0f) return false;
+        contact.a = chain;
+        contact.b = other;
+        contact.normal = normal;
+        contact.depth = depth;
+        contact.start = deepest;
+        contact.end = deepest + normal * depth;
+        return true;
+    }
+
+    // One-sided contact with one chain segment. The points on either side
+    // act as ghost vertices: a join only rounds off a body's normal where
+    // the chain bends away from it, so flat and concave joins never push
+    // sideways and snag a body sliding across them.
+    bool ChainSegmentContact(Body* chain, Body* other, const ChainShape& shape, int index, ContactInformation& contact) {
+        Vec2 start, end;
+        shape.GetSegment(index, start, end);
+        const Vec2 edge = end - start;
+        const float lengthSquared = edge.MagnitudeSquared();
+        if (lengthSquared == 0.0f) return false;
+        const Vec2 normal = edge.Normal();
+
+        // Bodies centred behind the segment pass through it, and bodies that
+        // do not reach its line cannot touch it
+        if ((other->position - start).Dot(normal) < 0.0f) return false;
+        if ((other->shape->Support(normal * -1.0f, other->position) - start).Dot(normal) >= 0.0f) return false;
+        if (!SegmentContact(chain, other, start, end, contact)) return false;
+        if (contact.normal.Dot(normal) >= FACE_NORMAL_COSINE) return true;
+
+        // Off the face normal: the contact is at one of the segment's ends
+        const bool atStart = (contact.end - start).Dot(edge) < 0.5f * lengthSquared;
+        Vec2 ghost;
+        if (!(atStart ? shape.GetPreviousGhost(index, ghost) : shape.GetNextGhost(index, ghost))) {
+            // Open end of the chain, rounded like a capsule's
+            if (contact.normal.Dot(normal) > 0.0f) return true;
+            return FaceContact(chain, other, start, normal, contact);
+        }
+
+        const Vec2 neighbourEdge = atStart ? start - ghost : ghost - end;
+        const Vec2 neighbourNormal = neighbourEdge.Normal();
+        const bool convex = atStart ? edge.Dot(neighbourNormal) < -FLAT_JOIN_SINE * std::sqrt(lengthSquared)
+                                    : neighbourEdge.Dot(normal) < -FLAT_JOIN_SINE * neighbourEdge.Magnitude();
+        if (convex) {
+            const float own = contact.normal.Dot(normal), theirs = contact.normal.Dot(neighbourNormal);
+            // Around the corner: reported once, by the segment facing the contact more
+            if (InWedge(contact.normal, neighbourNormal, normal)) return atStart ? own >= theirs : own > theirs;
+            // Centred past this end and facing the neighbour: the neighbour, which
+            // has the body over its own span, reports it
+            const float along = (other->position - start).Dot(edge) / lengthSquared;
+            if (theirs > own && (atStart ? along < 0.0f : along > 1.0f)) return false;
+        }
+        // Flat or concave join, or a deep contact: push along the segment's normal only
+        return FaceContact(chain, other, start, normal, contact);
+    }
+}
+
+namespace {
+    // Narrowphase routine for one pair of shape types; only GJK uses cache
+    using Kernel = bool (*)(Body* a, Body* b, ContactInformation& contact, GJK::SimplexCache* cache);
+
+    struct Dispatch {
+        Kernel kernel = nullptr; // none: GJK/EPA measures the pair
+        bool   swap = false;     // registered the other way round, so called as kernel(b, a)
+    };
+
+    // Routines for every ordered pair of shape types, indexed by the tags
+    struct DispatchTable {
+        Dispatch pairs[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT];
+
+        // kernel measures a body of type first against one of type second;
+        // the mirrored pair gets it too, with the bodies swapped
+        void Register(ShapeType first, ShapeType second, Kernel kernel) {
+            pairs[first][second] = { kernel, false };
+            if (first != second) pairs[second][first] = { kernel, true };
+        }
+
+        // type takes every routine registered for like so far
+        void Alias(ShapeType type, ShapeType like) {
+            for (int other = 0; other < SHAPE_TYPE_COUNT; other++) {
+                pairs[type][other] = pairs[like][other];
+                pairs[other][type] = pairs[other][like];
+            }
+            pairs[type][type] = pairs[like][like];
+        }
+    };
+
+    template <bool (*Fn)(Body*, Body*, ContactInformation&)>
+    bool Exact(Body* a, Body* b, ContactInformation& contact, GJK::SimplexCache*) {
+        return Fn(a, b, contact);
+    }
+
+    // One contact for shapes that touch in several places: the deepest
+    bool Deepest(const std::vector<ContactInformation>& contacts, ContactInformation& contact) {
+        if (contacts.empty()) return false;
+        contact = *std::max_element(contacts.begin(), contacts.end(),
+            [](const ContactInformation& x, const ContactInformation& y) { return x.depth < y.depth; });
+        return true;
     }
-    if (aIsPolygon && bIsPolygon) {
-        return IsCollidingPolygonPolygon(a, b, contact);
+
+    bool ChainKernel(Body* chain, Body* other, ContactInformation& contact, GJK::SimplexCache*) {
+        std::vector<ContactInformation> contacts;
+        CollisionDetection::CollideChain(chain, other, contacts);
+        return Deepest(contacts, contact);
     }
 
-    if (aIsPolygon && bIsCircle) {
-        return IsCollidingPolygonCircle(a, b, contact);
+    bool CompoundKernel(Body* compound, Body* other, ContactInformation& contact, GJK::SimplexCache*) {
+        std::vector<ContactInformation> contacts;
+        CollisionDetection::CollideCompound(compound, other, contacts);
+        return Deepest(contacts, contact);
     }
 
-    if (aIsCircle && bIsPolygon) {
-        return IsCollidingPolygonCircle(b, a, contact);
+    DispatchTable BuildKernels() {
+        using namespace CollisionDetection;
+        DispatchTable table;
+        table.Register(CIRCLE,  CIRCLE,  Exact<isCircleCircleColliding>);
+        table.Register(POLYGON, POLYGON, Exact<IsCollidingPolygonPolygon>);
+        table.Register(POLYGON, CIRCLE,  Exact<IsCollidingPolygonCircle>);
+        table.Register(CAPSULE, CAPSULE, Exact<IsCollidingCapsuleCapsule>);
+        table.Register(CAPSULE, CIRCLE,  Exact<IsCollidingCapsuleCircle>);
+        table.Register(POLYGON, CAPSULE, Exact<IsCollidingPolygonCapsule>);
+        table.Alias(BOX, POLYGON);
+
+        // Compounds last: a chain met by a compound goes through its parts
+        for (int type = 0; type < SHAPE_TYPE_COUNT; type++) table.Register(CHAIN, static_cast<ShapeType>(type), ChainKernel);
+        for (int type = 0; type < SHAPE_TYPE_COUNT; type++) table.Register(COMPOUND, static_cast<ShapeType>(type), CompoundKernel);
+        return table;
     }
-    return false;
+
+    const DispatchTable KERNELS = BuildKernels();
+}
+
+bool CollisionDetection::HasKernel(ShapeType a, ShapeType b){
+    return KERNELS.pairs[a][b].kernel != nullptr;
+}
+
+bool CollisionDetection::isColliding(Body* a, Body* b, ContactInformation &contact, GJK::SimplexCache* cache){
+    const Dispatch& entry = KERNELS.pairs[a->shape->GetType()][b->shape->GetType()];
+    if (!entry.kernel) return IsCollidingConvex(a, b, contact, cache);
+    return entry.swap ? entry.kernel(b, a, contact, cache) : entry.kernel(a, b, contact, cache);
+}
+
+bool CollisionDetection::IsCollidingCapsuleCircle(Body* a, Body* b, ContactInformation& contact) {
+    const CapsuleShape* capsule = static_cast<CapsuleShape*>(a->shape);
+    const CircleShape* circle = static_cast<CircleShape*>(b->shape);
+
+    Vec2 closest = ClosestPointOnSegment(b->position, capsule->worldA, capsule->worldB);
+    return RoundedContact(a, b, closest, capsule->radius, b->position, circle->radius,
+                          SegmentNormal(capsule->worldA, capsule->worldB), contact);
+}
+
+bool CollisionDetection::IsCollidingCapsuleCapsule(Body* a, Body* b, ContactInformation& contact) {
+    const CapsuleShape* aCapsule = static_cast<CapsuleShape*>(a->shape);
+    const CapsuleShape* bCapsule = static_cast<CapsuleShape*>(b->shape);
+    return CoresContact(a, b, aCapsule->worldA, aCapsule->worldB, aCapsule->radius,
+                        bCapsule->worldA, bCapsule->worldB, bCapsule->radius, contact);
+}
+
+bool CollisionDetection::IsCollidingPolygonCapsule(Body* a, Body* b, ContactInformation& contact) {
+    const CapsuleShape* capsule = static_cast<CapsuleShape*>(b->shape);
+    return PolygonCoreContact(a, b, static_cast<PolygonShape*>(a->shape), capsule->worldA, capsule->worldB,
+                              capsule->radius, contact);
+}
+
+bool CollisionDetection::IsCollidingChainSegment(Body* chain, Body* other, int segment, ContactInformation& contact) {
+    return ChainSegmentContact(chain, other, *static_cast<ChainShape*>(chain->shape), segment, contact);
+}
+
+int CollisionDetection::CollideChain(Body* chain, Body* other, std::vector<ContactInformation>& contacts) {
+    const ChainShape* shape = static_cast<ChainShape*>(chain->shape);
+    if (other->shape->GetType() == CHAIN) return 0;
+
+    const AABB bounds = other->shape->GetAABB(other->position);
+    if (!shape->GetAABB(chain->position).Overlaps(bounds)) return 0;
+
+    int found = 0;
+    shape->QuerySegments(bounds, [&](int segment) {
+        ContactInformation contact;
+        if (!ChainSegmentContact(chain, other, *shape, segment, contact)) return;
+        contacts.push_back(contact);
+        found++;
+    });
+    return found;
+}
+
+void CollisionDetection::FindPartPairs(Body* a, Body* b, std::vector<std::pair<int, int>>& pairs) {
+    const AABB boundsA = a->shape->GetAABB(a->position);
+    const AABB boundsB = b->shape->GetAABB(b->position);
+    if (!boundsA.Overlaps(boundsB)) return;
+
+    const CompoundShape* compoundA = a->shape->GetType() == COMPOUND ? static_cast<CompoundShape*>(a->shape) : nullptr;
+    const CompoundShape* compoundB = b->shape->GetType() == COMPOUND ? static_cast<CompoundShape*>(b->shape) : nullptr;
+
+    // Parts of b near box, checked against their placed bounds
+    auto findInB = [&](int partA, const AABB& box) {
+        if (!compoundB) {
+            pairs.push_back({ partA, -1 });
+            return;
+        }
+        compoundB->QueryParts(box, [&](int partB) {
+            const Body* body = compoundB->PlacePart(partB);
+            if (body->shape->GetAABB(body->position).Overlaps(box)) pairs.push_back({ partA, partB });
+        });
+    };
+
+    if (!compoundA) {
+        findInB(-1, boundsA);
+        return;
+    }
+    compoundA->QueryParts(boundsB, [&](int partA) {
+        const Body* body = compoundA->PlacePart(partA);
+        const AABB box = body->shape->GetAABB(body->position);
+        if (box.Overlaps(boundsB)) findInB(partA, box);
+    });
+}
+
+Body* CollisionDetection::PartBody(Body* body, int part) {
+    if (part < 0) return body;
+    return static_cast<CompoundShape*>(body->shape)->PlacePart(part);
+}
+
+void CollisionDetection::ReportOnOwners(ContactInformation& contact, Body* partA, Body* a, Body* partB, Body* b) {
+    // Routines may swap their arguments, so map each side separately
+    contact.a = contact.a == partA ? a : contact.a == partB ? b : contact.a;
+    contact.b = contact.b == partA ? a : contact.b == partB ? b : contact.b;
+}
+
+int CollisionDetection::CollideCompound(Body* a, Body* b, std::vector<ContactInformation>& contacts) {
+    std::vector<std::pair<int, int>> pairs;
+    FindPartPairs(a, b, pairs);
+
+    const size_t first = contacts.size();
+    for (const auto& pair : pairs) {
+        Body* partA = PartBody(a, pair.first);
+        Body* partB = PartBody(b, pair.second);
+        const size_t begin = contacts.size();
+        const bool aIsChain = partA->shape->GetType() == CHAIN;
+        if (aIsChain || partB->shape->GetType() == CHAIN) {
+            CollideChain(aIsChain ? partA : partB, aIsChain ? partB : partA, contacts);
+        } else {
+            ContactInformation contact;
+            if (isColliding(partA, partB, contact)) contacts.push_back(contact);
+        }
+        for (size_t i = begin; i < contacts.size(); i++) ReportOnOwners(contacts[i], partA, a, partB, b);
+    }
+    return static_cast<int>(contacts.size() - first);
+}
+
+bool CollisionDetection::IsCollidingConvex(Body* a, Body* b, ContactInformation& contact, GJK::SimplexCache* cache) {
+    GJK::Result result = GJK::Query(*a->shape, a->position, *b->shape, b->position, cache);
+    if (!result.overlap || result.depth <= 0.0f) {
+        return false;
+    }
+
+    // Same convention as the routines above: start on b, end on a, normal from a to b
+    contact.a = a;
+    contact.b = b;
+    contact.depth = result.depth;
+    contact.normal = result.normal;
+    contact.start = result.pointB;
+    contact.end = result.pointA;
+    return true;
 }
 
 bool CollisionDetection::IsCollidingPolygonCircle(Body* a, Body* b, ContactInformation& contact) {
@@ -144,3 +629,285 @@ bool CollisionDetection::IsCollidingPolygonPolygon(Body* a, Body* b, ContactInfo
     }
     return true;
 }
+
+int CollisionDetection::CollidePolygonPolygon(Body* a, Body* b, std::vector<ContactInformation>& contacts, float margin) {
+    const PolygonShape& aPolygon = *static_cast<PolygonShape*>(a->shape);
+    const PolygonShape& bPolygon = *static_cast<PolygonShape*>(b->shape);
+    if (aPolygon.worldVertices.size() < 3 || bPolygon.worldVertices.size() < 3) return 0;
+
+    int aFace = 0, bFace = 0;
+    const float aSeparation = MaxFaceSeparation(aPolygon, bPolygon, aFace);
+    if (aSeparation > margin) return 0;
+    const float bSeparation = MaxFaceSeparation(bPolygon, aPolygon, bFace);
+    if (bSeparation > margin) return 0;
+
+    // The reference face is the one the other polygon is furthest out of;
+    // a's wins near-ties so the choice does not flicker between frames
+    const bool aIsReference = aSeparation + 0.1f >= bSeparation;
+    const PolygonShape& reference = aIsReference ? aPolygon : bPolygon;
+    const PolygonShape& incident  = aIsReference ? bPolygon : aPolygon;
+    const int face = aIsReference ? aFace : bFace;
+
+    const Vec2 v1 = reference.worldVertices[face];
+    const Vec2 v2 = reference.worldVertices[(face + 1) % reference.worldVertices.size()];
+    const Vec2 normal = reference.GetEdge(face).Normal();
+
+    // Incident face: the one facing most against the reference normal
+    const int incidentCount = static_cast<int>(incident.worldVertices.size());
+    int incidentFace = 0;
+    float mostAgainst = std::numeric_limits<float>::infinity();
+    for (int i = 0; i < incidentCount; i++) {
+        const float facing = incident.GetEdge(i).Normal().Dot(normal);
+        if (facing < mostAgainst) {
+            mostAgainst = facing;
+            incidentFace = i;
+        }
+    }
+    Vec2 w1 = incident.worldVertices[incidentFace];
+    Vec2 w2 = incident.worldVertices[(incidentFace + 1) % incidentCount];
+
+    // Clip the incident face to the reference face's span
+    const Vec2  span = v2 - v1;
+    const float length = span.Magnitude();
+    if (length == 0.0f) return 0;
+    const Vec2  tangent = span / length;
+    float t1 = (w1 - v1).Dot(tangent), t2 = (w2 - v1).Dot(tangent);
+    auto clip = [&](Vec2& point, float& t, const Vec2& otherPoint, float otherT, float bound, bool below) {
+        if (below ? t >= bound : t <= bound) return true;
+        if (below ? otherT < bound : otherT > bound) return false; // both outside
+        point = point + (otherPoint - point) * ((bound - t) / (otherT - t));
+        t = bound;
+        return true;
+    };
+    if (!clip(w1, t1, w2, t2, 0.0f, true) || !clip(w2, t2, w1, t1, 0.0f, true)) return 0;
+    if (!clip(w1, t1, w2, t2, length, false) || !clip(w2, t2, w1, t1, length, false)) return 0;
+
+    int found = 0;
+    for (const Vec2& point : { w1, w2 }) {
+        const float separation = (point - v1).Dot(normal);
+        if (separation > margin) continue;
+        const Vec2 onReference = point - normal * separation;
+
+        ContactInformation contact;
+        contact.a = a;
+        contact.b = b;
+        contact.depth = -separation;
+        contact.normal = aIsReference ? normal : normal * -1.0f;
+        contact.start = aIsReference ? point : onReference;
+        contact.end   = aIsReference ? onReference : point;
+        contacts.push_back(contact);
+        found++;
+    }
+    return found;
+}
+
+namespace {
+    // Ray in a shape's frame, and a hit found there back in the world's
+    struct LocalRay {
+        Vec2 origin, translation;
+    };
+
+    LocalRay ToFrame(const Vec2& position, float angle, const Vec2& origin, const Vec2& translation) {
+        // One sine and cosine for both vectors
+        const float c = std::cos(angle), s = std::sin(angle);
+        const float x = origin.x - position.x, y = origin.y - position.y;
+        return { Vec2(c * x + s * y, c * y - s * x),
+                 Vec2(c * translation.x + s * translation.y, c * translation.y - s * translation.x) };
+    }
+
+    void HitFromFrame(float angle, const Vec2& origin, const Vec2& translation, float fraction, const Vec2& localNormal,
+                      CollisionDetection::RayHit& hit) {
+        hit.fraction = fraction;
+        hit.point = origin + translation * fraction;
+        hit.normal = localNormal.Rotate(angle);
+    }
+
+    // Convex shapes by type, posed at position and angle
+    bool RayCastConvex(const Shape& shape, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation,
+                       float maxFraction, CollisionDetection::RayHit& hit) {
+        switch (shape.GetType()) {
+            case CIRCLE:
+                return CollisionDetection::RayCastCircle(position, static_cast<const CircleShape&>(shape).radius,
+                                                         origin, translation, maxFraction, hit);
+            case BOX:
+                return CollisionDetection::RayCastBox(static_cast<const BoxShape&>(shape), position, angle,
+                                                      origin, translation, maxFraction, hit);
+            case POLYGON:
+                return CollisionDetection::RayCastPolygon(static_cast<const PolygonShape&>(shape), position, angle,
+                                                          origin, translation, maxFraction, hit);
+            case CAPSULE:
+                return CollisionDetection::RayCastCapsule(static_cast<const CapsuleShape&>(shape), position, angle,
+                                                          origin, translation, maxFraction, hit);
+            default:
+                return false;
+        }
+    }
+}
+
+bool CollisionDetection::RayCastCircle(const Vec2& center, float radius, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit) {
+    // |s + t d| = r, for the smaller root
+    const Vec2 s = origin - center;
+    const float c = s.MagnitudeSquared() - radius * radius;
+    if (c < 0.f) return false;
+    const float a = translation.MagnitudeSquared();
+    const float b = s.Dot(translation);
+    const float discriminant = b * b - a * c;
+    if (a == 0.f || discriminant < 0.f) return false;
+
+    const float t = (-b - std::sqrt(discriminant)) / a;
+    if (t < 0.f || t > maxFraction) return false;
+    hit.fraction = t;
+    hit.point = origin + translation * t;
+    hit.normal = (hit.point - center).UnitVector();
+    return true;
+}
+
+bool CollisionDetection::RayCastPolygon(const PolygonShape& polygon, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit) {
+    // Clip the ray against every face's half plane: it enters through the
+    // last face it crosses going in, if that is before it leaves any
+    const LocalRay ray = ToFrame(position, angle, origin, translation);
+    const std::vector<Vec2>& vertices = polygon.localVertices;
+    const int count = static_cast<int>(vertices.size());
+    float lower = 0.f, upper = maxFraction;
+    int entered = -1;
+    for (int i = 0; i < count; i++) {
+        // Outward, as Vec2::Normal, but left unnormalized: only signs and ratios matter
+        const Vec2& v = vertices[i];
+        const Vec2& next = vertices[i + 1 < count ? i + 1 : 0];
+        const float nx = next.y - v.y, ny = v.x - next.x;
+        const float numerator = nx * (v.x - ray.origin.x) + ny * (v.y - ray.origin.y);
+        const float denominator = nx * ray.translation.x + ny * ray.translation.y;
+        if (denominator == 0.f) {
+            if (numerator < 0.f) return false; // parallel, outside this face
+            continue;
+        }
+        if (denominator < 0.f && numerator < lower * denominator) {
+            lower = numerator / denominator;
+            entered = i;
+        } else if (denominator > 0.f && numerator < upper * denominator) {
+            upper = numerator / denominator;
+        }
+        if (upper < lower) return false;
+    }
+    if (entered < 0) return false; // starts inside
+
+    HitFromFrame(angle, origin, translation, lower, (vertices[(entered + 1) % count] - vertices[entered]).Normal(), hit);
+    return true;
+}
+
+bool CollisionDetection::RayCastBox(const BoxShape& box, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit) {
+    // Slabs in the box's own frame, an axis at a time
+    const LocalRay ray = ToFrame(position, angle, origin, translation);
+    const float half[2] = { box.width * 0.5f, box.height * 0.5f };
+    const float start[2] = { ray.origin.x, ray.origin.y };
+    const float motion[2] = { ray.translation.x, ray.translation.y };
+    float lower = 0.f, upper = maxFraction;
+    Vec2 normal;
+    bool entered = false;
+    for (int axis = 0; axis < 2; axis++) {
+        if (motion[axis] == 0.f) {
+            if (std::fabs(start[axis]) > half[axis]) return false;
+            continue;
+        }
+        const float side = motion[axis] > 0.f ? -1.f : 1.f; // face the ray meets first
+        const float near = (side * half[axis] - start[axis]) / motion[axis];
+        const float far = (-side * half[axis] - start[axis]) / motion[axis];
+        if (near > lower) {
+            lower = near;
+            normal = axis == 0 ? Vec2(side, 0.f) : Vec2(0.f, side);
+            entered = true;
+        }
+        upper = std::min(upper, far);
+        if (upper < lower) return false;
+    }
+    if (!entered) return false;
+
+    HitFromFrame(angle, origin, translation, lower, normal, hit);
+    return true;
+}
+
+bool CollisionDetection::RayCastCapsule(const CapsuleShape& capsule, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit) {
+    // Along the local x axis: the flat sides, then the end caps
+    const LocalRay ray = ToFrame(position, angle, origin, translation);
+    const float halfLength = capsule.length * 0.5f;
+    const float r = capsule.radius;
+    const float alongX = std::max(-halfLength, std::min(halfLength, ray.origin.x));
+    if ((ray.origin - Vec2(alongX, 0.f)).MagnitudeSquared() < r * r) return false;
+
+    if (std::fabs(ray.origin.y) >= r && ray.origin.y * ray.translation.y < 0.f) {
+        const float side = ray.origin.y > 0.f ? 1.f : -1.f;
+        const float t = (side * r - ray.origin.y) / ray.translation.y;
+        const float x = ray.origin.x + ray.translation.x * t;
+        if (t > maxFraction) return false;
+        if (x >= -halfLength && x <= halfLength) {
+            HitFromFrame(angle, origin, translation, t, Vec2(0.f, side), hit);
+            return true;
+        }
+    }
+
+    RayHit capA, capB;
+    const bool hitA = RayCastCircle(Vec2(-halfLength, 0.f), r, ray.origin, ray.translation, maxFraction, capA);
+    const bool hitB = RayCastCircle(Vec2(halfLength, 0.f), r, ray.origin, ray.translation, maxFraction, capB);
+    if (!hitA && !hitB) return false;
+    const RayHit& cap = hitA && (!hitB || capA.fraction <= capB.fraction) ? capA : capB;
+    HitFromFrame(angle, origin, translation, cap.fraction, cap.normal, hit);
+    return true;
+}
+
+bool CollisionDetection::RayCastSegment(const Vec2& start, const Vec2& end, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit) {
+    const Vec2 edge = end - start;
+    if (edge.MagnitudeSquared() == 0.f) return false;
+    // Only from in front, moving in
+    const Vec2 normal = edge.Normal();
+    const float approach = translation.Dot(normal);
+    const float height = (origin - start).Dot(normal);
+    if (height < 0.f || approach >= 0.f) return false;
+
+    const float t = -height / approach;
+    if (t > maxFraction) return false;
+    const Vec2 point = origin + translation * t;
+    const float along = (point - start).Dot(edge);
+    if (along < 0.f || along > edge.MagnitudeSquared()) return false;
+    hit.fraction = t;
+    hit.point = point;
+    hit.normal = normal;
+    return true;
+}
+
+bool CollisionDetection::RayCast(const Body* body, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit) {
+    bool found = false;
+    switch (body->shape->GetType()) {
+        case CHAIN: {
+            const ChainShape* chain = static_cast<const ChainShape*>(body->shape);
+            const Vec2 end = origin + translation * maxFraction;
+            chain->QuerySegments(AABB::Union({ origin, origin }, { end, end }), [&](int segment) {
+                Vec2 start, end;
+                chain->GetSegment(segment, start, end);
+                if (RayCastSegment(start, end, origin, translation, maxFraction, hit)) {
+                    maxFraction = hit.fraction;
+                    found = true;
+                }
+            });
+            return found;
+        }
+        case COMPOUND: {
+            // In the compound's frame, where its parts sit at their offsets
+            const CompoundShape* compound = static_cast<const CompoundShape*>(body->shape);
+            const LocalRay ray = ToFrame(body->position, body->rotation, origin, translation);
+            const AABB local = AABB::Union({ ray.origin, ray.origin },
+                                           { ray.origin + ray.translation * maxFraction, ray.origin + ray.translation * maxFraction });
+            RayHit partHit;
+            compound->tree.Query(local, [&](int index) {
+                const CompoundShape::Part& part = compound->parts[index];
+                if (RayCastConvex(*part.body->shape, part.offset, part.angle, ray.origin, ray.translation, maxFraction, partHit)) {
+                    maxFraction = partHit.fraction;
+                    found = true;
+                }
+            });
+            if (found) HitFromFrame(body->rotation, origin, translation, partHit.fraction, partHit.normal, hit);
+            return found;
+        }
+        default:
+            return RayCastConvex(*body->shape, body->position, body->rotation, origin, translation, maxFraction, hit);
+    }
+}
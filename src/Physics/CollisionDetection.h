@@ -1,11 +1,60 @@
 #pragma once
 #include "Body.h"
 #include "ContactInformation.h"
+#include "GJK.h"
 #include <limits>
+#include <utility>
+#include <vector>
 
 namespace CollisionDetection {
-   bool isColliding(Body* a, Body* b, ContactInformation &contact); 
+   // Looks the routine up by both shapes' types. One registered for the
+   // types the other way round runs with a and b swapped, and its contact
+   // says so in its own a and b. Pairs without a routine go through
+   // GJK/EPA; cache warm-starts it.
+   bool isColliding(Body* a, Body* b, ContactInformation &contact, GJK::SimplexCache* cache = nullptr); 
+   bool HasKernel(ShapeType a, ShapeType b);
    bool isCircleCircleColliding(Body* a, Body* b, ContactInformation &contact);
    bool IsCollidingPolygonPolygon(Body* a, Body* b, ContactInformation& contact);
+   // Both contact points of a face against a face (the incident face
+   // clipped to the reference one), or one at a corner. Points up to
+   // margin apart are kept too, with negative depth. Returns how many.
+   int CollidePolygonPolygon(Body* a, Body* b, std::vector<ContactInformation>& contacts, float margin = 0.0f);
    bool IsCollidingPolygonCircle(Body* a, Body* b, ContactInformation& contact);  
+   bool IsCollidingCapsuleCircle(Body* a, Body* b, ContactInformation& contact);
+   bool IsCollidingCapsuleCapsule(Body* a, Body* b, ContactInformation& contact);
+   bool IsCollidingPolygonCapsule(Body* a, Body* b, ContactInformation& contact);
+   // One segment of a chain against a body, the chain as a one-sided
+   // surface: a body centred behind the segment passes through it
+   bool IsCollidingChainSegment(Body* chain, Body* other, int segment, ContactInformation& contact);
+   // Appends a contact per chain segment touching other; returns how many
+   int CollideChain(Body* chain, Body* other, std::vector<ContactInformation>& contacts);
+   // Parts of a and b whose bounds overlap, as indices for PartBody. A body
+   // that is not a compound is a single part, -1.
+   void FindPartPairs(Body* a, Body* b, std::vector<std::pair<int, int>>& pairs);
+   // The body a contact query runs on for one part of body, in place
+   Body* PartBody(Body* body, int part);
+   // Makes a contact found between two parts refer to the bodies owning them
+   void ReportOnOwners(ContactInformation& contact, Body* partA, Body* a, Body* partB, Body* b);
+   // Appends a contact per touching pair of parts; returns how many
+   int CollideCompound(Body* a, Body* b, std::vector<ContactInformation>& contacts);
+   bool IsCollidingConvex(Body* a, Body* b, ContactInformation& contact, GJK::SimplexCache* cache);
+
+   // Rays run from origin to origin + translation, no further than
+   // maxFraction of it. A hit gives the fraction reached, the point and the
+   // shape's outward normal there. A ray starting inside a shape does not
+   // hit it, and chain segments are one-sided, as for contacts.
+   struct RayHit {
+      float fraction;
+      Vec2  point;
+      Vec2  normal;
+   };
+   bool RayCastCircle(const Vec2& center, float radius, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit);
+   // Shapes posed at position and angle; their world vertices are not used
+   bool RayCastPolygon(const PolygonShape& polygon, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit);
+   bool RayCastBox(const BoxShape& box, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit);
+   bool RayCastCapsule(const CapsuleShape& capsule, const Vec2& position, float angle, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit);
+   bool RayCastSegment(const Vec2& start, const Vec2& end, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit);
+   // Nearest hit on any body: a compound's nearest part, a chain's nearest
+   // segment. Reads shapes only, so rays may be cast from several threads.
+   bool RayCast(const Body* body, const Vec2& origin, const Vec2& translation, float maxFraction, RayHit& hit);
 };
@@ -1,5 +1,7 @@
 #include "CollisionSolver.h"
 
+#include <cmath>
+
 void CollisionSolver::ResolveOverlap(ContactInformation &contact){
 
     if(contact.a->IsStatic() && contact.b->IsStatic()) return; 
@@ -27,7 +29,7 @@ void CollisionSolver::SetCorrectionValue(float &correction){
     correctionFactor = correction;  
 }
 
-void CollisionSolver::ResolveCollision(ContactInformation &contact){
+float CollisionSolver::ResolveCollision(ContactInformation &contact){
     ResolveOverlap(contact); 
    auto a = contact.a; 
    auto b = contact.b; 
@@ -67,5 +69,6 @@ void CollisionSolver::ResolveCollision(ContactInformation &contact){
     // Apply the impulse to both objects in opposite directions
     a->ApplyImpulse(j, ra);
     b->ApplyImpulse(-j, rb);
+    return std::fabs(impulseMagnitudeNormal);
 
 }
\ No newline at end of file
@@ -6,6 +6,7 @@ namespace CollisionSolver{
 
     static float correctionFactor = 0.8f; 
     void ResolveOverlap(ContactInformation &contact);  
-    void ResolveCollision(ContactInformation &contact); 
+    // Returns the size of the normal impulse applied
+    float ResolveCollision(ContactInformation &contact); 
     void SetCorrectionValue(float &correction); 
 }
\ No newline at end of file
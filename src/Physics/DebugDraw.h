@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Math/Vec2.h"
+#include "AABB.h"
+
+// Categories the physics step can emit. Each producer checks its bit
+// before doing any work, so a disabled category costs one test per site.
+enum DebugDrawFlags : uint32_t {
+    DEBUG_NONE       = 0,
+    DEBUG_CONTACTS   = 1u << 0,
+    DEBUG_NORMALS    = 1u << 1,
+    DEBUG_AABBS      = 1u << 2,
+    DEBUG_BROADPHASE = 1u << 3  // the index's fat boxes, as the next step will find pairs
+};
+
+// Packed RGBA8 colours (0xAABBGGRR), same layout as RenderCommand::color
+namespace DebugColor {
+    constexpr uint32_t RED    = 0xFF0000FFu;
+    constexpr uint32_t GREEN  = 0xFF00FF00u;
+    constexpr uint32_t CYAN   = 0xFFFFFF00u;
+    constexpr uint32_t ORANGE = 0xFF0080FFu;
+    constexpr uint32_t YELLOW = 0xFF00FFFFu;
+}
+
+// Sink the physics step writes debug primitives into. The renderer drains
+// it once per frame and then clears it.
+struct DebugDraw {
+    struct Point   { Vec2 p; float radius; uint32_t color; };
+    struct Segment { Vec2 a, b; uint32_t color; };
+    struct Box     { AABB box; uint32_t color; };
+
+    uint32_t flags = DEBUG_NONE;
+
+    std::vector<Point>   points;
+    std::vector<Segment> segments;
+    std::vector<Box>     boxes;
+
+    bool IsEnabled(uint32_t category) const { return (flags & category) != 0; }
+    bool IsEmpty() const { return points.empty() && segments.empty() && boxes.empty(); }
+
+    void AddPoint(const Vec2& p, float radius, uint32_t color)      { points.push_back({ p, radius, color }); }
+    void AddSegment(const Vec2& a, const Vec2& b, uint32_t color)   { segments.push_back({ a, b, color }); }
+    void AddBox(const AABB& box, uint32_t color)                    { boxes.push_back({ box, color }); }
+
+    void Clear() {
+        points.clear();
+        segments.clear();
+        boxes.clear();
+    }
+};
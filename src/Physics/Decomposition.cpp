@@ -0,0 +1,250 @@
+#include "Decomposition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    constexpr float COLLINEAR_EPSILON = 1e-6f; // relative to the edge lengths
+
+    float Cross(const Vec2& a, const Vec2& b, const Vec2& c) {
+        return (b - a).Cross(c - b);
+    }
+
+    // Strictly left of the turn a -> b -> c, scaled so large outlines behave like small ones
+    bool IsConvex(const Vec2& a, const Vec2& b, const Vec2& c) {
+        const float scale = (b - a).Magnitude() * (c - b).Magnitude();
+        return Cross(a, b, c) > COLLINEAR_EPSILON * scale;
+    }
+
+    bool InTriangle(const Vec2& p, const Vec2& a, const Vec2& b, const Vec2& c) {
+        return (b - a).Cross(p - a) >= 0.f && (c - b).Cross(p - b) >= 0.f && (a - c).Cross(p - c) >= 0.f;
+    }
+
+    float SignedArea(const std::vector<Vec2>& points) {
+        float area = 0.f;
+        for (size_t i = 0; i < points.size(); i++)
+            area += points[i].Cross(points[(i + 1) % points.size()]);
+        return area * 0.5f;
+    }
+
+    // Counter-clockwise copy without repeated or collinear points
+    std::vector<Vec2> Clean(const std::vector<Vec2>& outline) {
+        std::vector<Vec2> points;
+        for (const Vec2& p : outline)
+            if (points.empty() || (p - points.back()).MagnitudeSquared() > 0.f) points.push_back(p);
+        while (points.size() > 1 && (points.front() - points.back()).MagnitudeSquared() == 0.f) points.pop_back();
+
+        for (bool removed = true; removed && points.size() >= 3;) {
+            removed = false;
+            for (size_t i = 0; i < points.size() && points.size() >= 3; i++) {
+                const Vec2& a = points[(i + points.size() - 1) % points.size()];
+                const Vec2& c = points[(i + 1) % points.size()];
+                const float scale = (points[i] - a).Magnitude() * (c - points[i]).Magnitude();
+                if (std::fabs(Cross(a, points[i], c)) <= COLLINEAR_EPSILON * scale) {
+                    points.erase(points.begin() + i);
+                    removed = true;
+                }
+            }
+        }
+        if (points.size() < 3) return {};
+        if (SignedArea(points) < 0.f) std::reverse(points.begin(), points.end());
+        return points;
+    }
+
+    // Two edges that properly cross; ear clipping would otherwise happily
+    // triangulate a bow tie
+    bool SelfIntersects(const std::vector<Vec2>& points) {
+        const size_t count = points.size();
+        for (size_t i = 0; i < count; i++) {
+            const Vec2& a = points[i];
+            const Vec2& b = points[(i + 1) % count];
+            for (size_t j = i + 2; j < count; j++) {
+                if (i == 0 && j == count - 1) continue; // shares a corner
+                const Vec2& c = points[j];
+                const Vec2& d = points[(j + 1) % count];
+                const float d1 = (b - a).Cross(c - a), d2 = (b - a).Cross(d - a);
+                const float d3 = (d - c).Cross(a - c), d4 = (d - c).Cross(b - c);
+                if (((d1 > 0.f && d2 < 0.f) || (d1 < 0.f && d2 > 0.f)) &&
+                    ((d3 > 0.f && d4 < 0.f) || (d3 < 0.f && d4 > 0.f))) return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t EdgeKey(int from, int to) {
+        return (uint64_t(uint32_t(from)) << 32) | uint32_t(to);
+    }
+
+    struct CacheEntry {
+        std::vector<Vec2>              outline;
+        std::unique_ptr<CompoundShape> shape; // null for outlines that failed
+    };
+
+    std::mutex cacheMutex;
+    std::unordered_map<uint64_t, std::vector<CacheEntry>> cache;
+
+    uint64_t HashOutline(const std::vector<Vec2>& outline) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const Vec2& p : outline) {
+            uint32_t bits[2];
+            std::memcpy(&bits[0], &p.x, sizeof(float));
+            std::memcpy(&bits[1], &p.y, sizeof(float));
+            for (uint32_t word : bits) hash = (hash ^ word) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool SameOutline(const std::vector<Vec2>& a, const std::vector<Vec2>& b) {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(Vec2)) == 0);
+    }
+
+    std::unique_ptr<CompoundShape> BuildCompound(const std::vector<Vec2>& outline) {
+        std::vector<std::vector<Vec2>> pieces;
+        if (!Decomposition::Decompose(outline, pieces)) return nullptr;
+
+        // Each piece about its own centroid, placed there in the compound
+        std::vector<PolygonShape> shapes;
+        std::vector<Vec2> centroids;
+        shapes.reserve(pieces.size());
+        for (const std::vector<Vec2>& piece : pieces) {
+            Vec2 centroid;
+            float area = 0.f;
+            for (size_t i = 0; i < piece.size(); i++) {
+                const Vec2& a = piece[i];
+                const Vec2& b = piece[(i + 1) % piece.size()];
+                const float cross = a.Cross(b);
+                area += cross;
+                centroid += (a + b) * cross;
+            }
+            centroid = centroid / (3.f * area);
+
+            std::vector<Vec2> local;
+            local.reserve(piece.size());
+            for (const Vec2& p : piece) local.push_back(p - centroid);
+            shapes.emplace_back(local);
+            centroids.push_back(centroid);
+        }
+
+        std::vector<CompoundShape::Child> children;
+        for (size_t i = 0; i < shapes.size(); i++) children.push_back({ &shapes[i], centroids[i], 0.f });
+        return std::make_unique<CompoundShape>(children);
+    }
+}
+
+bool Decomposition::Decompose(const std::vector<Vec2>& outline, std::vector<std::vector<Vec2>>& pieces) {
+    pieces.clear();
+    const std::vector<Vec2> points = Clean(outline);
+    const int count = static_cast<int>(points.size());
+    if (count < 3 || SelfIntersects(points)) return false;
+
+    // Ear clipping: cut off a convex corner with no other outline point
+    // inside, until one triangle is left. O(n^2) for the outlines people draw.
+    std::vector<int> remaining(count);
+    for (int i = 0; i < count; i++) remaining[i] = i;
+    std::vector<std::vector<int>> polygons;
+    std::vector<std::pair<int, int>> diagonals;
+    polygons.reserve(count - 2);
+
+    while (remaining.size() > 3) {
+        const int size = static_cast<int>(remaining.size());
+        bool clipped = false;
+        for (int i = 0; i < size && !clipped; i++) {
+            const int a = remaining[(i + size - 1) % size], b = remaining[i], c = remaining[(i + 1) % size];
+            if (!IsConvex(points[a], points[b], points[c])) continue;
+
+            bool empty = true;
+            for (int k = 0; k < size && empty; k++) {
+                const int p = remaining[k];
+                if (p == a || p == b || p == c) continue;
+                if (InTriangle(points[p], points[a], points[b], points[c])) empty = false;
+            }
+            if (!empty) continue;
+
+            polygons.push_back({ a, b, c });
+            diagonals.push_back({ a, c });
+            remaining.erase(remaining.begin() + i);
+            clipped = true;
+        }
+        if (!clipped) return false; // crosses itself
+    }
+    polygons.push_back(remaining);
+
+    // Hertel-Mehlhorn: merge across each diagonal unless that breaks convexity
+    std::unordered_map<uint64_t, int> owner; // directed edge -> polygon holding it
+    for (int p = 0; p < static_cast<int>(polygons.size()); p++)
+        for (size_t k = 0; k < polygons[p].size(); k++)
+            owner[EdgeKey(polygons[p][k], polygons[p][(k + 1) % polygons[p].size()])] = p;
+
+    for (auto it = diagonals.rbegin(); it != diagonals.rend(); ++it) {
+        const int u = it->first, v = it->second;
+        auto forward = owner.find(EdgeKey(v, u)), backward = owner.find(EdgeKey(u, v));
+        if (forward == owner.end() || backward == owner.end()) continue;
+        const int p = forward->second, q = backward->second;
+        if (p == q) continue;
+
+        // p walks v -> u, q walks u -> v; the merge is p from u round to v,
+        // then q's vertices strictly between v and u
+        std::vector<int>& first = polygons[p];
+        std::vector<int>& second = polygons[q];
+        const int sizeP = static_cast<int>(first.size()), sizeQ = static_cast<int>(second.size());
+        const int uInP = static_cast<int>(std::find(first.begin(), first.end(), u) - first.begin());
+        const int vInQ = static_cast<int>(std::find(second.begin(), second.end(), v) - second.begin());
+
+        std::vector<int> merged;
+        merged.reserve(sizeP + sizeQ - 2);
+        for (int k = 0; k < sizeP; k++) merged.push_back(first[(uInP + k) % sizeP]);      // u ... v
+        for (int k = 1; k < sizeQ - 1; k++) merged.push_back(second[(vInQ + k) % sizeQ]); // after v ... before u
+
+        const int size = static_cast<int>(merged.size());
+        const int vAt = sizeP - 1;
+        auto convexAt = [&](int k) {
+            return Cross(points[merged[(k + size - 1) % size]], points[merged[k]], points[merged[(k + 1) % size]]) >= 0.f;
+        };
+        if (!convexAt(0) || !convexAt(vAt)) continue;
+
+        owner.erase(forward);
+        owner.erase(backward);
+        for (int k = 0; k < size; k++) owner[EdgeKey(merged[k], merged[(k + 1) % size])] = p;
+        first = std::move(merged);
+        second.clear();
+    }
+
+    for (const std::vector<int>& polygon : polygons) {
+        if (polygon.empty()) continue;
+        std::vector<Vec2> piece;
+        piece.reserve(polygon.size());
+        for (int index : polygon) piece.push_back(points[index]);
+        pieces.push_back(std::move(piece));
+    }
+    return true;
+}
+
+const CompoundShape* Decomposition::FromOutline(const std::vector<Vec2>& outline) {
+    const uint64_t hash = HashOutline(outline);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    // Outlines sharing a hash are told apart by comparing them in full
+    std::vector<CacheEntry>& bucket = cache[hash];
+    for (const CacheEntry& entry : bucket)
+        if (SameOutline(entry.outline, outline)) return entry.shape.get();
+
+    bucket.push_back({ outline, BuildCompound(outline) });
+    return bucket.back().shape.get();
+}
+
+size_t Decomposition::CacheSize() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    size_t size = 0;
+    for (const auto& bucket : cache) size += bucket.second.size();
+    return size;
+}
+
+void Decomposition::ClearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Math/Vec2.h"
+#include "Shape.h"
+
+// Concave outlines as compounds of convex pieces. The outline is ear-clipped
+// into triangles, then Hertel-Mehlhorn drops every diagonal whose removal
+// keeps both sides convex, which leaves at most four times the fewest
+// pieces possible. Results are cached by outline, so spawning the same
+// outline again only costs the hash and the clone into the body.
+namespace Decomposition {
+    // Convex pieces of a simple polygon (either winding, no self-crossings),
+    // each counter-clockwise in math orientation. False, leaving pieces
+    // empty, if the outline is degenerate or crosses itself.
+    bool Decompose(const std::vector<Vec2>& outline, std::vector<std::vector<Vec2>>& pieces);
+
+    // Compound of the outline's pieces, about its centre of mass; the
+    // shape's own centroid member says where that sits relative to the
+    // outline's origin. Built on the first call for an outline, shared
+    // afterwards; null if the outline can't be decomposed. Safe to call
+    // from any thread.
+    const CompoundShape* FromOutline(const std::vector<Vec2>& outline);
+
+    size_t CacheSize();
+    void ClearCache();
+}
@@ -0,0 +1,178 @@
+#include "DynamicTree.h"
+
+#include <algorithm>
+
+namespace {
+    AABB Grow(const AABB& box, float margin) {
+        return { box.min - Vec2(margin, margin), box.max + Vec2(margin, margin) };
+    }
+}
+
+int DynamicTree::Insert(Body* body, const AABB& box) {
+    const int leaf = Allocate();
+    nodes[leaf].box = Grow(box, MARGIN);
+    nodes[leaf].body = body;
+    InsertLeaf(leaf);
+    return leaf;
+}
+
+void DynamicTree::Remove(int proxy) {
+    RemoveLeaf(proxy);
+    Free(proxy);
+}
+
+bool DynamicTree::Move(int proxy, const AABB& box) {
+    // A body that shrank a lot is refitted too, or its queries stay loose
+    const AABB& fat = nodes[proxy].box;
+    if (fat.Contains(box) && Grow(box, 4.f * MARGIN).Contains(fat)) return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].box = Grow(box, MARGIN);
+    InsertLeaf(proxy);
+    return true;
+}
+
+void DynamicTree::Clear() {
+    nodes.clear();
+    root = NONE;
+    freeList = NONE;
+}
+
+int DynamicTree::Allocate() {
+    int index;
+    if (freeList != NONE) {
+        index = freeList;
+        freeList = nodes[index].parent;
+    } else {
+        index = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[index] = { AABB {}, NONE, NONE, NONE, 0, nullptr };
+    return index;
+}
+
+void DynamicTree::Free(int index) {
+    nodes[index].parent = freeList;
+    nodes[index].height = -1;
+    nodes[index].body = nullptr;
+    freeList = index;
+}
+
+void DynamicTree::InsertLeaf(int leaf) {
+    if (root == NONE) {
+        root = leaf;
+        nodes[leaf].parent = NONE;
+        return;
+    }
+
+    // Walk down towards the cheapest sibling: pairing with a node costs its
+    // union with the leaf, twice over for the new parent and the leaf's own
+    // share, and every node passed on the way grows to cover the leaf too
+    const AABB box = nodes[leaf].box;
+    int index = root;
+    while (nodes[index].left != NONE) {
+        const Node& node = nodes[index];
+        const float combined = AABB::Union(node.box, box).Perimeter();
+        const float pairHere = 2.f * combined;
+        const float inherited = 2.f * (combined - node.box.Perimeter());
+
+        auto descend = [&](int child) {
+            const float joined = AABB::Union(nodes[child].box, box).Perimeter();
+            const float grown = nodes[child].left == NONE ? joined : joined - nodes[child].box.Perimeter();
+            return grown + inherited;
+        };
+        const float costLeft = descend(node.left);
+        const float costRight = descend(node.right);
+        if (pairHere < costLeft && pairHere < costRight) break;
+        index = costLeft < costRight ? node.left : node.right;
+    }
+
+    const int sibling = index;
+    const int oldParent = nodes[sibling].parent;
+    const int parent = Allocate(); // may move nodes; indices only from here
+    nodes[parent].parent = oldParent;
+    nodes[parent].left = sibling;
+    nodes[parent].right = leaf;
+    nodes[parent].box = AABB::Union(box, nodes[sibling].box);
+    nodes[parent].height = nodes[sibling].height + 1;
+    nodes[sibling].parent = parent;
+    nodes[leaf].parent = parent;
+
+    if (oldParent == NONE) root = parent;
+    else if (nodes[oldParent].left == sibling) nodes[oldParent].left = parent;
+    else nodes[oldParent].right = parent;
+
+    Refit(oldParent);
+}
+
+void DynamicTree::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = NONE;
+        return;
+    }
+
+    // The sibling takes the parent's place
+    const int parent = nodes[leaf].parent;
+    const int grandparent = nodes[parent].parent;
+    const int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+    nodes[sibling].parent = grandparent;
+    Free(parent);
+
+    if (grandparent == NONE) {
+        root = sibling;
+        return;
+    }
+    if (nodes[grandparent].left == parent) nodes[grandparent].left = sibling;
+    else nodes[grandparent].right = sibling;
+    Refit(grandparent);
+}
+
+void DynamicTree::Refit(int index) {
+    while (index != NONE) {
+        index = Balance(index);
+        Node& node = nodes[index];
+        node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+        node.box = AABB::Union(nodes[node.left].box, nodes[node.right].box);
+        index = node.parent;
+    }
+}
+
+int DynamicTree::Balance(int index) {
+    const Node& node = nodes[index];
+    if (node.left == NONE || node.height < 2) return index;
+
+    const int tilt = nodes[node.right].height - nodes[node.left].height;
+    if (tilt > 1) return Rotate(index, node.right);
+    if (tilt < -1) return Rotate(index, node.left);
+    return index;
+}
+
+int DynamicTree::Rotate(int parent, int child) {
+    Node& a = nodes[parent];
+    Node& c = nodes[child];
+    const int other = a.left == child ? a.right : a.left;
+
+    // The taller grandchild stays under child; the shorter one moves down
+    // to parent, in child's old slot
+    const bool keepLeft = nodes[c.left].height > nodes[c.right].height;
+    const int kept = keepLeft ? c.left : c.right;
+    const int moved = keepLeft ? c.right : c.left;
+
+    c.parent = a.parent;
+    if (c.parent == NONE) root = child;
+    else if (nodes[c.parent].left == parent) nodes[c.parent].left = child;
+    else nodes[c.parent].right = child;
+    c.left = parent;
+    c.right = kept;
+    a.parent = child;
+
+    if (a.left == child) a.left = moved;
+    else a.right = moved;
+    nodes[moved].parent = parent;
+
+    a.box = AABB::Union(nodes[other].box, nodes[moved].box);
+    a.height = 1 + std::max(nodes[other].height, nodes[moved].height);
+    c.box = AABB::Union(a.box, nodes[kept].box);
+    c.height = 1 + std::max(a.height, nodes[kept].height);
+    return child;
+}
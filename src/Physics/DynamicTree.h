@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "AABB.h"
+
+struct Body;
+
+// Bounding volume tree over boxes that move, one leaf per body. A leaf keeps
+// a fat box, the body's box grown by MARGIN, and only moves in the tree once
+// the body leaves it, so most steps touch no nodes at all. New leaves go
+// next to the sibling that grows the tree's perimeter least, and rotations
+// keep it balanced, so a query visits a few dozen nodes for any body count.
+struct DynamicTree {
+    static constexpr int   NONE   = -1;
+    static constexpr float MARGIN = 5.f; // pixels
+
+    struct Node {
+        AABB  box;
+        int   parent;      // next free node while unused
+        int   left, right; // child nodes, NONE for a leaf
+        int   height;      // 0 for a leaf, -1 while unused
+        Body* body;        // leaves only
+    };
+
+    // Add a leaf for body covering box; returns its proxy
+    int  Insert(Body* body, const AABB& box);
+    void Remove(int proxy);
+    // Refit a leaf to its body's new box; false if the fat box still fits it
+    bool Move(int proxy, const AABB& box);
+    void Clear();
+    bool Empty() const { return root == NONE; }
+    const AABB& FatBox(int proxy) const { return nodes[proxy].box; }
+
+    // Calls fn(body) for every leaf whose fat box overlaps box, in no
+    // particular order, until fn returns false
+    template <typename Fn>
+    void Query(const AABB& box, Fn fn) const {
+        if (root == NONE) return;
+        int stack[STACK_SIZE]; // balanced, so depth stays near log2 of the leaf count
+        int count = 0;
+        stack[count++] = root;
+        while (count > 0) {
+            const Node& node = nodes[stack[--count]];
+            if (!node.box.Overlaps(box)) continue;
+            if (node.left == NONE) {
+                if (!fn(node.body)) return;
+                continue;
+            }
+            stack[count++] = node.left;
+            stack[count++] = node.right;
+        }
+    }
+
+    // Calls fn(body, maxFraction) for every leaf whose fat box the ray from
+    // origin to origin + translation crosses within maxFraction of it,
+    // nearer subtrees first. fn returns the new maxFraction: a hit's
+    // fraction clips the rest of the search to it, 0 ends it.
+    template <typename Fn>
+    void RayCast(const Vec2& origin, const Vec2& translation, float maxFraction, Fn fn) const {
+        if (root == NONE) return;
+        const Vec2 inverse(translation.x != 0.f ? 1.f / translation.x : 0.f,
+                           translation.y != 0.f ? 1.f / translation.y : 0.f);
+        int stack[STACK_SIZE];
+        int count = 0;
+        stack[count++] = root;
+        while (count > 0) {
+            const Node& node = nodes[stack[--count]];
+            if (!Crosses(node.box, origin, translation, inverse, maxFraction)) continue;
+            if (node.left == NONE) {
+                maxFraction = fn(node.body, maxFraction);
+                if (maxFraction <= 0.f) return;
+                continue;
+            }
+            // Popped last, searched first. Plain floats: Vec2's operators
+            // are out of line, and this runs for every node a ray meets.
+            const AABB& left = nodes[node.left].box;
+            const AABB& right = nodes[node.right].box;
+            const bool leftFirst = (left.min.x + left.max.x - right.min.x - right.max.x) * translation.x +
+                                   (left.min.y + left.max.y - right.min.y - right.max.y) * translation.y < 0.f;
+            stack[count++] = leftFirst ? node.right : node.left;
+            stack[count++] = leftFirst ? node.left : node.right;
+        }
+    }
+
+private:
+    static constexpr int STACK_SIZE = 256;
+
+    // Slab test of the ray's first maxFraction against box; inverse holds
+    // 1 / translation per axis, 0 where the ray does not move along it
+    static bool Crosses(const AABB& box, const Vec2& origin, const Vec2& translation, const Vec2& inverse, float maxFraction) {
+        float lower = 0.f, upper = maxFraction;
+        if (translation.x != 0.f) {
+            const float a = (box.min.x - origin.x) * inverse.x, b = (box.max.x - origin.x) * inverse.x;
+            lower = std::max(lower, std::min(a, b));
+            upper = std::min(upper, std::max(a, b));
+        } else if (origin.x < box.min.x || origin.x > box.max.x) {
+            return false;
+        }
+        if (translation.y != 0.f) {
+            const float a = (box.min.y - origin.y) * inverse.y, b = (box.max.y - origin.y) * inverse.y;
+            lower = std::max(lower, std::min(a, b));
+            upper = std::min(upper, std::max(a, b));
+        } else if (origin.y < box.min.y || origin.y > box.max.y) {
+            return false;
+        }
+        return lower <= upper;
+    }
+
+    std::vector<Node> nodes;
+    int root     = NONE;
+    int freeList = NONE;
+
+    int  Allocate();
+    void Free(int index);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    // Rebalance, then fit heights and boxes, from index up to the root
+    void Refit(int index);
+    // Returns the node now in index's place
+    int  Balance(int index);
+    // Lift child up into parent's place; returns child
+    int  Rotate(int parent, int child);
+};
@@ -0,0 +1,289 @@
+#include "GJK.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr int   MAX_GJK_ITERATIONS = 32;
+    constexpr int   MAX_EPA_ITERATIONS = 32;
+    constexpr int   MAX_POLYTOPE       = 3 + MAX_EPA_ITERATIONS;
+    constexpr float TOLERANCE          = 1e-3f; // pixels
+    constexpr float DUPLICATE_SQUARED  = 1e-8f;
+
+    // A point of the Minkowski difference a - b and the shape points it came from
+    struct SupportPoint {
+        Vec2  a, b, w;
+        Vec2  direction;
+        float u; // barycentric weight in the current simplex
+    };
+
+    SupportPoint MakeSupport(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB, const Vec2& direction) {
+        SupportPoint s;
+        s.direction = direction;
+        s.a = a.Support(direction, positionA);
+        s.b = b.Support(Vec2(-direction.x, -direction.y), positionB);
+        s.w = s.a - s.b;
+        s.u = 1.f;
+        return s;
+    }
+
+    struct Simplex {
+        SupportPoint v[3];
+        int count = 0;
+
+        bool Contains(const Vec2& w) const {
+            for (int i = 0; i < count; i++)
+                if ((v[i].w - w).MagnitudeSquared() < DUPLICATE_SQUARED) return true;
+            return false;
+        }
+
+        Vec2 Closest() const {
+            Vec2 p(0.f, 0.f);
+            for (int i = 0; i < count; i++) p += v[i].w * v[i].u;
+            return p;
+        }
+
+        void Witness(Vec2& pointA, Vec2& pointB) const {
+            pointA = Vec2(0.f, 0.f);
+            pointB = Vec2(0.f, 0.f);
+            for (int i = 0; i < count; i++) {
+                pointA += v[i].a * v[i].u;
+                pointB += v[i].b * v[i].u;
+            }
+        }
+
+        // Reduce a segment to the feature closest to the origin
+        void Solve2() {
+            const Vec2 w1 = v[0].w, w2 = v[1].w;
+            const Vec2 e12 = w2 - w1;
+
+            const float d12_2 = -w1.Dot(e12);
+            if (d12_2 <= 0.f) { v[0].u = 1.f; count = 1; return; }
+
+            const float d12_1 = w2.Dot(e12);
+            if (d12_1 <= 0.f) { v[0] = v[1]; v[0].u = 1.f; count = 1; return; }
+
+            const float inv = 1.f / (d12_1 + d12_2);
+            v[0].u = d12_1 * inv;
+            v[1].u = d12_2 * inv;
+        }
+
+        // Reduce a triangle to the feature closest to the origin; stays a
+        // triangle only if the origin is inside it
+        void Solve3() {
+            const Vec2 w1 = v[0].w, w2 = v[1].w, w3 = v[2].w;
+
+            const Vec2  e12 = w2 - w1;
+            const float d12_1 = w2.Dot(e12), d12_2 = -w1.Dot(e12);
+            const Vec2  e13 = w3 - w1;
+            const float d13_1 = w3.Dot(e13), d13_2 = -w1.Dot(e13);
+            const Vec2  e23 = w3 - w2;
+            const float d23_1 = w3.Dot(e23), d23_2 = -w2.Dot(e23);
+
+            const float n123 = e12.Cross(e13);
+            const float d123_1 = n123 * w2.Cross(w3);
+            const float d123_2 = n123 * w3.Cross(w1);
+            const float d123_3 = n123 * w1.Cross(w2);
+
+            if (d12_2 <= 0.f && d13_2 <= 0.f) { v[0].u = 1.f; count = 1; return; }
+
+            if (d12_1 > 0.f && d12_2 > 0.f && d123_3 <= 0.f) {
+                const float inv = 1.f / (d12_1 + d12_2);
+                v[0].u = d12_1 * inv;
+                v[1].u = d12_2 * inv;
+                count = 2;
+                return;
+            }
+
+            if (d13_1 > 0.f && d13_2 > 0.f && d123_2 <= 0.f) {
+                const float inv = 1.f / (d13_1 + d13_2);
+                v[0].u = d13_1 * inv;
+                v[1] = v[2];
+                v[1].u = d13_2 * inv;
+                count = 2;
+                return;
+            }
+
+            if (d12_1 <= 0.f && d23_2 <= 0.f) { v[0] = v[1]; v[0].u = 1.f; count = 1; return; }
+            if (d13_1 <= 0.f && d23_1 <= 0.f) { v[0] = v[2]; v[0].u = 1.f; count = 1; return; }
+
+            if (d23_1 > 0.f && d23_2 > 0.f && d123_1 <= 0.f) {
+                const float inv = 1.f / (d23_1 + d23_2);
+                v[0] = v[2];
+                v[0].u = d23_2 * inv;
+                v[1].u = d23_1 * inv;
+                count = 2;
+                return;
+            }
+
+            const float inv = 1.f / (d123_1 + d123_2 + d123_3);
+            v[0].u = d123_1 * inv;
+            v[1].u = d123_2 * inv;
+            v[2].u = d123_3 * inv;
+        }
+    };
+
+    // Runs GJK; true if the shapes overlap (or touch within TOLERANCE)
+    bool RunGJK(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB,
+                GJK::SimplexCache* cache, Simplex& simplex, int& iterations) {
+        simplex.count = 0;
+
+        // Warm start from the directions that found last frame's simplex
+        if (cache) {
+            for (int i = 0; i < cache->count; i++) {
+                SupportPoint s = MakeSupport(a, positionA, b, positionB, cache->directions[i]);
+                if (!simplex.Contains(s.w)) simplex.v[simplex.count++] = s;
+            }
+        }
+        if (simplex.count == 0) {
+            Vec2 direction = positionB - positionA;
+            if (direction.MagnitudeSquared() == 0.f) direction = Vec2(1.f, 0.f);
+            simplex.v[simplex.count++] = MakeSupport(a, positionA, b, positionB, direction);
+        }
+
+        bool overlap = false;
+        Simplex solved = simplex; // last simplex reduced to its closest feature
+        float solvedSquared = std::numeric_limits<float>::max();
+        for (iterations = 0; iterations < MAX_GJK_ITERATIONS; iterations++) {
+            if (simplex.count == 2) simplex.Solve2();
+            else if (simplex.count == 3) simplex.Solve3();
+
+            if (simplex.count == 3) { overlap = true; break; }
+
+            const Vec2  p = simplex.Closest();
+            const float distanceSquared = p.MagnitudeSquared();
+            if (distanceSquared < TOLERANCE * TOLERANCE) { overlap = true; break; }
+
+            // Float noise along a long face can tilt the search direction just
+            // enough that a curved shape keeps returning near-copies of the
+            // same point; once the distance stops dropping, that is the answer
+            if (distanceSquared >= solvedSquared) { simplex = solved; break; }
+            solved = simplex;
+            solvedSquared = distanceSquared;
+
+            // Search towards the origin; stop once that gets no closer
+            const Vec2 direction(-p.x, -p.y);
+            SupportPoint s = MakeSupport(a, positionA, b, positionB, direction);
+            if ((s.w - p).Dot(direction) <= TOLERANCE * std::sqrt(distanceSquared)) break;
+            if (simplex.Contains(s.w)) break;
+
+            simplex.v[simplex.count++] = s;
+        }
+        // Out of iterations with the last point not yet solved
+        if (iterations == MAX_GJK_ITERATIONS) simplex = solved;
+
+        if (cache) {
+            cache->count = simplex.count;
+            for (int i = 0; i < simplex.count; i++) cache->directions[i] = simplex.v[i].direction;
+        }
+        return overlap;
+    }
+
+    // Expands GJK's final simplex over the Minkowski difference until its
+    // closest edge is on the boundary; that edge gives depth and normal
+    void RunEPA(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB,
+                const Simplex& simplex, GJK::Result& result) {
+        SupportPoint polytope[MAX_POLYTOPE];
+        int count = simplex.count;
+        for (int i = 0; i < count; i++) polytope[i] = simplex.v[i];
+
+        auto isNew = [&](const SupportPoint& s) {
+            for (int i = 0; i < count; i++)
+                if ((polytope[i].w - s.w).MagnitudeSquared() < DUPLICATE_SQUARED) return false;
+            return true;
+        };
+
+        // GJK can stop on a point or a segment when the shapes just touch
+        static const Vec2 axes[4] = { Vec2(1.f, 0.f), Vec2(-1.f, 0.f), Vec2(0.f, 1.f), Vec2(0.f, -1.f) };
+        for (int i = 0; i < 4 && count < 2; i++) {
+            SupportPoint s = MakeSupport(a, positionA, b, positionB, axes[i]);
+            if (isNew(s)) polytope[count++] = s;
+        }
+        if (count == 2) {
+            Vec2 side = (polytope[1].w - polytope[0].w).Perpendicular();
+            for (int i = 0; i < 2 && count < 3; i++, side = Vec2(-side.x, -side.y)) {
+                SupportPoint s = MakeSupport(a, positionA, b, positionB, side);
+                if (std::fabs((polytope[1].w - polytope[0].w).Cross(s.w - polytope[0].w)) > TOLERANCE)
+                    polytope[count++] = s;
+            }
+        }
+
+        result.depth = 0.f;
+        if (count < 3) {
+            // Degenerate (zero-area) difference: touching, nothing to push apart
+            Vec2 normal = positionB - positionA;
+            result.normal = normal.MagnitudeSquared() > 0.f ? normal.UnitVector() : Vec2(1.f, 0.f);
+            result.pointA = polytope[0].a;
+            result.pointB = polytope[0].b;
+            return;
+        }
+
+        // Counter-clockwise, so each edge's outward normal is (e.y, -e.x)
+        if ((polytope[1].w - polytope[0].w).Cross(polytope[2].w - polytope[0].w) < 0.f)
+            std::swap(polytope[1], polytope[2]);
+
+        int   edge = 0;
+        float distance = 0.f;
+        Vec2  normal;
+        for (int iteration = 0; ; iteration++) {
+            distance = std::numeric_limits<float>::max();
+            for (int i = 0; i < count; i++) {
+                const Vec2 e = polytope[(i + 1) % count].w - polytope[i].w;
+                const float length = e.Magnitude();
+                if (length == 0.f) continue;
+                const Vec2 n(e.y / length, -e.x / length);
+                const float d = n.Dot(polytope[i].w);
+                if (d < distance) { distance = d; normal = n; edge = i; }
+            }
+
+            if (iteration == MAX_EPA_ITERATIONS || count == MAX_POLYTOPE) break;
+
+            SupportPoint s = MakeSupport(a, positionA, b, positionB, normal);
+            if (s.w.Dot(normal) - distance < TOLERANCE || !isNew(s)) break;
+
+            for (int i = count; i > edge + 1; i--) polytope[i] = polytope[i - 1];
+            polytope[edge + 1] = s;
+            count++;
+        }
+
+        // Witness points at the origin's projection onto the closest edge
+        const SupportPoint& p0 = polytope[edge];
+        const SupportPoint& p1 = polytope[(edge + 1) % count];
+        const Vec2  e = p1.w - p0.w;
+        const float lengthSquared = e.MagnitudeSquared();
+        const float t = lengthSquared > 0.f ? std::clamp(-p0.w.Dot(e) / lengthSquared, 0.f, 1.f) : 0.f;
+
+        result.depth  = std::max(0.f, distance);
+        result.normal = normal;
+        result.pointA = p0.a + (p1.a - p0.a) * t;
+        result.pointB = p0.b + (p1.b - p0.b) * t;
+    }
+
+    GJK::Result Run(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB,
+                    GJK::SimplexCache* cache, bool penetration) {
+        GJK::Result result {};
+        Simplex simplex;
+        result.overlap = RunGJK(a, positionA, b, positionB, cache, simplex, result.iterations);
+
+        if (!result.overlap) {
+            simplex.Witness(result.pointA, result.pointB);
+            const Vec2 ab = result.pointB - result.pointA;
+            result.distance = ab.Magnitude();
+            result.normal = result.distance > 0.f ? ab / result.distance : Vec2(1.f, 0.f);
+            return result;
+        }
+
+        if (penetration)
+            RunEPA(a, positionA, b, positionB, simplex, result);
+        return result;
+    }
+}
+
+GJK::Result GJK::Query(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB, SimplexCache* cache) {
+    return Run(a, positionA, b, positionB, cache, true);
+}
+
+GJK::Result GJK::Distance(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB, SimplexCache* cache) {
+    return Run(a, positionA, b, positionB, cache, false);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Math/Vec2.h"
+#include "Shape.h"
+
+// General convex collision through the shapes' support functions: GJK for
+// the distance between two shapes and EPA for the penetration once they
+// overlap. Works for any pair of convex shapes, so it backs every pair that
+// has no hand-written routine in CollisionDetection.
+namespace GJK {
+    // Support directions of the simplex a query ended on. Starting the next
+    // query on the same pair from them usually converges in one or two steps,
+    // since bodies move little between frames.
+    struct SimplexCache {
+        Vec2     directions[3];
+        int      count = 0;
+        uint32_t lastUsed = 0; // lets the owner drop caches of pairs that drifted apart
+    };
+
+    struct Result {
+        bool  overlap;
+        float distance;   // between the shapes, 0 when they overlap
+        float depth;      // penetration along normal, when they overlap
+        Vec2  normal;     // unit, from a towards b
+        Vec2  pointA;     // on a: closest to b, or deepest inside b
+        Vec2  pointB;     // on b: closest to a, or deepest inside a
+        int   iterations;
+    };
+
+    // Closest points, or penetration depth and normal when the shapes
+    // overlap. cache may be null.
+    Result Query(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB, SimplexCache* cache);
+
+    // Distance only; skips EPA when the shapes overlap
+    Result Distance(const Shape& a, const Vec2& positionA, const Shape& b, const Vec2& positionB, SimplexCache* cache);
+}
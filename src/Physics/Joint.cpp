@@ -0,0 +1,422 @@
+#include "Joint.h"
+
+#include <cmath>
+
+#include "Constants.h"
+
+namespace {
+    // Largest position error one SolvePosition call corrects (pixels); the
+    // rest is left for later passes so a badly stretched joint cannot fling
+    constexpr float MAX_CORRECTION = 0.2f * Constants::PIXELS_PER_METER;
+
+    // One end of a joint as the solver sees it. Without a body, or with a
+    // static one, the end does not move.
+    struct Side {
+        Body* body;
+        float invMass, invI;
+        Vec2  r;      // from the body's position to the anchor
+        Vec2  point;  // the anchor in world space
+        float angle;
+    };
+
+    Side MakeSide(Body* body, const Vec2& localAnchor) {
+        if (!body) return { nullptr, 0.f, 0.f, Vec2(), localAnchor, 0.f };
+        const Vec2 r = localAnchor.Rotate(body->rotation);
+        const bool moves = !body->IsStatic();
+        return { moves ? body : nullptr, moves ? body->invMass : 0.f, moves ? body->invI : 0.f,
+                 r, body->position + r, body->rotation };
+    }
+
+    Vec2 Velocity(const Side& side) {
+        if (!side.body) return Vec2();
+        const float w = side.body->angularVelocity;
+        return side.body->velocity + Vec2(-w * side.r.y, w * side.r.x);
+    }
+
+    float AngularVelocity(const Side& side) {
+        return side.body ? side.body->angularVelocity : 0.f;
+    }
+
+    // Impulse at the anchor, plus an extra angular impulse
+    void Apply(const Side& side, const Vec2& impulse, float angular = 0.f) {
+        if (!side.body) return;
+        side.body->velocity += impulse * side.invMass;
+        side.body->angularVelocity += side.invI * (side.r.Cross(impulse) + angular);
+    }
+
+    // The same, applied to the pose directly
+    void Move(const Side& side, const Vec2& impulse, float angular = 0.f) {
+        if (!side.body) return;
+        side.body->position += impulse * side.invMass;
+        side.body->rotation += side.invI * (side.r.Cross(impulse) + angular);
+        side.body->shape->UpdateVertices(side.body->rotation, side.body->position);
+    }
+
+    Vec2 ClampLength(const Vec2& v, float maxLength) {
+        const float length = v.Magnitude();
+        return length > maxLength ? v * (maxLength / length) : v;
+    }
+
+    // Point constraint mass, K = [k11 k12; k12 k22], inverted onto rhs
+    Vec2 SolvePoint(const Side& a, const Side& b, const Vec2& rhs) {
+        const float mass = a.invMass + b.invMass;
+        const float k11 = mass + a.invI * a.r.y * a.r.y + b.invI * b.r.y * b.r.y;
+        const float k12 = -a.invI * a.r.x * a.r.y - b.invI * b.r.x * b.r.y;
+        const float k22 = mass + a.invI * a.r.x * a.r.x + b.invI * b.r.x * b.r.x;
+        float det = k11 * k22 - k12 * k12;
+        if (det == 0.f) return Vec2();
+        det = 1.f / det;
+        return Vec2(det * (k22 * rhs.x - k12 * rhs.y), det * (k11 * rhs.y - k12 * rhs.x));
+    }
+
+    // Keeps the bodies' angles apart by referenceAngle
+    void SolveAngleVelocity(const Side& a, const Side& b, float referenceAngle, const Softness& softness, float& accumulated) {
+        const float k = a.invI + b.invI;
+        if (k == 0.f) return;
+        const float error = b.angle - a.angle - referenceAngle;
+        const float wdot = AngularVelocity(b) - AngularVelocity(a);
+        const float impulse = -softness.massScale * (wdot + softness.biasRate * error) / k - softness.impulseScale * accumulated;
+        accumulated += impulse;
+        Apply(a, Vec2(), -impulse);
+        Apply(b, Vec2(), impulse);
+    }
+
+    void SolveAnglePosition(const Side& a, const Side& b, float referenceAngle, float fraction) {
+        const float k = a.invI + b.invI;
+        if (k == 0.f) return;
+        const float error = b.angle - a.angle - referenceAngle;
+        const float impulse = -fraction * error / k;
+        Move(a, Vec2(), -impulse);
+        Move(b, Vec2(), impulse);
+    }
+
+    void SolvePointVelocity(const Side& a, const Side& b, const Softness& softness, Vec2& accumulated) {
+        const Vec2 error = b.point - a.point;
+        const Vec2 cdot = Velocity(b) - Velocity(a);
+        const Vec2 impulse = SolvePoint(a, b, cdot + error * softness.biasRate) * -softness.massScale
+                           - accumulated * softness.impulseScale;
+        accumulated += impulse;
+        Apply(a, impulse * -1.f);
+        Apply(b, impulse);
+    }
+
+    // Row k of rows: the relative velocity of the anchors along direction,
+    // plus each body's spin through its lever arm
+    void SetRow(JointRows& rows, int k, const Vec2& direction, float armA, float armB, float error, float impulse) {
+        rows.ja[k][0] = -direction.x;
+        rows.ja[k][1] = -direction.y;
+        rows.ja[k][2] = -armA;
+        rows.jb[k][0] = direction.x;
+        rows.jb[k][1] = direction.y;
+        rows.jb[k][2] = armB;
+        rows.error[k] = error;
+        rows.impulse[k] = impulse;
+    }
+
+    void SetAngleRow(JointRows& rows, int k, const Side& a, const Side& b, float referenceAngle, float impulse) {
+        SetRow(rows, k, Vec2(), 1.f, 1.f, b.angle - a.angle - referenceAngle, impulse);
+    }
+
+    void SetPointRows(JointRows& rows, int k, const Side& a, const Side& b, const Vec2& impulse) {
+        const Vec2 error = b.point - a.point;
+        SetRow(rows, k, Vec2(1.f, 0.f), -a.r.y, -b.r.y, error.x, impulse.x);
+        SetRow(rows, k + 1, Vec2(0.f, 1.f), a.r.x, b.r.x, error.y, impulse.y);
+    }
+
+    void SolvePointPosition(const Side& a, const Side& b, float fraction) {
+        const Vec2 error = ClampLength(b.point - a.point, MAX_CORRECTION);
+        const Vec2 impulse = SolvePoint(a, b, error) * -fraction;
+        Move(a, impulse * -1.f);
+        Move(b, impulse);
+    }
+}
+
+const Softness Softness::RIGID = { 0.f, 1.f, 0.f };
+
+Softness Softness::Make(float hertz, float dampingRatio, float h) {
+    const float omega = 2.f * static_cast<float>(Constants::PI) * hertz;
+    const float a1 = 2.f * dampingRatio + h * omega;
+    const float a2 = h * omega * a1;
+    const float a3 = 1.f / (1.f + a2);
+    return { omega / a1, a2 * a3, a3 };
+}
+
+// === Joint ===
+Joint::Joint(Body* a, const Vec2& worldAnchorA, Body* b, const Vec2& worldAnchorB) : a(a), b(b) {
+    localAnchorA = a ? (worldAnchorA - a->position).Rotate(-a->rotation) : worldAnchorA;
+    localAnchorB = (worldAnchorB - b->position).Rotate(-b->rotation);
+}
+
+Vec2 Joint::AnchorA() const {
+    return a ? a->position + localAnchorA.Rotate(a->rotation) : localAnchorA;
+}
+
+Vec2 Joint::AnchorB() const {
+    return b->position + localAnchorB.Rotate(b->rotation);
+}
+
+// === DistanceJoint ===
+DistanceJoint::DistanceJoint(Body* a, const Vec2& worldAnchorA, Body* b, const Vec2& worldAnchorB)
+    : Joint(a, worldAnchorA, b, worldAnchorB), length((worldAnchorB - worldAnchorA).Magnitude()) {}
+
+JointType DistanceJoint::GetType() const {
+    return DISTANCE_JOINT;
+}
+
+void DistanceJoint::WarmStart() {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    Vec2 axis = sb.point - sa.point;
+    if (axis.Magnitude() == 0.f) return;
+    axis.Normalize();
+    Apply(sa, axis * -impulse);
+    Apply(sb, axis * impulse);
+}
+
+void DistanceJoint::SolveVelocity(const Softness& softness) {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    const Vec2  d = sb.point - sa.point;
+    const float current = d.Magnitude();
+    if (current == 0.f) return;
+    const Vec2  axis = d / current;
+    const float crA = sa.r.Cross(axis), crB = sb.r.Cross(axis);
+    const float k = sa.invMass + sb.invMass + sa.invI * crA * crA + sb.invI * crB * crB;
+    if (k == 0.f) return;
+
+    const float cdot = (Velocity(sb) - Velocity(sa)).Dot(axis);
+    const float step = -softness.massScale * (cdot + softness.biasRate * (current - length)) / k - softness.impulseScale * impulse;
+    impulse += step;
+    Apply(sa, axis * -step);
+    Apply(sb, axis * step);
+}
+
+void DistanceJoint::SolvePosition(float fraction) {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    const Vec2  d = sb.point - sa.point;
+    const float current = d.Magnitude();
+    if (current == 0.f) return;
+    const Vec2  axis = d / current;
+    const float crA = sa.r.Cross(axis), crB = sb.r.Cross(axis);
+    const float k = sa.invMass + sb.invMass + sa.invI * crA * crA + sb.invI * crB * crB;
+    if (k == 0.f) return;
+
+    const float error = std::fmax(-MAX_CORRECTION, std::fmin(MAX_CORRECTION, current - length));
+    const float step = -fraction * error / k;
+    Move(sa, axis * -step);
+    Move(sb, axis * step);
+}
+
+int DistanceJoint::Rows(JointRows& rows) const {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    const Vec2  d = sb.point - sa.point;
+    const float current = d.Magnitude();
+    rows.count = 1;
+    if (current == 0.f) {
+        SetRow(rows, 0, Vec2(), 0.f, 0.f, 0.f, impulse);
+        return rows.count;
+    }
+    const Vec2 axis = d / current;
+    SetRow(rows, 0, axis, sa.r.Cross(axis), sb.r.Cross(axis), current - length, impulse);
+    return rows.count;
+}
+
+void DistanceJoint::Accumulate(const float* step) {
+    impulse += step[0];
+}
+
+// === RevoluteJoint ===
+RevoluteJoint::RevoluteJoint(Body* a, Body* b, const Vec2& worldAnchor) : Joint(a, worldAnchor, b, worldAnchor) {}
+
+JointType RevoluteJoint::GetType() const {
+    return REVOLUTE_JOINT;
+}
+
+void RevoluteJoint::WarmStart() {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    Apply(sa, impulse * -1.f);
+    Apply(sb, impulse);
+}
+
+void RevoluteJoint::SolveVelocity(const Softness& softness) {
+    SolvePointVelocity(MakeSide(a, localAnchorA), MakeSide(b, localAnchorB), softness, impulse);
+}
+
+void RevoluteJoint::SolvePosition(float fraction) {
+    SolvePointPosition(MakeSide(a, localAnchorA), MakeSide(b, localAnchorB), fraction);
+}
+
+int RevoluteJoint::Rows(JointRows& rows) const {
+    rows.count = 2;
+    SetPointRows(rows, 0, MakeSide(a, localAnchorA), MakeSide(b, localAnchorB), impulse);
+    return rows.count;
+}
+
+void RevoluteJoint::Accumulate(const float* step) {
+    impulse += Vec2(step[0], step[1]);
+}
+
+// === PrismaticJoint ===
+PrismaticJoint::PrismaticJoint(Body* a, Body* b, const Vec2& worldAnchor, const Vec2& worldAxis)
+    : Joint(a, worldAnchor, b, worldAnchor) {
+    const float angleA = a ? a->rotation : 0.f;
+    localAxisA = worldAxis.Rotate(-angleA);
+    localAxisA.Normalize();
+    referenceAngle = b->rotation - angleA;
+}
+
+JointType PrismaticJoint::GetType() const {
+    return PRISMATIC_JOINT;
+}
+
+namespace {
+    // Direction across a prismatic axis, and the lever arms about it
+    struct Across {
+        Vec2  direction;
+        float armA, armB;
+        float mass;  // inverse of the effective mass, 0 when nothing can move
+        float error; // how far b's anchor is off the axis
+    };
+
+    Across MeasureAcross(const Side& a, const Side& b, const Vec2& localAxisA) {
+        const Vec2 axis = localAxisA.Rotate(a.angle);
+        Across across;
+        across.direction = Vec2(-axis.y, axis.x);
+        const Vec2 d = b.point - a.point;
+        across.armA = (d + a.r).Cross(across.direction);
+        across.armB = b.r.Cross(across.direction);
+        across.mass = a.invMass + b.invMass + a.invI * across.armA * across.armA + b.invI * across.armB * across.armB;
+        across.error = d.Dot(across.direction);
+        return across;
+    }
+}
+
+void PrismaticJoint::WarmStart() {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    const Across across = MeasureAcross(sa, sb, localAxisA);
+    const Vec2 d = sb.point - sa.point;
+    const Vec2 linear = across.direction * impulse;
+    Apply(sa, linear * -1.f, -d.Cross(linear) - angularImpulse);
+    Apply(sb, linear, angularImpulse);
+}
+
+void PrismaticJoint::SolveVelocity(const Softness& softness) {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    SolveAngleVelocity(sa, sb, referenceAngle, softness, angularImpulse);
+
+    const Across across = MeasureAcross(sa, sb, localAxisA);
+    if (across.mass == 0.f) return;
+    const Vec2  linearA = sa.body ? sa.body->velocity : Vec2();
+    const Vec2  linearB = sb.body ? sb.body->velocity : Vec2();
+    const float cdot = across.direction.Dot(linearB - linearA) + across.armB * AngularVelocity(sb) - across.armA * AngularVelocity(sa);
+    const float step = -softness.massScale * (cdot + softness.biasRate * across.error) / across.mass - softness.impulseScale * impulse;
+    impulse += step;
+
+    const Vec2 d = sb.point - sa.point;
+    const Vec2 linear = across.direction * step;
+    Apply(sa, linear * -1.f, -d.Cross(linear));
+    Apply(sb, linear);
+}
+
+void PrismaticJoint::SolvePosition(float fraction) {
+    Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    SolveAnglePosition(sa, sb, referenceAngle, fraction);
+
+    sa = MakeSide(a, localAnchorA);
+    sb = MakeSide(b, localAnchorB);
+    const Across across = MeasureAcross(sa, sb, localAxisA);
+    if (across.mass == 0.f) return;
+    const float error = std::fmax(-MAX_CORRECTION, std::fmin(MAX_CORRECTION, across.error));
+    const Vec2 d = sb.point - sa.point;
+    const Vec2 linear = across.direction * (-fraction * error / across.mass);
+    Move(sa, linear * -1.f, -d.Cross(linear));
+    Move(sb, linear);
+}
+
+int PrismaticJoint::Rows(JointRows& rows) const {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    const Across across = MeasureAcross(sa, sb, localAxisA);
+    rows.count = 2;
+    SetAngleRow(rows, 0, sa, sb, referenceAngle, angularImpulse);
+    SetRow(rows, 1, across.direction, across.armA, across.armB, across.error, impulse);
+    return rows.count;
+}
+
+void PrismaticJoint::Accumulate(const float* step) {
+    angularImpulse += step[0];
+    impulse += step[1];
+}
+
+// === WeldJoint ===
+WeldJoint::WeldJoint(Body* a, Body* b, const Vec2& worldAnchor)
+    : Joint(a, worldAnchor, b, worldAnchor), referenceAngle(b->rotation - (a ? a->rotation : 0.f)) {}
+
+JointType WeldJoint::GetType() const {
+    return WELD_JOINT;
+}
+
+void WeldJoint::WarmStart() {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    Apply(sa, impulse * -1.f, -angularImpulse);
+    Apply(sb, impulse, angularImpulse);
+}
+
+void WeldJoint::SolveVelocity(const Softness& softness) {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    SolveAngleVelocity(sa, sb, referenceAngle, softness, angularImpulse);
+    SolvePointVelocity(sa, sb, softness, impulse);
+}
+
+void WeldJoint::SolvePosition(float fraction) {
+    SolveAnglePosition(MakeSide(a, localAnchorA), MakeSide(b, localAnchorB), referenceAngle, fraction);
+    SolvePointPosition(MakeSide(a, localAnchorA), MakeSide(b, localAnchorB), fraction);
+}
+
+int WeldJoint::Rows(JointRows& rows) const {
+    const Side sa = MakeSide(a, localAnchorA), sb = MakeSide(b, localAnchorB);
+    rows.count = 3;
+    SetAngleRow(rows, 0, sa, sb, referenceAngle, angularImpulse);
+    SetPointRows(rows, 1, sa, sb, impulse);
+    return rows.count;
+}
+
+void WeldJoint::Accumulate(const float* step) {
+    angularImpulse += step[0];
+    impulse += Vec2(step[1], step[2]);
+}
+
+// === MouseJoint ===
+MouseJoint::MouseJoint(Body* b, const Vec2& worldAnchor, float maxForce)
+    : Joint(nullptr, worldAnchor, b, worldAnchor), maxForce(maxForce) {}
+
+void MouseJoint::SetTarget(const Vec2& target) {
+    localAnchorA = target;
+}
+
+JointType MouseJoint::GetType() const {
+    return MOUSE_JOINT;
+}
+
+void MouseJoint::Prepare(float h) {
+    spring = Softness::Make(hertz, dampingRatio, h);
+    maxImpulse = maxForce * h;
+}
+
+void MouseJoint::WarmStart() {
+    Apply(MakeSide(b, localAnchorB), impulse);
+}
+
+void MouseJoint::SolveVelocity(const Softness&) {
+    const Side sa = MakeSide(nullptr, localAnchorA), sb = MakeSide(b, localAnchorB);
+    const Vec2 error = sb.point - sa.point;
+    Vec2 step = SolvePoint(sa, sb, Velocity(sb) + error * spring.biasRate) * -spring.massScale
+              - impulse * spring.impulseScale;
+
+    // The total over the step is what is limited, not each pass
+    const Vec2 previous = impulse;
+    impulse = ClampLength(impulse + step, maxImpulse);
+    step = impulse - previous;
+    Apply(sb, step);
+}
+
+void MouseJoint::SolvePosition(float) {
+    // The spring already feeds the distance to the target back
+}
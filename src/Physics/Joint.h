@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Body.h"
+#include "Math/Vec2.h"
+
+enum JointType {
+  DISTANCE_JOINT,
+  REVOLUTE_JOINT,
+  PRISMATIC_JOINT,
+  WELD_JOINT,
+  MOUSE_JOINT
+};
+
+// Spring-damper feedback of a constraint's position error over a solve of
+// length h. RIGID removes relative velocity only, with no position feedback.
+struct Softness {
+    float biasRate, massScale, impulseScale;
+
+    static Softness Make(float hertz, float dampingRatio, float h);
+    static const Softness RIGID;
+};
+
+// A joint's constraint as rows of one linear system, for JointSolver. Row k
+// holds when ja[k] . (va.x, va.y, wa) + jb[k] . (vb.x, vb.y, wb) is zero;
+// error[k] is how far the pose is off along it and impulse[k] what the
+// joint has accumulated along it.
+struct JointRows {
+    int   count = 0;
+    float ja[3][3];
+    float jb[3][3];
+    float error[3];
+    float impulse[3];
+};
+
+// A constraint between two bodies, solved with the contacts: World applies
+// last step's impulses, then runs SolveVelocity in the same passes as the
+// contact impulses. Joints JointSolver takes are then put back in place
+// once per step; the ITERATIVE solver calls SolvePosition on the rest, as
+// contacts push overlap out, and SOFT_STEP feeds their position error
+// through Softness instead.
+//
+// Anchors are kept in each body's own frame. a may be null: b is then held
+// to a fixed point in the world, and localAnchorA is that point.
+struct Joint {
+    Body* a;
+    Body* b;
+    Vec2  localAnchorA;
+    Vec2  localAnchorB;
+    bool  collideConnected = false; // contacts between a and b are skipped otherwise
+
+    // Anchors given in world space, at the bodies' current pose
+    Joint(Body* a, const Vec2& worldAnchorA, Body* b, const Vec2& worldAnchorB);
+    virtual ~Joint() = default;
+
+    virtual JointType GetType() const = 0;
+
+    Vec2 AnchorA() const;
+    Vec2 AnchorB() const;
+
+    // The time step the next WarmStart and solves cover; only joints with
+    // their own spring or force limit need it
+    virtual void Prepare(float /*h*/) {}
+    // Apply the accumulated impulses again, as the starting guess
+    virtual void WarmStart() = 0;
+    virtual void SolveVelocity(const Softness& softness) = 0;
+    // Move the bodies a fraction of the way to where the joint holds
+    virtual void SolvePosition(float fraction) = 0;
+
+    // The rows at the bodies' current pose; 0 keeps the joint out of
+    // JointSolver, which then leaves it to the sweeps
+    virtual int Rows(JointRows& /*rows*/) const { return 0; }
+    // Add impulses JointSolver applied, one per row, to the accumulated ones
+    virtual void Accumulate(const float* /*impulse*/) {}
+};
+
+// Holds the anchors at the distance they were made at, like a rigid rod
+struct DistanceJoint : public Joint {
+    float length;
+    float impulse = 0.f;
+
+    DistanceJoint(Body* a, const Vec2& worldAnchorA, Body* b, const Vec2& worldAnchorB);
+    JointType GetType() const override;
+    void WarmStart() override;
+    void SolveVelocity(const Softness& softness) override;
+    void SolvePosition(float fraction) override;
+    int  Rows(JointRows& rows) const override;
+    void Accumulate(const float* step) override;
+};
+
+// Pins one point of each body together; they turn freely about it
+struct RevoluteJoint : public Joint {
+    Vec2 impulse;
+
+    RevoluteJoint(Body* a, Body* b, const Vec2& worldAnchor);
+    JointType GetType() const override;
+    void WarmStart() override;
+    void SolveVelocity(const Softness& softness) override;
+    void SolvePosition(float fraction) override;
+    int  Rows(JointRows& rows) const override;
+    void Accumulate(const float* step) override;
+};
+
+// b slides along an axis fixed in a and keeps its angle to a
+struct PrismaticJoint : public Joint {
+    Vec2  localAxisA;     // unit, in a's frame
+    float referenceAngle;
+    float impulse = 0.f;  // across the axis
+    float angularImpulse = 0.f;
+
+    PrismaticJoint(Body* a, Body* b, const Vec2& worldAnchor, const Vec2& worldAxis);
+    JointType GetType() const override;
+    void WarmStart() override;
+    void SolveVelocity(const Softness& softness) override;
+    void SolvePosition(float fraction) override;
+    int  Rows(JointRows& rows) const override;
+    void Accumulate(const float* step) override;
+};
+
+// Pulls a point of b towards a target through its own spring, with at most
+// maxForce, whatever Softness the solver passes. a is always null and
+// localAnchorA is the target; move it with SetTarget. Dragging through it
+// moves a body like any other force would, so it still stops at what it is
+// pushed into.
+struct MouseJoint : public Joint {
+    float maxForce;
+    float hertz = 5.f;
+    float dampingRatio = 0.7f;
+    Vec2  impulse;
+
+    MouseJoint(Body* b, const Vec2& worldAnchor, float maxForce);
+    void SetTarget(const Vec2& target);
+    JointType GetType() const override;
+    void Prepare(float h) override;
+    void WarmStart() override;
+    void SolveVelocity(const Softness& softness) override;
+    void SolvePosition(float fraction) override;
+
+private:
+    Softness spring = Softness::RIGID;
+    float    maxImpulse = 0.f;
+};
+
+// Holds b fixed relative to a
+struct WeldJoint : public Joint {
+    float referenceAngle;
+    Vec2  impulse;
+    float angularImpulse = 0.f;
+
+    WeldJoint(Body* a, Body* b, const Vec2& worldAnchor);
+    JointType GetType() const override;
+    void WarmStart() override;
+    void SolveVelocity(const Softness& softness) override;
+    void SolvePosition(float fraction) override;
+    int  Rows(JointRows& rows) const override;
+    void Accumulate(const float* step) override;
+};
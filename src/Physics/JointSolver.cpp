@@ -0,0 +1,353 @@
+#include "JointSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Newton steps per joint in SolvePosition; a child's rows hold to first
+    // order, and a turn of a tenth of a radian already leaves them off
+    constexpr int POSITION_STEPS = 3;
+
+    bool Moves(const Body* body) {
+        return body && !body->IsStatic();
+    }
+
+    // The row's entries for body's velocities; a body that cannot turn has
+    // no angular entry
+    void Entries(const JointRows& rows, int k, const Joint& joint, const Body* body, float out[3]) {
+        const float* row = body == joint.a ? rows.ja[k] : rows.jb[k];
+        out[0] = row[0];
+        out[1] = row[1];
+        out[2] = body->invI > 0.f ? row[2] : 0.f;
+    }
+
+    // Inverse of the leading size x size block of m, in place. A singular
+    // block, from a row that no moving body can satisfy, keeps only the
+    // rows that can.
+    void Invert(float m[3][3], int size) {
+        float inverse[3][3] = {};
+        float det = 0.f;
+        if (size == 1) {
+            det = m[0][0];
+            if (det != 0.f) inverse[0][0] = 1.f / det;
+        } else if (size == 2) {
+            det = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+            if (det != 0.f) {
+                det = 1.f / det;
+                inverse[0][0] = det * m[1][1];
+                inverse[0][1] = -det * m[0][1];
+                inverse[1][0] = -det * m[1][0];
+                inverse[1][1] = det * m[0][0];
+            }
+        } else {
+            const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+            const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+            const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+            det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+            if (det != 0.f) {
+                det = 1.f / det;
+                inverse[0][0] = det * c00;
+                inverse[0][1] = det * (m[0][2] * m[2][1] - m[0][1] * m[2][2]);
+                inverse[0][2] = det * (m[0][1] * m[1][2] - m[0][2] * m[1][1]);
+                inverse[1][0] = det * c01;
+                inverse[1][1] = det * (m[0][0] * m[2][2] - m[0][2] * m[2][0]);
+                inverse[1][2] = det * (m[0][2] * m[1][0] - m[0][0] * m[1][2]);
+                inverse[2][0] = det * c02;
+                inverse[2][1] = det * (m[0][1] * m[2][0] - m[0][0] * m[2][1]);
+                inverse[2][2] = det * (m[0][0] * m[1][1] - m[0][1] * m[1][0]);
+            }
+        }
+        if (det == 0.f)
+            for (int i = 0; i < size; i++) inverse[i][i] = m[i][i] != 0.f ? 1.f / m[i][i] : 0.f;
+        std::copy(&inverse[0][0], &inverse[0][0] + 9, &m[0][0]);
+    }
+}
+
+void JointSolver::Build(const std::vector<Joint*>& joints) {
+    tree.clear();
+    loose.clear();
+    bodies.clear();
+    bodyNodes.clear();
+    setOf.clear();
+
+    auto nodeOf = [&](Body* body) {
+        auto [it, added] = bodyNodes.emplace(body, static_cast<int>(bodies.size()));
+        if (added) {
+            bodies.push_back(body);
+            setOf.push_back(it->second);
+        }
+        return it->second;
+    };
+    auto find = [&](int i) {
+        while (setOf[i] != i) i = setOf[i] = setOf[setOf[i]];
+        return i;
+    };
+
+    JointRows rows;
+    for (Joint* joint : joints) {
+        const bool movesA = Moves(joint->a), movesB = Moves(joint->b);
+        if ((!movesA && !movesB) || joint->Rows(rows) == 0) {
+            loose.push_back(joint);
+            continue;
+        }
+        const int nodeA = movesA ? nodeOf(joint->a) : -1;
+        const int nodeB = movesB ? nodeOf(joint->b) : -1;
+        if (movesA && movesB) {
+            const int setA = find(nodeA), setB = find(nodeB);
+            if (setA == setB) {
+                loose.push_back(joint); // closes a loop
+                continue;
+            }
+            setOf[setA] = setB;
+        }
+        tree.push_back(joint);
+    }
+    // The graph: body nodes first, then joint nodes, each joint linked to
+    // the moving bodies it holds
+    const int bodyCount = static_cast<int>(bodies.size());
+    const int count = bodyCount + static_cast<int>(tree.size());
+    firstEdge.assign(count + 1, 0);
+    auto forEachLink = [&](auto fn) {
+        for (int t = 0; t < static_cast<int>(tree.size()); t++) {
+            if (Moves(tree[t]->a)) fn(bodyCount + t, bodyNodes[tree[t]->a]);
+            if (Moves(tree[t]->b)) fn(bodyCount + t, bodyNodes[tree[t]->b]);
+        }
+    };
+    forEachLink([&](int joint, int body) {
+        firstEdge[joint + 1]++;
+        firstEdge[body + 1]++;
+    });
+    for (int i = 0; i < count; i++) firstEdge[i + 1] += firstEdge[i];
+    edges.resize(firstEdge[count]);
+    queue.assign(firstEdge.begin(), firstEdge.end() - 1); // next free edge per node
+    forEachLink([&](int joint, int body) {
+        edges[queue[joint]++] = body;
+        edges[queue[body]++] = joint;
+    });
+
+    // Each tree breadth first from its first joint, so parents come before
+    // their children
+    jointRows.resize(tree.size());
+    nodes.clear();
+    placed.assign(count, -1);
+    for (int start = bodyCount; start < count; start++) {
+        if (placed[start] >= 0) continue;
+        queue.clear();
+        queue.push_back(start);
+        placed[start] = static_cast<int>(nodes.size());
+        for (size_t next = 0; next < queue.size(); next++) {
+            const int g = queue[next];
+            Node node {};
+            node.parent = -1;
+            for (int e = firstEdge[g]; e < firstEdge[g + 1]; e++) {
+                const int neighbour = edges[e];
+                if (placed[neighbour] < 0) {
+                    placed[neighbour] = static_cast<int>(nodes.size() + queue.size() - next);
+                    queue.push_back(neighbour);
+                } else if (placed[neighbour] < placed[g]) {
+                    node.parent = placed[neighbour];
+                }
+            }
+            if (g < bodyCount) {
+                node.body = bodies[g];
+                node.rows = -1;
+                node.size = 3;
+            } else {
+                node.body = nullptr;
+                node.rows = g - bodyCount;
+                node.size = tree[node.rows]->Rows(jointRows[node.rows]);
+            }
+            nodes.push_back(node);
+        }
+    }
+}
+
+
+void JointSolver::Factor(float compliance) {
+    for (size_t t = 0; t < tree.size(); t++) tree[t]->Rows(jointRows[t]);
+
+    // Each node's own block, and its link to its parent: a body's is its
+    // mass, a joint's its compliance; between them the joint's rows, negated
+    for (Node& node : nodes) {
+        std::fill(&node.inverse[0][0], &node.inverse[0][0] + 9, 0.f);
+        std::fill(&node.link[0][0], &node.link[0][0] + 9, 0.f);
+        if (node.body) {
+            node.inverse[0][0] = node.inverse[1][1] = 1.f / node.body->invMass;
+            node.inverse[2][2] = node.body->invI > 0.f ? 1.f / node.body->invI : 1.f;
+            if (node.parent < 0) continue;
+            const Node& joint = nodes[node.parent];
+            for (int k = 0; k < joint.size; k++) {
+                float entries[3];
+                Entries(jointRows[joint.rows], k, *tree[joint.rows], node.body, entries);
+                for (int c = 0; c < 3; c++) node.link[c][k] = -entries[c];
+            }
+            continue;
+        }
+
+        const Joint&     joint = *tree[node.rows];
+        const JointRows& rows = jointRows[node.rows];
+        for (Body* body : { joint.a, joint.b }) {
+            if (!Moves(body)) continue;
+            const float weights[3] = { body->invMass, body->invMass, body->invI };
+            float entries[3][3];
+            for (int k = 0; k < node.size; k++) Entries(rows, k, joint, body, entries[k]);
+            for (int i = 0; i < node.size; i++)
+                for (int j = 0; j < node.size; j++)
+                    for (int c = 0; c < 3; c++)
+                        node.inverse[i][j] -= compliance * entries[i][c] * weights[c] * entries[j][c];
+            if (node.parent >= 0 && nodes[node.parent].body == body)
+                for (int k = 0; k < node.size; k++)
+                    for (int c = 0; c < 3; c++) node.link[k][c] = -entries[k][c];
+        }
+    }
+
+    // Leaves first, each node eliminated into its parent
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        Invert(node.inverse, node.size);
+        if (node.parent < 0) continue;
+        Node& parent = nodes[node.parent];
+        for (int r = 0; r < node.size; r++)
+            for (int c = 0; c < parent.size; c++) {
+                float sum = 0.f;
+                for (int k = 0; k < node.size; k++) sum += node.inverse[r][k] * node.link[k][c];
+                node.scaled[r][c] = sum;
+            }
+        for (int r = 0; r < parent.size; r++)
+            for (int c = 0; c < parent.size; c++) {
+                float sum = 0.f;
+                for (int k = 0; k < node.size; k++) sum += node.link[k][r] * node.scaled[k][c];
+                parent.inverse[r][c] -= sum;
+            }
+    }
+}
+
+void JointSolver::Solve() {
+    for (size_t i = nodes.size(); i-- > 0;) {
+        const Node& node = nodes[i];
+        if (node.parent < 0) continue;
+        Node& parent = nodes[node.parent];
+        for (int c = 0; c < parent.size; c++)
+            for (int k = 0; k < node.size; k++) parent.x[c] -= node.scaled[k][c] * node.x[k];
+    }
+    for (Node& node : nodes) {
+        float x[3] = {};
+        for (int r = 0; r < node.size; r++)
+            for (int k = 0; k < node.size; k++) x[r] += node.inverse[r][k] * node.x[k];
+        if (node.parent >= 0) {
+            const Node& parent = nodes[node.parent];
+            for (int r = 0; r < node.size; r++)
+                for (int k = 0; k < parent.size; k++) x[r] -= node.scaled[r][k] * parent.x[k];
+        }
+        std::copy(x, x + 3, node.x);
+    }
+}
+
+void JointSolver::SolveVelocity(const Softness& softness) {
+    if (nodes.empty()) return;
+    // A soft joint holds where its velocity error, plus its bias, plus
+    // compliance times its own effective mass times its accumulated
+    // impulse, is zero, as its own SolveVelocity converges to
+    const float compliance = softness.massScale > 0.f ? softness.impulseScale / softness.massScale : 0.f;
+    Factor(compliance);
+
+    for (Node& node : nodes) {
+        std::fill(node.x, node.x + 3, 0.f);
+        if (node.body) continue;
+        const Joint&     joint = *tree[node.rows];
+        const JointRows& rows = jointRows[node.rows];
+        for (int k = 0; k < node.size; k++) node.x[k] = softness.biasRate * rows.error[k];
+        for (Body* body : { joint.a, joint.b }) {
+            if (!Moves(body)) continue;
+            const float velocity[3] = { body->velocity.x, body->velocity.y, body->angularVelocity };
+            const float weights[3] = { body->invMass, body->invMass, body->invI };
+            float entries[3][3];
+            for (int k = 0; k < node.size; k++) Entries(rows, k, joint, body, entries[k]);
+            for (int k = 0; k < node.size; k++)
+                for (int c = 0; c < 3; c++) {
+                    node.x[k] += entries[k][c] * velocity[c];
+                    for (int j = 0; j < node.size; j++)
+                        node.x[k] += compliance * entries[k][c] * weights[c] * entries[j][c] * rows.impulse[j];
+                }
+        }
+    }
+    Solve();
+
+    for (Node& node : nodes) {
+        if (!node.body) {
+            tree[node.rows]->Accumulate(node.x);
+            continue;
+        }
+        node.body->velocity += Vec2(node.x[0], node.x[1]);
+        if (node.body->invI > 0.f) node.body->angularVelocity += node.x[2];
+    }
+}
+
+void JointSolver::SolvePosition(float fraction) {
+    // Parents first, so each joint moves only its child, which carries
+    // everything below it along on the child's own joints. Spreading the
+    // correction over the whole tree by mass instead turned a stretched,
+    // tilted chain's error into large turns its rows only hold to first
+    // order, and the passes grew the error they were meant to remove.
+    JointRows rows;
+    for (const Node& node : nodes) {
+        if (node.body) continue;
+        Joint& joint = *tree[node.rows];
+        const Body* parent = node.parent >= 0 ? nodes[node.parent].body : nullptr;
+        Body* child = nullptr;
+        if (parent) child = joint.a == parent ? joint.b : joint.a;
+        else if (!Moves(joint.a) || !Moves(joint.b)) child = Moves(joint.a) ? joint.a : joint.b;
+        // A root between two moving bodies, or a joint back to the world at
+        // a tree's far end, has no child of its own to move
+        if (!Moves(child)) {
+            joint.SolvePosition(fraction);
+            continue;
+        }
+
+        // Newton steps on the child alone, towards the fraction of the
+        // error the joint started with. Rows that only hold its angle are
+        // met by turning it; the rest by moving it, never by turning, since
+        // a turn met a row to first order only and a long chain's child can
+        // be many times its arm out of place once its parent was moved.
+        int count = joint.Rows(rows);
+        float target[3];
+        for (int k = 0; k < count; k++) target[k] = (1.f - fraction) * rows.error[k];
+        for (int step = 0; step < POSITION_STEPS; step++) {
+            float entries[3][3];
+            if (child->invI > 0.f) {
+                if (step > 0) joint.Rows(rows);
+                for (int k = 0; k < count; k++) {
+                    Entries(rows, k, joint, child, entries[k]);
+                    if (entries[k][0] == 0.f && entries[k][1] == 0.f && entries[k][2] != 0.f)
+                        child->rotation -= (rows.error[k] - target[k]) / entries[k][2];
+                }
+            }
+            joint.Rows(rows);
+
+            float mass[3][3] = {};
+            bool  turns[3];
+            for (int k = 0; k < count; k++) {
+                Entries(rows, k, joint, child, entries[k]);
+                turns[k] = entries[k][0] == 0.f && entries[k][1] == 0.f;
+            }
+            for (int i = 0; i < count; i++)
+                for (int j = 0; j < count; j++)
+                    if (!turns[i] && !turns[j])
+                        for (int c = 0; c < 2; c++) mass[i][j] += entries[i][c] * child->invMass * entries[j][c];
+            for (int k = 0; k < count; k++)
+                if (turns[k]) mass[k][k] = 1.f; // keeps the moved rows' block whole
+            Invert(mass, count);
+
+            Vec2 move;
+            for (int i = 0; i < count; i++) {
+                if (turns[i]) continue;
+                float lambda = 0.f;
+                for (int j = 0; j < count; j++)
+                    if (!turns[j]) lambda -= mass[i][j] * (rows.error[j] - target[j]);
+                move += Vec2(entries[i][0], entries[i][1]) * (child->invMass * lambda);
+            }
+            child->position += move;
+            child->shape->UpdateVertices(child->rotation, child->position);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Joint.h"
+
+// Solves the joints that form trees, such as chains, ropes and ragdolls,
+// exactly and in time linear in their number (Baraff, "Linear-Time Dynamics
+// using Lagrange Multipliers", 1996). Sweeping joints one at a time passes
+// a chain's tension only one link further per sweep, so a long chain
+// stretches and springs back like a bungee however many passes it gets;
+// solved as one system it holds at any pass count.
+//
+// Moving bodies and joints are the nodes of one sparse system, each joint
+// linked to the bodies it holds. A joint that would close a loop, or has no
+// rows (the force-limited mouse joint), stays out of it and is left in
+// Loose() for the sweeps.
+struct JointSolver {
+    // Take the joints that fit in the trees; call again once joints were
+    // added or removed, or bodies made static, before solving
+    void Build(const std::vector<Joint*>& joints);
+
+    const std::vector<Joint*>& Loose() const { return loose; }
+
+    // Impulses after which every tree joint holds, at its softness, added
+    // to the bodies' velocities and the joints' accumulated impulses
+    void SolveVelocity(const Softness& softness);
+
+    // Move the tree bodies a fraction of the way to where their joints hold,
+    // each joint moving only the body on its far side from the tree's root
+    void SolvePosition(float fraction);
+
+private:
+    struct Node {
+        Body*  body;      // a body node, or
+        int    rows;      // a joint node: its index into tree and jointRows
+        int    size;      // unknowns: 3 for a body, the joint's row count
+        int    parent;    // index into nodes, -1 at a root
+        float  inverse[3][3];   // of the node's block, less what its children eliminated
+        float  link[3][3];      // system block between this node and its parent
+        float  scaled[3][3];    // inverse * link
+        float  x[3];
+    };
+
+    // Eliminate the trees, leaves first, for a system whose joint blocks are
+    // compliance times the joint's own effective mass
+    void Factor(float compliance);
+    // x of every node from its right-hand side, already in x
+    void Solve();
+
+    std::vector<Joint*>    tree;
+    std::vector<Joint*>    loose;
+    std::vector<JointRows> jointRows;
+    std::vector<Node>      nodes;      // parents before children
+    std::vector<int>       setOf;      // union-find over body nodes, while building
+    std::vector<Body*>     bodies;     // the body nodes' bodies, while building
+    std::unordered_map<const Body*, int> bodyNodes;
+    std::vector<int>       edges;      // per graph node, its neighbours, while building
+    std::vector<int>       firstEdge;
+    std::vector<int>       queue;
+    std::vector<int>       placed;     // per graph node, its index into nodes
+};
@@ -1,12 +1,14 @@
 #include "Shape.h"
+#include "Body.h"
 #include "Math/Vec2.h"
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
 
 float PolygonShape::Moi::density = 1.0f;
 
-CircleShape::CircleShape(float radius):radius(radius){}
+CircleShape::CircleShape(float radius):Shape(CIRCLE), radius(radius){}
 
 CircleShape::~CircleShape() {
 }
@@ -19,15 +21,63 @@ void CircleShape::UpdateVertices(float angle, const Vec2& position) {
     return; // Circles don't have vertices... nothing to do here
 }
 
-ShapeType CircleShape::GetType() const {
-    return CIRCLE;
-}
-
 float CircleShape::GetMomentOfInertia() const {
     return 0.5 * (radius * radius);
 }
 
-PolygonShape::PolygonShape(int sides, float radius):sides(sides), radius(radius){
+AABB CircleShape::GetAABB(const Vec2& position) const {
+    return { Vec2(position.x - radius, position.y - radius), Vec2(position.x + radius, position.y + radius) };
+}
+
+Vec2 CircleShape::Support(const Vec2& direction, const Vec2& position) const {
+    float length = direction.Magnitude();
+    if (length == 0.f) return Vec2(position.x + radius, position.y);
+    return position + direction * (radius / length);
+}
+
+CapsuleShape::CapsuleShape(float length, float radius):Shape(CAPSULE), length(length), radius(radius),
+    worldA(-length * 0.5f, 0.f), worldB(length * 0.5f, 0.f){}
+
+CapsuleShape::~CapsuleShape() {
+}
+
+Shape* CapsuleShape::Clone() const {
+    return new CapsuleShape(length, radius);
+}
+
+void CapsuleShape::UpdateVertices(float angle, const Vec2& position) {
+    // One rotation for both end points, against four for a box
+    Vec2 halfAxis(cosf(angle) * length * 0.5f, sinf(angle) * length * 0.5f);
+    worldA = position - halfAxis;
+    worldB = position + halfAxis;
+}
+
+float CapsuleShape::GetMomentOfInertia() const {
+    // Rectangle between the end points plus two half discs, weighted by area
+    const float pi = static_cast<float>(Constants::PI);
+    float rectArea = 2.f * radius * length;
+    float discArea = pi * radius * radius;
+    float rectI = (length * length + 4.f * radius * radius) / 12.f;
+    // Half disc centroid sits 4r/3pi beyond the end point; parallel axis theorem
+    float offset = 4.f * radius / (3.f * pi);
+    float discI = 0.5f * radius * radius + 0.25f * length * length + length * offset;
+    float area = rectArea + discArea;
+    return area > 0.f ? (rectArea * rectI + discArea * discI) / area : 0.f;
+}
+
+AABB CapsuleShape::GetAABB(const Vec2& /*position*/) const {
+    return { Vec2(std::min(worldA.x, worldB.x) - radius, std::min(worldA.y, worldB.y) - radius),
+             Vec2(std::max(worldA.x, worldB.x) + radius, std::max(worldA.y, worldB.y) + radius) };
+}
+
+Vec2 CapsuleShape::Support(const Vec2& direction, const Vec2& /*position*/) const {
+    Vec2 end = worldA.Dot(direction) > worldB.Dot(direction) ? worldA : worldB;
+    float magnitude = direction.Magnitude();
+    if (magnitude == 0.f) return end;
+    return end + direction * (radius / magnitude);
+}
+
+PolygonShape::PolygonShape(int sides, float radius):Shape(POLYGON), sides(sides), radius(radius), regular(true){
   
     for (int i = 0; i < sides; i++) {
         float angle = (2.0f * Constants::PI * i) / sides;
@@ -36,16 +86,24 @@ PolygonShape::PolygonShape(int sides, float radius):sides(sides), radius(radius)
     }
 }
 
-PolygonShape::~PolygonShape() {
+PolygonShape::PolygonShape(const std::vector<Vec2>& vertices):Shape(POLYGON), sides(static_cast<int>(vertices.size())), radius(0.f), localVertices(vertices), worldVertices(vertices) {
+    // Edge normals point outwards only for this winding
+    float area = 0.f;
+    for (size_t i = 0; i < vertices.size(); i++) area += vertices[i].Cross(vertices[(i + 1) % vertices.size()]);
+    if (area < 0.f) {
+        std::reverse(localVertices.begin(), localVertices.end());
+        worldVertices = localVertices;
+    }
+    for (const Vec2& v : vertices) radius = std::max(radius, v.Magnitude());
 }
 
-ShapeType PolygonShape::GetType() const {
-    return POLYGON;
+PolygonShape::~PolygonShape() {
 }
 
 
 Shape* PolygonShape::Clone() const {
-    return new PolygonShape(sides, radius);
+    if (regular) return new PolygonShape(sides, radius);
+    return new PolygonShape(localVertices);
 }
 
 float PolygonShape::GetMomentOfInertia() const {
@@ -57,6 +115,35 @@ float PolygonShape::GetMomentOfInertia() const {
 }
 
 
+AABB PolygonShape::GetAABB(const Vec2& position) const {
+    // World vertices are refreshed by UpdateVertices before collision checks
+    if (worldVertices.empty()) return { position, position };
+
+    AABB box { worldVertices[0], worldVertices[0] };
+    for (const Vec2& v : worldVertices) {
+        box.min.x = std::min(box.min.x, v.x);
+        box.min.y = std::min(box.min.y, v.y);
+        box.max.x = std::max(box.max.x, v.x);
+        box.max.y = std::max(box.max.y, v.y);
+    }
+    return box;
+}
+
+Vec2 PolygonShape::Support(const Vec2& direction, const Vec2& position) const {
+    // World vertices already include the position
+    if (worldVertices.empty()) return position;
+    size_t best = 0;
+    float bestProjection = worldVertices[0].Dot(direction);
+    for (size_t i = 1; i < worldVertices.size(); i++) {
+        float projection = worldVertices[i].Dot(direction);
+        if (projection > bestProjection) {
+            bestProjection = projection;
+            best = i;
+        }
+    }
+    return worldVertices[best];
+}
+
 Vec2 PolygonShape::GetEdge(int index) const {
     int currVertex = index;
     int nextVertex = (index + 1) % worldVertices.size();
@@ -146,7 +233,7 @@ float PolygonShape::Moi::CalculatePolygonMomentOfInertia(const std::vector<Vec2>
     return (mass / 6.0f) * (numerator / denominator);
 }
 
-BoxShape::BoxShape(float width, float height) {
+BoxShape::BoxShape(float width, float height):PolygonShape(BOX) {
     this->width = width; 
     this->height = height; 
 
@@ -170,10 +257,6 @@ BoxShape::~BoxShape() {
    
 }
 
-ShapeType BoxShape::GetType() const {
-    return BOX;
-}
-
 Shape* BoxShape::Clone() const {
     return new BoxShape(width, height);
 }
@@ -182,3 +265,236 @@ float BoxShape::GetMomentOfInertia() const {
     return (0.083333) * (width * width + height * height);
 }
 
+
+ChainShape::ChainShape(const std::vector<Vec2>& points, bool loop):Shape(CHAIN), localPoints(points), worldPoints(points), loop(loop) {
+    builtPosition = Vec2(0.f, 0.f);
+    BuildTree();
+}
+
+ChainShape::~ChainShape() {
+}
+
+Shape* ChainShape::Clone() const {
+    return new ChainShape(localPoints, loop);
+}
+
+void ChainShape::UpdateVertices(float angle, const Vec2& position) {
+    // Chains are static, so this is a no-op after the first step
+    if (angle == builtAngle && position.x == builtPosition.x && position.y == builtPosition.y) return;
+
+    const float c = cosf(angle), s = sinf(angle);
+    for (size_t i = 0; i < localPoints.size(); i++) {
+        const Vec2& p = localPoints[i];
+        worldPoints[i] = Vec2(p.x * c - p.y * s + position.x, p.x * s + p.y * c + position.y);
+    }
+    builtAngle = angle;
+    builtPosition = position;
+    BuildTree();
+}
+
+float ChainShape::GetMomentOfInertia() const {
+    return 0.f; // static only
+}
+
+AABB ChainShape::GetAABB(const Vec2& position) const {
+    if (tree.Empty()) return { position, position };
+    return tree.Bounds();
+}
+
+Vec2 ChainShape::Support(const Vec2& direction, const Vec2& position) const {
+    // Support of the convex hull; chains are not convex, so GJK never sees them
+    if (worldPoints.empty()) return position;
+    size_t best = 0;
+    for (size_t i = 1; i < worldPoints.size(); i++)
+        if (worldPoints[i].Dot(direction) > worldPoints[best].Dot(direction)) best = i;
+    return worldPoints[best];
+}
+
+int ChainShape::SegmentCount() const {
+    const int count = static_cast<int>(worldPoints.size());
+    if (count < 2) return 0;
+    return loop && count > 2 ? count : count - 1;
+}
+
+void ChainShape::GetSegment(int index, Vec2& start, Vec2& end) const {
+    start = worldPoints[index];
+    end = worldPoints[(index + 1) % worldPoints.size()];
+}
+
+bool ChainShape::GetPreviousGhost(int index, Vec2& ghost) const {
+    const int count = static_cast<int>(worldPoints.size());
+    if (index == 0 && SegmentCount() != count) return false;
+    ghost = worldPoints[(index + count - 1) % count];
+    return true;
+}
+
+bool ChainShape::GetNextGhost(int index, Vec2& ghost) const {
+    const int count = static_cast<int>(worldPoints.size());
+    if (index + 2 >= count && SegmentCount() != count) return false;
+    ghost = worldPoints[(index + 2) % count];
+    return true;
+}
+
+void ChainShape::BuildTree() {
+    const int segmentCount = SegmentCount();
+    std::vector<AABB> bounds(segmentCount);
+    for (int i = 0; i < segmentCount; i++) {
+        Vec2 start, end;
+        GetSegment(i, start, end);
+        bounds[i] = { Vec2(std::min(start.x, end.x), std::min(start.y, end.y)),
+                      Vec2(std::max(start.x, end.x), std::max(start.y, end.y)) };
+    }
+    tree.Build(bounds);
+}
+
+
+namespace {
+    constexpr float CENTROID_EPSILON = 1e-3f; // pixels
+
+    float ChildArea(const Shape& shape) {
+        const float pi = static_cast<float>(Constants::PI);
+        switch (shape.GetType()) {
+            case CIRCLE: {
+                const float r = static_cast<const CircleShape&>(shape).radius;
+                return pi * r * r;
+            }
+            case CAPSULE: {
+                const CapsuleShape& capsule = static_cast<const CapsuleShape&>(shape);
+                return 2.f * capsule.radius * capsule.length + pi * capsule.radius * capsule.radius;
+            }
+            case BOX: {
+                const BoxShape& box = static_cast<const BoxShape&>(shape);
+                return box.width * box.height;
+            }
+            case POLYGON:
+                return PolygonShape::Moi::PolygonArea(static_cast<const PolygonShape&>(shape).localVertices);
+            default:
+                return 0.f;
+        }
+    }
+
+    // Per unit mass about the child's own origin
+    float ChildMoment(const Shape& shape) {
+        // PolygonShape's own value is scaled by its area, not per unit mass
+        if (shape.GetType() == POLYGON)
+            return PolygonShape::Moi::CalculatePolygonMomentOfInertia(static_cast<const PolygonShape&>(shape).localVertices, 1.f);
+        return shape.GetMomentOfInertia();
+    }
+
+    // Bounds of box's corners after rotating by angle and moving by translation
+    AABB TransformBox(const AABB& box, float angle, const Vec2& translation) {
+        const Vec2 corners[4] = { box.min, Vec2(box.max.x, box.min.y), box.max, Vec2(box.min.x, box.max.y) };
+        AABB result;
+        for (int i = 0; i < 4; i++) {
+            const Vec2 p = corners[i].Rotate(angle) + translation;
+            if (i == 0) { result = { p, p }; continue; }
+            result.min = Vec2(std::min(result.min.x, p.x), std::min(result.min.y, p.y));
+            result.max = Vec2(std::max(result.max.x, p.x), std::max(result.max.y, p.y));
+        }
+        return result;
+    }
+}
+
+CompoundShape::CompoundShape(const std::vector<Child>& children):Shape(COMPOUND), moment(0.f) {
+    std::vector<const Child*> convex;
+    std::vector<float> areas;
+    float totalArea = 0.f;
+    for (const Child& child : children) {
+        const ShapeType type = child.shape->GetType();
+        if (type == CHAIN || type == COMPOUND) continue;
+        convex.push_back(&child);
+        areas.push_back(ChildArea(*child.shape));
+        totalArea += areas.back();
+    }
+
+    // Mass spreads over the children by area (equal shares if all are empty)
+    std::vector<float> weights(convex.size());
+    for (size_t i = 0; i < convex.size(); i++)
+        weights[i] = totalArea > 0.f ? areas[i] / totalArea : 1.f / convex.size();
+
+    centroid = Vec2(0.f, 0.f);
+    for (size_t i = 0; i < convex.size(); i++) centroid += convex[i]->offset * weights[i];
+    // Offsets already about the centre of mass (clones, saved scenes) are kept
+    // bit-exact instead of being shifted by rounding noise
+    if (centroid.MagnitudeSquared() < CENTROID_EPSILON * CENTROID_EPSILON) centroid = Vec2(0.f, 0.f);
+
+    // Parallel axis theorem moves each child's inertia onto the centre of mass
+    std::vector<AABB> bounds(convex.size());
+    for (size_t i = 0; i < convex.size(); i++) {
+        const Child& child = *convex[i];
+        const Vec2 offset = child.offset - centroid;
+        moment += weights[i] * (ChildMoment(*child.shape) + offset.MagnitudeSquared());
+
+        Part part { new Body(*child.shape, offset.x, offset.y, 0.f, child.angle), offset, child.angle, 0 };
+        part.body->shape->UpdateVertices(child.angle, offset);
+        bounds[i] = part.body->shape->GetAABB(offset);
+        parts.push_back(part);
+    }
+    tree.Build(bounds);
+}
+
+CompoundShape::~CompoundShape() {
+    for (Part& part : parts) delete part.body;
+}
+
+Shape* CompoundShape::Clone() const {
+    std::vector<Child> children;
+    children.reserve(parts.size());
+    for (const Part& part : parts) children.push_back({ part.body->shape, part.offset, part.angle });
+    return new CompoundShape(children);
+}
+
+void CompoundShape::UpdateVertices(float angle, const Vec2& position) {
+    if (angle == poseAngle && position.x == posePosition.x && position.y == posePosition.y) return;
+    poseAngle = angle;
+    posePosition = position;
+    poseVersion++;
+}
+
+float CompoundShape::GetMomentOfInertia() const {
+    return moment;
+}
+
+AABB CompoundShape::GetAABB(const Vec2& position) const {
+    if (tree.Empty()) return { position, position };
+    return ToWorld(tree.Bounds());
+}
+
+Vec2 CompoundShape::Support(const Vec2& direction, const Vec2& position) const {
+    // Support of the convex hull of the parts
+    Vec2 best = position;
+    float bestProjection = -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < PartCount(); i++) {
+        const Body* body = PlacePart(i);
+        const Vec2 point = body->shape->Support(direction, body->position);
+        if (point.Dot(direction) > bestProjection) {
+            bestProjection = point.Dot(direction);
+            best = point;
+        }
+    }
+    return best;
+}
+
+int CompoundShape::PartCount() const {
+    return static_cast<int>(parts.size());
+}
+
+Body* CompoundShape::PlacePart(int index) const {
+    const Part& part = parts[index];
+    Body* body = part.body;
+    if (part.placed != poseVersion) {
+        body->rotation = poseAngle + part.angle;
+        body->position = posePosition + part.offset.Rotate(poseAngle);
+        body->shape->UpdateVertices(body->rotation, body->position);
+        part.placed = poseVersion;
+    }
+    return body;
+}
+
+AABB CompoundShape::ToLocal(const AABB& box) const {
+    return TransformBox({ box.min - posePosition, box.max - posePosition }, -poseAngle, Vec2(0.f, 0.f));
+}
+
+AABB CompoundShape::ToWorld(const AABB& box) const {
+    return TransformBox(box, poseAngle, posePosition);
+}
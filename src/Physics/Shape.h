@@ -4,19 +4,41 @@
 #include <vector>
 #include <cmath>
 #include "Physics/Constants.h"
+#include "Physics/AABB.h"
+#include "Physics/StaticTree.h"
+
+struct Body;
 
 enum ShapeType {
   CIRCLE,
   POLYGON,
-  BOX
+  BOX,
+  CAPSULE,
+  CHAIN,
+  COMPOUND
 };
+constexpr int SHAPE_TYPE_COUNT = COMPOUND + 1;
+
+// BoxShape is a PolygonShape; code reading vertices treats the two alike
+inline bool IsPolygon(ShapeType type) { return type == POLYGON || type == BOX; }
 
 struct Shape {
+  // Only reports what overlaps it (see World::sensorEvents); never solved
+  bool sensor = false;
+
+  explicit Shape(ShapeType type) : type(type) {}
   virtual ~Shape() = default;
-  virtual ShapeType GetType() const = 0;
+  // A plain tag, read per pair by the narrowphase without a virtual call
+  ShapeType GetType() const { return type; }
   virtual Shape* Clone() const = 0;
   virtual void UpdateVertices(float angle, const Vec2& position) = 0;
   virtual float GetMomentOfInertia() const = 0;
+  virtual AABB GetAABB(const Vec2& position) const = 0;
+  // Farthest point of the shape along direction, in world space
+  virtual Vec2 Support(const Vec2& direction, const Vec2& position) const = 0;
+
+private:
+  ShapeType type;
 };
 
 struct CircleShape: public Shape {
@@ -24,27 +46,49 @@ struct CircleShape: public Shape {
 
   CircleShape(const float radius);
   virtual ~CircleShape();
-  ShapeType GetType() const override;
   Shape* Clone() const override;
   void UpdateVertices(float angle, const Vec2& position) override;
   float GetMomentOfInertia() const override;
+  AABB GetAABB(const Vec2& position) const override;
+  Vec2 Support(const Vec2& direction, const Vec2& position) const override;
+};
+
+// Segment of the given length along the local x axis, inflated by radius.
+// Like a polygon's, its GetAABB and Support read the end points, so
+// UpdateVertices must already have posed it at the position they are given.
+struct CapsuleShape: public Shape {
+  float length;
+  float radius;
+  Vec2 worldA, worldB; // segment end points, refreshed by UpdateVertices
+
+  CapsuleShape(float length, float radius);
+  virtual ~CapsuleShape();
+  Shape* Clone() const override;
+  void UpdateVertices(float angle, const Vec2& position) override;
+  float GetMomentOfInertia() const override;
+  AABB GetAABB(const Vec2& position) const override;
+  Vec2 Support(const Vec2& direction, const Vec2& position) const override;
 };
 
 struct PolygonShape: public Shape {
   int sides;
   float radius;
+  bool regular = false; // built from sides and radius, not from explicit vertices
   std::vector<Vec2> localVertices; 
   std::vector<Vec2> worldVertices; 
 
-    PolygonShape() = default;
+    PolygonShape() : Shape(POLYGON) {}
     PolygonShape(const int sides, const float radius); 
+    // Convex, counter-clockwise in math orientation (positive area)
+    PolygonShape(const std::vector<Vec2>& vertices);
     virtual ~PolygonShape();
-    ShapeType GetType() const override;
     Shape* Clone() const override;
     Vec2 GetEdge(int index) const;
       Vec2 GetNormal(int index) const;
       float FindMinSeparation(const PolygonShape* other, Vec2& axis, Vec2& point) const;
     float GetMomentOfInertia() const override;
+    AABB GetAABB(const Vec2& position) const override;
+    Vec2 Support(const Vec2& direction, const Vec2& position) const override;
     
   void UpdateVertices(float angle, const Vec2& position) override; 
 
@@ -55,7 +99,10 @@ struct PolygonShape: public Shape {
     static float CalculateMass(const std::vector<Vec2>& vertices, float density);
     static float CalculatePolygonMomentOfInertia(const std::vector<Vec2>& verts, float mass); 
   };
-  
+
+protected:
+  // For shapes that are polygons with a tag of their own, like BoxShape
+  explicit PolygonShape(ShapeType type) : Shape(type) {}
 };
 
 struct BoxShape: public PolygonShape {
@@ -64,9 +111,105 @@ struct BoxShape: public PolygonShape {
   
   BoxShape(float width, float height);
   virtual ~BoxShape();
-  ShapeType GetType() const override;
   Shape* Clone() const override;
   float GetMomentOfInertia() const override;
 
   std::vector<Vec2> GenerateBoxVertices(float width, float height) const; 
 };
+
+// Static polyline for terrain and floors. Each segment is one-sided: it only
+// collides from the side of its Normal(), which is above a chain drawn left
+// to right on screen. The points around a segment act as ghost vertices, so
+// bodies slide over the joins instead of catching on them. Segments sit in a
+// small bounding volume tree, so a body only tests the ones near it.
+struct ChainShape: public Shape {
+  std::vector<Vec2> localPoints;
+  std::vector<Vec2> worldPoints;
+  bool loop; // closes the last point back onto the first
+
+  StaticTree tree; // over the segments, rebuilt when the transform changes
+
+  // Transform the tree was last built for
+  float builtAngle = 0.f;
+  Vec2  builtPosition;
+
+  ChainShape(const std::vector<Vec2>& points, bool loop = false);
+  virtual ~ChainShape();
+  Shape* Clone() const override;
+  void UpdateVertices(float angle, const Vec2& position) override;
+  float GetMomentOfInertia() const override;
+  AABB GetAABB(const Vec2& position) const override;
+  Vec2 Support(const Vec2& direction, const Vec2& position) const override;
+
+  int SegmentCount() const;
+  void GetSegment(int index, Vec2& start, Vec2& end) const;
+  // Points just before start and after end; false at the open ends of a chain
+  bool GetPreviousGhost(int index, Vec2& ghost) const;
+  bool GetNextGhost(int index, Vec2& ghost) const;
+
+  // Calls fn(segment) for every segment whose bounds overlap box
+  template <typename Fn>
+  void QuerySegments(const AABB& box, Fn fn) const {
+    tree.Query(box, fn);
+  }
+
+  void BuildTree();
+};
+
+// Rigid group of convex shapes, for bodies one convex shape can't describe
+// (L-shapes, cars, concave obstacles). Children are kept relative to the
+// group's centre of mass, so the body's position is its centre of mass.
+// They sit in a tree built once in local space: a contact query transforms
+// and tests only the children near the other body, never all of them.
+struct CompoundShape: public Shape {
+  struct Child {
+    const Shape* shape; // cloned; chains and compounds are not allowed
+    Vec2 offset;        // from the body's position
+    float angle;
+  };
+
+  // Each child lives in a body of its own, so the narrowphase routines,
+  // which read a body's shape and position, run on it unchanged. Only the
+  // part's shape and pose are used; motion belongs to the compound's body.
+  struct Part {
+    Body* body;
+    Vec2 offset; // from the centre of mass
+    float angle;
+    mutable unsigned placed; // pose version the body was last moved to
+  };
+  std::vector<Part> parts;
+  StaticTree tree; // over the parts' local bounds
+  Vec2 centroid;   // centre of mass, relative to the offsets given
+  float moment;    // per unit mass, about the centre of mass
+
+  // Pose from the last UpdateVertices; parts follow it lazily in PlacePart
+  float poseAngle = 0.f;
+  Vec2 posePosition;
+  unsigned poseVersion = 1;
+
+  CompoundShape(const std::vector<Child>& children);
+  virtual ~CompoundShape();
+  CompoundShape(const CompoundShape&) = delete;
+  CompoundShape& operator=(const CompoundShape&) = delete;
+  Shape* Clone() const override;
+  void UpdateVertices(float angle, const Vec2& position) override;
+  float GetMomentOfInertia() const override;
+  AABB GetAABB(const Vec2& position) const override;
+  Vec2 Support(const Vec2& direction, const Vec2& position) const override;
+
+  int PartCount() const;
+  // The part's body, moved to the compound's current pose first if needed
+  Body* PlacePart(int index) const;
+
+  // Calls fn(part) for every part whose local bounds may overlap box, which
+  // is in world space. Parts are not placed; call PlacePart before using one.
+  template <typename Fn>
+  void QueryParts(const AABB& box, Fn fn) const {
+    tree.Query(ToLocal(box), fn);
+  }
+
+  // Bounds of box after moving it from world space into the compound's
+  // frame, or back out of it
+  AABB ToLocal(const AABB& box) const;
+  AABB ToWorld(const AABB& box) const;
+};
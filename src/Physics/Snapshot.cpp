@@ -0,0 +1,267 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include "World.h"
+
+namespace {
+
+struct ShapeRecordHash {
+    size_t operator()(const ShapeRecord& r) const {
+        uint64_t h = 1469598103934665603ull;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&r);
+        for (size_t i = 0; i < sizeof(ShapeRecord); i++) {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+        return static_cast<size_t>(h);
+    }
+};
+
+struct ShapeRecordEqual {
+    bool operator()(const ShapeRecord& a, const ShapeRecord& b) const {
+        return std::memcmp(&a, &b, sizeof(ShapeRecord)) == 0;
+    }
+};
+
+}
+
+size_t SceneSnapshot::PointsUsed(const ShapeRecord& record, const PartRecord* parts, size_t partCount) {
+    if (record.sides <= 0) return 0;
+    switch (record.type) {
+        case SNAPSHOT_CHAIN:
+        case SNAPSHOT_HULL:
+            return static_cast<size_t>(record.sides);
+        case SNAPSHOT_COMPOUND: {
+            size_t used = 0;
+            const size_t count = std::min(partCount, static_cast<size_t>(record.sides));
+            for (size_t i = 0; i < count; i++) used += PointsUsed(parts[i].shape, nullptr, 0);
+            return used;
+        }
+    }
+    return 0;
+}
+
+ShapeRecord SceneSnapshot::MakeShapeRecord(const Shape& shape, std::vector<PointRecord>& points, std::vector<PartRecord>& parts) {
+    ShapeRecord record {};
+    switch (shape.GetType()) {
+        case CIRCLE: {
+            const CircleShape& circle = static_cast<const CircleShape&>(shape);
+            record.type = SNAPSHOT_CIRCLE;
+            record.a = circle.radius;
+            break;
+        }
+        case BOX: {
+            const BoxShape& box = static_cast<const BoxShape&>(shape);
+            record.type = SNAPSHOT_BOX;
+            record.a = box.width;
+            record.b = box.height;
+            break;
+        }
+        case POLYGON: {
+            const PolygonShape& polygon = static_cast<const PolygonShape&>(shape);
+            if (!polygon.regular) {
+                record.type = SNAPSHOT_HULL;
+                record.sides = static_cast<int32_t>(polygon.localVertices.size());
+                for (const Vec2& v : polygon.localVertices) points.push_back({ v.x, v.y });
+                break;
+            }
+            record.type = SNAPSHOT_POLYGON;
+            record.sides = polygon.sides;
+            record.a = polygon.radius;
+            break;
+        }
+        case CAPSULE: {
+            const CapsuleShape& capsule = static_cast<const CapsuleShape&>(shape);
+            record.type = SNAPSHOT_CAPSULE;
+            record.a = capsule.radius;
+            record.b = capsule.length;
+            break;
+        }
+        case CHAIN: {
+            const ChainShape& chain = static_cast<const ChainShape&>(shape);
+            record.type = SNAPSHOT_CHAIN;
+            record.sides = static_cast<int32_t>(chain.localPoints.size());
+            record.a = chain.loop ? 1.f : 0.f;
+            for (const Vec2& p : chain.localPoints) points.push_back({ p.x, p.y });
+            break;
+        }
+        case COMPOUND: {
+            const CompoundShape& compound = static_cast<const CompoundShape&>(shape);
+            record.type = SNAPSHOT_COMPOUND;
+            record.sides = compound.PartCount();
+            for (const CompoundShape::Part& part : compound.parts) {
+                // Children are convex: only hull vertices go to a table
+                PartRecord child {};
+                child.shape = MakeShapeRecord(*part.body->shape, points, parts);
+                child.x     = part.offset.x;
+                child.y     = part.offset.y;
+                child.angle = part.angle;
+                parts.push_back(child);
+            }
+            break;
+        }
+    }
+    return record;
+}
+
+Shape* SceneSnapshot::MakeShape(const ShapeRecord& record, const PointRecord* points, size_t pointCount,
+                                const PartRecord* parts, size_t partCount) {
+    switch (record.type) {
+        case SNAPSHOT_CIRCLE:  return new CircleShape(record.a);
+        case SNAPSHOT_BOX:     return new BoxShape(record.a, record.b);
+        case SNAPSHOT_POLYGON: return record.sides >= 3 ? new PolygonShape(record.sides, record.a) : nullptr;
+        case SNAPSHOT_CAPSULE: return new CapsuleShape(record.b, record.a);
+        case SNAPSHOT_HULL: {
+            if (record.sides < 3 || static_cast<size_t>(record.sides) > pointCount) return nullptr;
+            std::vector<Vec2> vertices;
+            vertices.reserve(record.sides);
+            for (int32_t i = 0; i < record.sides; i++) vertices.push_back(Vec2(points[i].x, points[i].y));
+            return new PolygonShape(vertices);
+        }
+        case SNAPSHOT_CHAIN: {
+            if (record.sides < 2 || static_cast<size_t>(record.sides) > pointCount) return nullptr;
+            std::vector<Vec2> chainPoints;
+            chainPoints.reserve(record.sides);
+            for (int32_t i = 0; i < record.sides; i++) chainPoints.push_back(Vec2(points[i].x, points[i].y));
+            return new ChainShape(chainPoints, record.a != 0.f);
+        }
+        case SNAPSHOT_COMPOUND: {
+            if (record.sides < 1 || static_cast<size_t>(record.sides) > partCount) return nullptr;
+            std::vector<std::unique_ptr<Shape>> shapes;
+            std::vector<CompoundShape::Child> children;
+            size_t point = 0;
+            for (int32_t i = 0; i < record.sides; i++) {
+                const PartRecord& part = parts[i];
+                if (part.shape.type == SNAPSHOT_CHAIN || part.shape.type == SNAPSHOT_COMPOUND) return nullptr;
+                shapes.emplace_back(MakeShape(part.shape, points + point, pointCount - point, nullptr, 0));
+                if (!shapes.back()) return nullptr;
+                point += PointsUsed(part.shape, nullptr, 0);
+                children.push_back({ shapes.back().get(), Vec2(part.x, part.y), part.angle });
+            }
+            return new CompoundShape(children);
+        }
+    }
+    return nullptr;
+}
+
+void SceneSnapshot::Capture(const World& world) {
+    settings = {};
+    settings.gravity      = world.gravity;
+    settings.restitution  = world.restitution;
+    settings.friction     = world.friction;
+    settings.maxIteration = world.maxIteration;
+
+    shapes.clear();
+    points.clear();
+    parts.clear();
+    filters.clear();
+    bodies.clear();
+    bodies.reserve(world.bodies.size());
+
+    std::unordered_map<ShapeRecord, uint32_t, ShapeRecordHash, ShapeRecordEqual> shapeIndex;
+
+    for (const Body* body : world.bodies) {
+        uint32_t index;
+        const ShapeType type = body->shape->GetType();
+        const bool hull = type == POLYGON && !static_cast<const PolygonShape*>(body->shape)->regular;
+        if (type == CHAIN || type == COMPOUND || hull) {
+            // These differ by their points or parts, which the record does not hold
+            index = static_cast<uint32_t>(shapes.size());
+            shapes.push_back(MakeShapeRecord(*body->shape, points, parts));
+        } else {
+            ShapeRecord shape = MakeShapeRecord(*body->shape, points, parts);
+            auto it = shapeIndex.find(shape);
+            if (it == shapeIndex.end()) {
+                it = shapeIndex.emplace(shape, static_cast<uint32_t>(shapes.size())).first;
+                shapes.push_back(shape);
+            }
+            index = it->second;
+        }
+
+        BodyRecord record;
+        record.x               = body->position.x;
+        record.y               = body->position.y;
+        record.rotation        = body->rotation;
+        record.velocityX       = body->velocity.x;
+        record.velocityY       = body->velocity.y;
+        record.angularVelocity = body->angularVelocity;
+        record.mass            = body->mass;
+        record.restitution     = body->restitution;
+        record.friction        = body->friction;
+        record.gravity         = body->gravity;
+        record.shapeIndex      = index;
+        record.flags           = (body->allowRotation ? BODY_ALLOW_ROTATION : 0u) | (body->bullet ? BODY_BULLET : 0u) |
+                                 (body->shape->sensor ? BODY_SENSOR : 0u);
+        bodies.push_back(record);
+    }
+
+    const bool filtered = std::any_of(world.bodies.begin(), world.bodies.end(),
+                                      [](const Body* body) { return !body->filter.IsDefault(); });
+    if (filtered) {
+        filters.reserve(world.bodies.size());
+        for (const Body* body : world.bodies)
+            filters.push_back({ body->filter.categoryBits, body->filter.maskBits, body->filter.groupIndex, 0 });
+    }
+}
+
+SnapshotView SceneSnapshot::View() const {
+    SnapshotView view;
+    view.settings    = settings;
+    view.shapes      = shapes.data();
+    view.shapeCount  = shapes.size();
+    view.points      = points.data();
+    view.pointCount  = points.size();
+    view.parts       = parts.data();
+    view.partCount   = parts.size();
+    view.filters     = filters.data();
+    view.filterCount = filters.size();
+    view.bodies      = bodies.data();
+    view.bodyCount   = bodies.size();
+    return view;
+}
+
+bool SceneSnapshot::CreateBodies(const SnapshotView& view, std::vector<Body*>& out) {
+    // Build each distinct shape once; Body clones its prototype
+    std::vector<std::unique_ptr<Shape>> prototypes(view.shapeCount);
+    size_t point = 0, part = 0;
+    for (size_t i = 0; i < view.shapeCount; i++) {
+        const ShapeRecord& shape = view.shapes[i];
+        prototypes[i].reset(MakeShape(shape, view.points + point, view.pointCount - point,
+                                      view.parts + part, view.partCount - part));
+        point = std::min(view.pointCount, point + PointsUsed(shape, view.parts + part, view.partCount - part));
+        if (shape.type == SNAPSHOT_COMPOUND && shape.sides > 0)
+            part = std::min(view.partCount, part + static_cast<size_t>(shape.sides));
+    }
+
+    const size_t firstNew = out.size();
+    out.reserve(firstNew + view.bodyCount);
+    for (size_t i = 0; i < view.bodyCount; i++) {
+        const BodyRecord& r = view.bodies[i];
+        if (r.shapeIndex >= view.shapeCount || !prototypes[r.shapeIndex]) {
+            for (size_t k = firstNew; k < out.size(); k++) delete out[k];
+            out.resize(firstNew);
+            return false;
+        }
+
+        Body* body = new Body(*prototypes[r.shapeIndex], r.x, r.y, r.mass, r.rotation);
+        body->velocity        = Vec2(r.velocityX, r.velocityY);
+        body->angularVelocity = r.angularVelocity;
+        body->restitution     = r.restitution;
+        body->friction        = r.friction;
+        body->gravity         = r.gravity;
+        body->allowRotation   = (r.flags & BODY_ALLOW_ROTATION) != 0;
+        body->bullet          = (r.flags & BODY_BULLET) != 0;
+        body->shape->sensor   = (r.flags & BODY_SENSOR) != 0;
+        if (i < view.filterCount) {
+            const FilterRecord& f = view.filters[i];
+            body->filter = { f.categoryBits, f.maskBits, f.groupIndex };
+        }
+        body->shape->UpdateVertices(body->rotation, body->position);
+        out.push_back(body);
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Body.h"
+
+struct World;
+
+// Plain-old-data records describing a scene. They are written to disk as-is
+// by the binary state format, so field order and sizes are part of it.
+
+enum SnapshotShapeType : uint32_t {
+    SNAPSHOT_CIRCLE   = 0,
+    SNAPSHOT_POLYGON  = 1,
+    SNAPSHOT_BOX      = 2,
+    SNAPSHOT_CAPSULE  = 3,
+    SNAPSHOT_CHAIN    = 4,
+    SNAPSHOT_COMPOUND = 5,
+    SNAPSHOT_HULL     = 6  // convex polygon with explicit vertices
+};
+
+struct ShapeRecord {
+    uint32_t type;   // SnapshotShapeType
+    int32_t  sides;  // polygon sides, chain/hull point count, compound part count
+    float    a;      // circle/polygon/capsule radius, box width, chain loop flag
+    float    b;      // box height, capsule length
+};
+
+// Chain point or hull vertex in the shape's local space. Chain and hull
+// records take their points from the point table in turn, in shape table
+// order; a compound's hull parts take theirs in part order, in its place.
+struct PointRecord {
+    float x, y;
+};
+
+// Compound child, placed relative to the compound's centre of mass. Compound
+// shape records take their parts from the part table in turn, in shape
+// table order.
+struct PartRecord {
+    ShapeRecord shape; // never a chain or a compound
+    float       x, y;
+    float       angle;
+    uint32_t    reserved;
+};
+
+// Collision filter of a body, by index in the body table. Snapshots where
+// every body keeps the default filter have no filter table at all.
+struct FilterRecord {
+    uint16_t categoryBits;
+    uint16_t maskBits;
+    int16_t  groupIndex;
+    uint16_t reserved;
+};
+
+enum BodyRecordFlags : uint32_t {
+    BODY_ALLOW_ROTATION = 1u << 0,
+    BODY_BULLET         = 1u << 1,
+    BODY_SENSOR         = 1u << 2
+};
+
+struct BodyRecord {
+    float x, y;
+    float rotation;
+    float velocityX, velocityY;
+    float angularVelocity;
+    float mass;
+    float restitution;
+    float friction;
+    float gravity;
+    uint32_t shapeIndex;
+    uint32_t flags;
+};
+
+enum SnapshotSettingsFlags : uint32_t {
+    SETTINGS_PAUSED            = 1u << 0,
+    SETTINGS_PENDULUM_ATTACHED = 1u << 1
+};
+
+struct SnapshotSettings {
+    float    gravity;
+    float    restitution;
+    float    friction;
+    int32_t  maxIteration;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ShapeRecord) == 16, "ShapeRecord layout is part of the state format");
+static_assert(sizeof(PointRecord) == 8, "PointRecord layout is part of the state format");
+static_assert(sizeof(PartRecord) == 32, "PartRecord layout is part of the state format");
+static_assert(sizeof(FilterRecord) == 8, "FilterRecord layout is part of the state format");
+static_assert(sizeof(BodyRecord) == 48, "BodyRecord layout is part of the state format");
+static_assert(sizeof(SnapshotSettings) == 24, "SnapshotSettings layout is part of the state format");
+
+// Non-owning view over snapshot records, e.g. straight into a mapped file
+struct SnapshotView {
+    SnapshotSettings    settings {};
+    const ShapeRecord*  shapes = nullptr;
+    size_t              shapeCount = 0;
+    const PointRecord*  points = nullptr;
+    size_t              pointCount = 0;
+    const PartRecord*   parts = nullptr;
+    size_t              partCount = 0;
+    const FilterRecord* filters = nullptr;
+    size_t              filterCount = 0; // 0 or bodyCount
+    const BodyRecord*   bodies = nullptr;
+    size_t              bodyCount = 0;
+};
+
+// Owning snapshot: a deduplicated shape table plus one packed record per body
+struct SceneSnapshot {
+    SnapshotSettings          settings {};
+    std::vector<ShapeRecord>  shapes;
+    std::vector<PointRecord>  points;
+    std::vector<PartRecord>   parts;
+    std::vector<FilterRecord> filters;
+    std::vector<BodyRecord>   bodies;
+
+    // Copy the world's settings and body state. Application-level flags
+    // (pause, pendulum) are left for the caller to fill in, as is the
+    // world's warm-start state (World::ClearCaches).
+    void Capture(const World& world);
+
+    SnapshotView View() const;
+
+    // Append freshly allocated bodies for every record in the view to out.
+    // Returns false, leaving out unchanged, if a record references a missing
+    // or unknown shape.
+    static bool CreateBodies(const SnapshotView& view, std::vector<Body*>& out);
+
+    // Points of the table a record uses, its compound parts' included
+    static size_t PointsUsed(const ShapeRecord& record, const PartRecord* parts, size_t partCount);
+
+    // Chain points and hull vertices are appended to points, compound children to parts
+    static ShapeRecord MakeShapeRecord(const Shape& shape, std::vector<PointRecord>& points, std::vector<PartRecord>& parts);
+    // points and parts hold the records left from the shape's own on (chains
+    // and compounds only)
+    static Shape* MakeShape(const ShapeRecord& record, const PointRecord* points, size_t pointCount,
+                            const PartRecord* parts, size_t partCount);
+};
@@ -0,0 +1,36 @@
+#include "StaticTree.h"
+
+#include <algorithm>
+
+void StaticTree::Build(const std::vector<AABB>& boxes) {
+    nodes.clear();
+    if (boxes.empty()) return;
+
+    std::vector<int> items(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) items[i] = static_cast<int>(i);
+
+    nodes.reserve(2 * boxes.size() - 1);
+    BuildNode(items, 0, static_cast<int>(items.size()), boxes);
+}
+
+int StaticTree::BuildNode(std::vector<int>& items, int begin, int end, const std::vector<AABB>& boxes) {
+    const int index = static_cast<int>(nodes.size());
+    nodes.push_back({ boxes[items[begin]], -1, -1, items[begin] });
+    if (end - begin == 1) return index;
+
+    AABB box = boxes[items[begin]];
+    for (int i = begin + 1; i < end; i++) box = AABB::Union(box, boxes[items[i]]);
+
+    // Median split along the longer axis keeps the tree balanced
+    const bool splitX = box.max.x - box.min.x >= box.max.y - box.min.y;
+    const int middle = (begin + end) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [&](int a, int b) {
+        const Vec2 ca = boxes[a].Center(), cb = boxes[b].Center();
+        return splitX ? ca.x < cb.x : ca.y < cb.y;
+    });
+
+    const int left = BuildNode(items, begin, middle, boxes);
+    const int right = BuildNode(items, middle, end, boxes);
+    nodes[index] = { box, left, right, -1 };
+    return index;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include "AABB.h"
+
+// Bounding volume tree over a fixed set of boxes, built top-down by median
+// splits so it stays balanced. Shapes with many parts (chain segments,
+// compound children) keep one to find the few parts near a query box.
+struct StaticTree {
+    struct Node {
+        AABB box;
+        int  left, right; // child nodes, -1 for a leaf
+        int  item;        // index into the boxes the tree was built from, leaves only
+    };
+    std::vector<Node> nodes; // root first
+
+    void Build(const std::vector<AABB>& boxes);
+    void Clear() { nodes.clear(); }
+    bool Empty() const { return nodes.empty(); }
+    const AABB& Bounds() const { return nodes[0].box; }
+
+    // Calls fn(item) for every item whose box overlaps box
+    template <typename Fn>
+    void Query(const AABB& box, Fn fn) const {
+        if (nodes.empty()) return;
+        int stack[64]; // balanced, so depth stays near log2 of the item count
+        int count = 0;
+        stack[count++] = 0;
+        while (count > 0) {
+            const Node& node = nodes[stack[--count]];
+            if (!node.box.Overlaps(box)) continue;
+            if (node.left < 0) {
+                fn(node.item);
+                continue;
+            }
+            stack[count++] = node.left;
+            stack[count++] = node.right;
+        }
+    }
+
+private:
+    int BuildNode(std::vector<int>& items, int begin, int end, const std::vector<AABB>& boxes);
+};
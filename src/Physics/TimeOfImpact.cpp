@@ -0,0 +1,72 @@
+#include "TimeOfImpact.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CollisionDetection.h"
+#include "GJK.h"
+
+namespace {
+    constexpr int   MAX_ITERATIONS = 20;
+    constexpr float TOLERANCE      = 0.25f; // pixels either side of TARGET_SEPARATION
+}
+
+Vec2 TimeOfImpact::Sweep::PositionAt(float t) const {
+    return start + (end - start) * t;
+}
+
+float TimeOfImpact::Sweep::AngleAt(float t) const {
+    return angleStart + (angleEnd - angleStart) * t;
+}
+
+TimeOfImpact::Result TimeOfImpact::Compute(Body* body, int part, const Sweep& sweep, float extent,
+                                           const Shape& obstacle, const Vec2& obstaclePosition, float tMax) {
+    Result result {};
+    result.t = 1.f;
+
+    const Vec2  motion = sweep.end - sweep.start;
+    const float turn = std::fabs(sweep.angleEnd - sweep.angleStart) * extent;
+
+    GJK::SimplexCache cache;
+    float t = 0.f;
+    auto hitAt = [&](float time, const GJK::Result& gap) {
+        result.hit    = true;
+        result.t      = time;
+        result.normal = gap.normal;
+        result.pointA = gap.pointA;
+        result.pointB = gap.pointB;
+        return result;
+    };
+
+    GJK::Result previous {};
+    for (result.iterations = 1; result.iterations <= MAX_ITERATIONS; result.iterations++) {
+        const Vec2 position = sweep.PositionAt(t);
+        body->shape->UpdateVertices(sweep.AngleAt(t), position);
+        const Body* moving = CollisionDetection::PartBody(body, part);
+        const GJK::Result gap = GJK::Distance(*moving->shape, part < 0 ? position : moving->position,
+                                              obstacle, obstaclePosition, &cache);
+
+        // Overlapping from the start is the contact solver's job; later, only
+        // float error right at the touch gets here, so the last step stands
+        if (gap.overlap) return t > 0.f ? hitAt(t, previous) : result;
+
+        // Fastest the gap can close: the motion along the separating
+        // direction plus the farthest any point swings around the centre
+        const float approach = motion.Dot(gap.normal);
+        const float closing = std::max(0.f, approach) + turn;
+
+        if (gap.distance < TARGET_SEPARATION + TOLERANCE) {
+            if (t == 0.f && approach <= 0.f) return result; // touching, but not moving in
+            return hitAt(t, gap);
+        }
+        if (closing <= 0.f) return result;
+
+        previous = gap;
+        t += (gap.distance - TARGET_SEPARATION) / closing;
+        if (t >= tMax) return result;
+    }
+
+    // Out of iterations; every step so far was safe, so stopping here is too
+    result.iterations = MAX_ITERATIONS;
+    return hitAt(t, previous);
+}
@@ -0,0 +1,53 @@
+#include "WorkerPool.h"
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void WorkerPool::Run(int count, const std::function<void(int)>& job) {
+    if (count <= 1) {
+        if (count == 1) job(0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> run(runMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (static_cast<int>(workers.size()) < count - 1)
+            workers.emplace_back(&WorkerPool::WorkerLoop, this, static_cast<int>(workers.size()));
+        task = &job;
+        taskCount = count;
+        pending = count - 1;
+        generation++;
+    }
+    wake.notify_all();
+
+    job(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::WorkerLoop(int worker) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&] { return stopRequested || generation != seen; });
+        if (stopRequested) return;
+        seen = generation;
+        // Workers beyond this job's tasks sit it out
+        if (worker + 1 >= taskCount) continue;
+
+        const std::function<void(int)>* job = task;
+        lock.unlock();
+        (*job)(worker + 1);
+        lock.lock();
+        if (--pending == 0) finished.notify_one();
+    }
+}
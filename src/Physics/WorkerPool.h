@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept across steps for the world's parallel loops, so a step with
+// several parallel passes (two per soft step substep) starts no threads of
+// its own. Workers are started on first need and then sleep between jobs.
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls job(k) once for each k in [0, count), job(0) on the calling
+    // thread and the rest on workers, and returns once all have. One job
+    // runs at a time; a second caller waits for the first.
+    void Run(int count, const std::function<void(int)>& job);
+
+private:
+    void WorkerLoop(int worker);
+
+    std::mutex                       runMutex; // held for a whole Run
+    std::mutex                       mutex;
+    std::condition_variable          wake;
+    std::condition_variable          finished;
+    const std::function<void(int)>*  task = nullptr;
+    int                              taskCount = 0;
+    int                              pending = 0;   // this job's tasks still running on workers
+    uint64_t                         generation = 0; // bumped per job
+    bool                             stopRequested = false;
+    std::vector<std::thread>         workers;       // worker k runs job(k + 1)
+};
@@ -0,0 +1,1025 @@
+#include "World.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "CollisionDetection.h"
+#include "CollisionSolver.h"
+#include "ContactInformation.h"
+#include "Constants.h"
+#include "TimeOfImpact.h"
+
+namespace {
+    // Below this many bodies per thread, spawning workers costs more than it saves
+    constexpr size_t MIN_BODIES_PER_THREAD = 2048;
+    // Rays cost a tree walk each, so fewer of them fill a thread
+    constexpr size_t MIN_RAYS_PER_THREAD = 256;
+
+    // Bodies moving less than this per step are never swept (pixels)
+    constexpr float MIN_SWEPT_MOTION = 2.f;
+    // Beyond that, a body is swept once a step moves it further than this
+    // fraction of the half-width of its narrower side
+    constexpr float SWEPT_MOTION_FRACTION = 0.5f;
+    // Impacts one body may resolve in a step; it stops at the last one
+    constexpr int MAX_IMPACTS = 4;
+
+    // Soft step contacts, in pixels: pairs closer than this get a contact
+    // that only stops them touching, the slop is left in on purpose so
+    // resting contacts do not jitter, and overlap is pushed out no faster
+    // than the cap
+    constexpr float SPECULATIVE_DISTANCE = 4.f;
+    constexpr float LINEAR_SLOP          = 0.25f;
+    constexpr float MAX_PUSHOUT_SPEED    = 3.f * Constants::PIXELS_PER_METER;
+    // Approach speed below which contacts do not bounce (px/s)
+    constexpr float RESTITUTION_THRESHOLD = 1.f * Constants::PIXELS_PER_METER;
+    // Contact spring, capped at a quarter of the substep rate to stay stable
+    constexpr float CONTACT_HERTZ         = 30.f;
+    constexpr float CONTACT_DAMPING_RATIO = 10.f;
+    // How far a contact may move on b between steps and still be taken
+    // for the same one, keeping its impulses
+    constexpr float IMPULSE_MATCH_DISTANCE = 2.f; // pixels
+
+    // Joints: twice as stiff as contacts in the soft step. Joint trees are
+    // solved exactly each contact pass; the joints JointSolver leaves loose
+    // are swept several times per pass instead, a joint costing far less
+    // than re-detecting every pair. Once the passes are done, or the soft
+    // step's substeps, the trees are put back together exactly and the
+    // iterative solver moves the loose joints' bodies this fraction back.
+    constexpr float JOINT_HERTZ_SCALE    = 2.f;
+    constexpr float JOINT_DAMPING_RATIO  = 2.f;
+    constexpr float JOINT_CORRECTION     = 0.5f;
+    constexpr int   JOINT_SWEEPS         = 8;
+
+    Vec2 PointVelocity(const Body* body, const Vec2& r) {
+        return body->velocity + Vec2(-body->angularVelocity * r.y, body->angularVelocity * r.x);
+    }
+
+    // Run fn(i) for i in [0, count) over fixed contiguous ranges, on pool's
+    // threads. fn must only touch element i, which keeps the result
+    // independent of the thread count.
+    template <typename Fn>
+    void ParallelFor(WorkerPool& pool, size_t count, int threads, Fn fn, size_t minPerThread = MIN_BODIES_PER_THREAD) {
+        size_t useful = count / minPerThread;
+        size_t workers = std::min<size_t>(threads > 1 ? threads : 1, useful > 1 ? useful : 1);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; i++) fn(i);
+            return;
+        }
+
+        size_t chunk = (count + workers - 1) / workers;
+        const int chunks = static_cast<int>((count + chunk - 1) / chunk);
+        pool.Run(chunks, [&](int k) {
+            size_t end = std::min(count, (k + 1) * chunk);
+            for (size_t i = k * chunk; i < end; i++) fn(i);
+        });
+    }
+
+    uint32_t FloatBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+World::~World() {
+    Clear();
+}
+
+void World::AddBody(Body* body) {
+    bodies.push_back(body);
+    body->shape->UpdateVertices(body->rotation, body->position);
+    body->proxy = index.Insert(body, body->shape->GetAABB(body->position));
+}
+
+void World::Refresh(Body* body) {
+    body->shape->UpdateVertices(body->rotation, body->position);
+    index.Move(body->proxy, body->shape->GetAABB(body->position));
+}
+
+void World::AddJoint(Joint* joint) {
+    joints.push_back(joint);
+    if (joint->a) joint->a->allowRotation = true;
+    joint->b->allowRotation = true;
+    if (!joint->collideConnected && joint->a)
+        jointedPairs[std::minmax<const Body*>(joint->a, joint->b)]++;
+}
+
+bool World::RemoveJoint(Joint* joint) {
+    auto it = std::find(joints.begin(), joints.end(), joint);
+    if (it == joints.end()) return false;
+    UnlinkJoint(joint);
+    delete joint;
+    joints.erase(it);
+    return true;
+}
+
+void World::UnlinkJoint(const Joint* joint) {
+    if (joint->collideConnected || !joint->a) return;
+    auto it = jointedPairs.find(std::minmax<const Body*>(joint->a, joint->b));
+    if (it != jointedPairs.end() && --it->second == 0) jointedPairs.erase(it);
+}
+
+void World::Clear() {
+    for (Joint* joint : joints) delete joint;
+    joints.clear();
+    jointedPairs.clear();
+    for (auto body : bodies) {
+        delete body;
+    }
+    bodies.clear();
+    index.Clear();
+    touching.clear();
+    sensorOverlaps.clear();
+    contactEvents.begin.clear();
+    contactEvents.persist.clear();
+    contactEvents.end.clear();
+    sensorEvents.enter.clear();
+    sensorEvents.exit.clear();
+    ClearCaches();
+}
+
+void World::ClearCaches() {
+    simplexCache.clear();
+    impulseCache.clear();
+}
+
+bool World::RemoveBody(Body* body) {
+    auto it = std::find(bodies.begin(), bodies.end(), body);
+    if (it == bodies.end()) return false;
+    RemoveJoints([body](const Joint* joint) { return joint->a == body || joint->b == body; });
+    std::vector<const Body*> forgotten { body };
+    AppendParts(body, forgotten);
+    ForgetTouching([&](const Body* other) { return std::find(forgotten.begin(), forgotten.end(), other) != forgotten.end(); });
+    index.Remove(body->proxy);
+    delete *it;
+    bodies.erase(it);
+    return true;
+}
+
+void World::AppendParts(const Body* body, std::vector<const Body*>& out) {
+    if (body->shape->GetType() != COMPOUND) return;
+    for (const CompoundShape::Part& part : static_cast<const CompoundShape*>(body->shape)->parts)
+        out.push_back(part.body);
+}
+
+void World::Integrate(float deltaTime) {
+    int scale = Constants::PIXELS_PER_METER;
+
+    // Each body only depends on itself here, so the work splits across threads
+    ParallelFor(workers, bodies.size(), threadCount, [&](size_t i) {
+        Body* body = bodies[i];
+
+        // Apply forces to the body
+        Vec2 weight = Vec2(0.0, body->mass * body->gravity * scale);
+        body->AddForce(weight);
+
+        // Integrate forces to update velocity/position
+        body->Update(deltaTime);
+        body->restitution = restitution;
+        body->gravity = gravity;
+        body->friction = friction;
+    });
+}
+
+void World::SolveContinuous(float deltaTime) {
+    if (!continuousCollision || deltaTime <= 0.f) return;
+
+    auto turnOf = [](const Body* body, float dt) { return body->allowRotation ? body->angularVelocity * dt : 0.f; };
+
+    // Cheap cut on speed alone, so a scene with nothing fast pays one pass.
+    // reach bounds how far any slower body's points have moved since the
+    // index was last refit: its linear motion, plus its turn times how far
+    // its fat box reaches from where it was. The soft step moved bodies in
+    // substeps, but sweeps with its final velocity all the same.
+    sweptBodies.clear();
+    float reach = 0.f;
+    auto reachOf = [&](const Body* body, float motion, float turn) {
+        if (turn == 0.f) return motion;
+        const AABB& fat = index.FatBox(body->proxy);
+        const Vec2  was = body->position - body->velocity * deltaTime;
+        const Vec2  far(std::max(was.x - fat.min.x, fat.max.x - was.x), std::max(was.y - fat.min.y, fat.max.y - was.y));
+        return motion + std::fabs(turn) * far.Magnitude();
+    };
+    for (size_t i = 0; i < bodies.size(); i++) {
+        const Body* body = bodies[i];
+        if (body->IsStatic() || body->shape->sensor) continue;
+        const float linear = (body->velocity * deltaTime).Magnitude();
+        const float turn = turnOf(body, deltaTime);
+        if (body->bullet || linear + std::fabs(turn) > MIN_SWEPT_MOTION) sweptBodies.push_back(i);
+        else reach = std::max(reach, reachOf(body, linear, turn));
+    }
+    if (sweptBodies.empty()) return;
+
+    // Then only the bodies that move far for their size. extent bounds how
+    // far any of a body's points are from its position.
+    sweptExtents.clear();
+    sweptBodies.erase(std::remove_if(sweptBodies.begin(), sweptBodies.end(), [&](size_t i) {
+        Body* body = bodies[i];
+        body->shape->UpdateVertices(body->rotation, body->position);
+        const AABB box = body->shape->GetAABB(body->position);
+        const float extent = Vec2(std::max(body->position.x - box.min.x, box.max.x - body->position.x),
+                                  std::max(body->position.y - box.min.y, box.max.y - body->position.y)).Magnitude();
+        const float halfWidth = 0.5f * std::min(box.max.x - box.min.x, box.max.y - box.min.y);
+        const float linear = (body->velocity * deltaTime).Magnitude();
+        const float turn = turnOf(body, deltaTime);
+        const float motion = linear + std::fabs(turn) * extent;
+        if (!body->bullet && motion <= SWEPT_MOTION_FRACTION * halfWidth) {
+            reach = std::max(reach, reachOf(body, linear, turn));
+            return true;
+        }
+        sweptExtents.push_back(extent);
+        return false;
+    }), sweptBodies.end());
+    if (sweptBodies.empty()) return;
+
+    // The slower bodies stay where they are, so their boxes hold throughout.
+    // Only those the index puts near a sweep are brought up to date, and
+    // are taken in body order, as ForEachContact takes its pairs, so the
+    // tree's shape never picks between two impacts at the same time.
+    int proxies = 0;
+    for (const Body* body : bodies) proxies = std::max(proxies, body->proxy + 1);
+    contactOrder.resize(proxies);
+    for (size_t i = 0; i < bodies.size(); i++) contactOrder[bodies[i]->proxy] = static_cast<int>(i);
+    auto isSwept = [&](int i) { return std::binary_search(sweptBodies.begin(), sweptBodies.end(), static_cast<size_t>(i)); };
+
+    for (size_t k = 0; k < sweptBodies.size(); k++) {
+        Body* body = bodies[sweptBodies[k]];
+        const float extent = sweptExtents[k];
+        const int moverParts = body->shape->GetType() == COMPOUND ? static_cast<CompoundShape*>(body->shape)->PartCount() : 0;
+
+        float remaining = deltaTime;
+        const float turn = turnOf(body, deltaTime);
+        TimeOfImpact::Sweep sweep { body->position - body->velocity * deltaTime, body->position, body->rotation - turn, body->rotation };
+
+        for (int impact = 0; impact < MAX_IMPACTS; impact++) {
+            // Bounds of the whole motion; a turn moves no point further than its arc
+            body->shape->UpdateVertices(sweep.angleEnd, sweep.end);
+            const AABB end = body->shape->GetAABB(sweep.end);
+            const Vec2 back = sweep.start - sweep.end;
+            AABB box = AABB::Union(end, { end.min + back, end.max + back });
+            const float swing = std::fabs(sweep.angleEnd - sweep.angleStart) * extent;
+            box.min -= Vec2(swing, swing);
+            box.max += Vec2(swing, swing);
+
+            TimeOfImpact::Result first {};
+            first.t = 1.f;
+            Body* struck = nullptr;
+            auto consider = [&](Body* owner, const Shape& shape, const Vec2& position) {
+                for (int part = moverParts > 0 ? 0 : -1; part < moverParts; part++) {
+                    const TimeOfImpact::Result result = TimeOfImpact::Compute(body, part, sweep, extent, shape, position, first.t);
+                    if (result.hit && result.t < first.t) {
+                        first = result;
+                        struck = owner;
+                    }
+                }
+            };
+
+            // Fast bodies only meet the slower ones, which stay where they are
+            sweptCandidates.clear();
+            index.Query({ box.min - Vec2(reach, reach), box.max + Vec2(reach, reach) }, [&](Body* other) {
+                sweptCandidates.push_back(contactOrder[other->proxy]);
+                return true;
+            });
+            std::sort(sweptCandidates.begin(), sweptCandidates.end());
+            for (int j : sweptCandidates) {
+                Body* other = bodies[j];
+                if (other->shape->sensor || isSwept(j)) continue;
+                other->shape->UpdateVertices(other->rotation, other->position);
+                if (!other->shape->GetAABB(other->position).Overlaps(box)) continue;
+                if (!body->filter.ShouldCollide(other->filter)) continue;
+                if (!jointedPairs.empty() && jointedPairs.count(std::minmax<const Body*>(body, other))) continue;
+
+                switch (other->shape->GetType()) {
+                    case CHAIN: {
+                        const ChainShape* chain = static_cast<ChainShape*>(other->shape);
+                        sweptSegments.clear();
+                        chain->QuerySegments(box, [&](int segment) { sweptSegments.push_back(segment); });
+                        for (int segment : sweptSegments) {
+                            Vec2 a, b;
+                            chain->GetSegment(segment, a, b);
+                            const Vec2 edge = b - a;
+                            if (edge.MagnitudeSquared() == 0.f) continue;
+                            // One-sided like its contacts: only a body in front, moving in
+                            const Vec2 normal = edge.Normal();
+                            if ((sweep.start - a).Dot(normal) < 0.f || (sweep.end - sweep.start).Dot(normal) >= 0.f) continue;
+
+                            CapsuleShape line(edge.Magnitude(), 0.f);
+                            const Vec2 middle = (a + b) * 0.5f;
+                            line.UpdateVertices(std::atan2(edge.y, edge.x), middle);
+                            consider(other, line, middle);
+                        }
+                        break;
+                    }
+                    case COMPOUND: {
+                        const CompoundShape* compound = static_cast<CompoundShape*>(other->shape);
+                        sweptParts.clear();
+                        compound->QueryParts(box, [&](int part) { sweptParts.push_back(part); });
+                        for (int part : sweptParts) {
+                            const Body* placed = compound->PlacePart(part);
+                            consider(other, *placed->shape, placed->position);
+                        }
+                        break;
+                    }
+                    default:
+                        consider(other, *other->shape, other->position);
+                        break;
+                }
+            }
+
+            if (!struck) {
+                body->position = sweep.end;
+                body->rotation = sweep.angleEnd;
+                body->shape->UpdateVertices(body->rotation, body->position);
+                break;
+            }
+
+            body->position = sweep.PositionAt(first.t);
+            body->rotation = sweep.AngleAt(first.t);
+            body->shape->UpdateVertices(body->rotation, body->position);
+
+            // The bodies are a hair apart, so SolveCollisions would not see
+            // this contact; it is resolved here, if they are still closing
+            ContactInformation contact;
+            contact.a      = body;
+            contact.b      = struck;
+            contact.normal = first.normal;
+            contact.start  = first.pointB;
+            contact.end    = first.pointA;
+            contact.depth  = 0.f;
+
+            const Vec2 ra = contact.end - body->position;
+            const Vec2 rb = contact.start - struck->position;
+            const Vec2 va = body->velocity + Vec2(-body->angularVelocity * ra.y, body->angularVelocity * ra.x);
+            const Vec2 vb = struck->velocity + Vec2(-struck->angularVelocity * rb.y, struck->angularVelocity * rb.x);
+            if ((va - vb).Dot(contact.normal) > 0.f) {
+                body->allowRotation = true;
+                struck->allowRotation = true;
+                const float impulse = CollisionSolver::ResolveCollision(contact);
+                RecordContact(body, struck, (contact.start + contact.end) * 0.5f, contact.normal, impulse);
+            }
+            if (debugDraw.IsEnabled(DEBUG_CONTACTS))
+                debugDraw.AddPoint(contact.end, 3.f, DebugColor::ORANGE);
+
+            // The rest of the step, from the impact, with the new velocity
+            remaining *= 1.f - first.t;
+            sweep = { body->position, body->position + body->velocity * remaining,
+                      body->rotation, body->rotation + turnOf(body, remaining) };
+        }
+    }
+}
+
+template <typename Fn>
+void World::ForEachContact(float margin, Fn fn) {
+    // One part of a against one part of b; parts are the bodies themselves
+    // unless they are compounds (see CollisionDetection::PartBody)
+    auto solveParts = [&](Body* a, int partA, Body* b, int partB) {
+        Body* pa = CollisionDetection::PartBody(a, partA);
+        Body* pb = CollisionDetection::PartBody(b, partB);
+
+        // A chain can touch a body with several segments at once. Each
+        // contact is measured after the previous one moved the body.
+        const bool aIsChain = pa->shape->GetType() == CHAIN;
+        if (aIsChain || pb->shape->GetType() == CHAIN) {
+            Body* other = aIsChain ? pb : pa;
+            if (other->shape->GetType() == CHAIN) return;
+
+            // Segments within the margin too, as for any other pair
+            AABB bounds = other->shape->GetAABB(other->position);
+            bounds.min -= Vec2(margin, margin);
+            bounds.max += Vec2(margin, margin);
+            chainSegments.clear();
+            static_cast<ChainShape*>((aIsChain ? pa : pb)->shape)->QuerySegments(bounds, [&](int segment) { chainSegments.push_back(segment); });
+            for (int segment : chainSegments) {
+                // A compound part follows its body only once placed again
+                pa = CollisionDetection::PartBody(a, partA);
+                pb = CollisionDetection::PartBody(b, partB);
+                ContactInformation contact;
+                if (!CollisionDetection::IsCollidingChainSegment(aIsChain ? pa : pb, aIsChain ? pb : pa, segment, contact)) continue;
+                CollisionDetection::ReportOnOwners(contact, pa, a, pb, b);
+                fn(contact);
+            }
+            return;
+        }
+
+        // Parts whose boxes are apart cannot touch, whichever routine
+        // would measure them
+        AABB boundsA = pa->shape->GetAABB(pa->position);
+        boundsA.min -= Vec2(margin, margin);
+        boundsA.max += Vec2(margin, margin);
+        if (!boundsA.Overlaps(pb->shape->GetAABB(pb->position))) return;
+
+        GJK::SimplexCache* cache = nullptr;
+        if (!CollisionDetection::HasKernel(pa->shape->GetType(), pb->shape->GetType())) {
+            cache = &simplexCache[{ pa, pb }];
+            cache->lastUsed = solveCount;
+        }
+
+        // Resting boxes need both corners of a face held up at once
+        // for the soft step, which has no iterations to rock between them
+        if (margin > 0.f && IsPolygon(pa->shape->GetType()) && IsPolygon(pb->shape->GetType())) {
+            manifold.clear();
+            CollisionDetection::CollidePolygonPolygon(pa, pb, manifold, margin);
+            for (ContactInformation& contact : manifold) {
+                CollisionDetection::ReportOnOwners(contact, pa, a, pb, b);
+                fn(contact);
+            }
+            return;
+        }
+
+        ContactInformation contact;
+        if (CollisionDetection::isColliding(pa, pb, contact, cache)) {
+            CollisionDetection::ReportOnOwners(contact, pa, a, pb, b);
+            fn(contact);
+            return;
+        }
+        if (margin <= 0.f) return;
+
+        // Not touching yet, but close enough to touch within the step
+        const GJK::Result gap = GJK::Distance(*pa->shape, pa->position, *pb->shape, pb->position, cache);
+        if (gap.overlap || gap.distance >= margin) return;
+        contact.a      = pa;
+        contact.b      = pb;
+        contact.normal = gap.normal;
+        contact.start  = gap.pointB;
+        contact.end    = gap.pointA;
+        contact.depth  = -gap.distance;
+        CollisionDetection::ReportOnOwners(contact, pa, a, pb, b);
+        fn(contact);
+    };
+
+    // Every body's box, grown by the margin, so most pairs are turned away
+    // without asking their shapes. A body only moves when one of its own
+    // pairs is solved, and its box is measured again after each one; its
+    // leaf in the index follows whenever it leaves its fat box.
+    const size_t count = bodies.size();
+    contactBoxes.resize(count);
+    contactIsChain.assign(count, 0);
+    contactIsSensor.assign(count, 0);
+    contactFilters.resize(count);
+    contactChains.clear();
+    auto measure = [&](size_t i) {
+        const AABB box = bodies[i]->shape->GetAABB(bodies[i]->position);
+        index.Move(bodies[i]->proxy, box);
+        contactBoxes[i] = box;
+        contactBoxes[i].min -= Vec2(margin, margin);
+        contactBoxes[i].max += Vec2(margin, margin);
+    };
+    int proxies = 0;
+    for (size_t i = 0; i < count; i++) proxies = std::max(proxies, bodies[i]->proxy + 1);
+    contactOrder.resize(proxies);
+    for (size_t i = 0; i < count; i++) {
+        contactOrder[bodies[i]->proxy] = static_cast<int>(i);
+        measure(i);
+        contactIsChain[i] = bodies[i]->shape->GetType() == CHAIN;
+        contactIsSensor[i] = bodies[i]->shape->sensor;
+        contactFilters[i] = bodies[i]->filter;
+        if (contactIsChain[i]) contactChains.push_back(static_cast<int>(i));
+    }
+
+    // The bodies after i that might touch it, in body order: those whose
+    // fat box meets its box grown by both margins, and every chain, which
+    // is culled per segment instead. query is the box they were found for.
+    AABB query;
+    auto gather = [&](size_t i, size_t after) {
+        query = contactBoxes[i];
+        const Vec2 grow(margin + DynamicTree::MARGIN, margin + DynamicTree::MARGIN);
+        query.min -= grow;
+        query.max += grow;
+        contactCandidates.clear();
+        index.Query(query, [&](Body* body) {
+            const int j = contactOrder[body->proxy];
+            if (j > static_cast<int>(after) && !contactIsChain[j]) contactCandidates.push_back(j);
+            return true;
+        });
+        for (int j : contactChains)
+            if (j > static_cast<int>(after)) contactCandidates.push_back(j);
+        std::sort(contactCandidates.begin(), contactCandidates.end());
+    };
+
+    auto solvePair = [&](size_t i, size_t j) {
+        Body* a = bodies[i];
+        Body* b = bodies[j];
+
+        // Chains are culled per segment instead
+        if (!contactIsChain[i] && !contactIsChain[j] && !contactBoxes[i].Overlaps(contactBoxes[j])) return;
+        if (!contactFilters[i].ShouldCollide(contactFilters[j])) return;
+        if (!jointedPairs.empty() && jointedPairs.count(std::minmax<const Body*>(a, b))) return;
+
+        // Compounds only test the parts that overlap, found up front;
+        // each part pair is then measured fresh like any other pair
+        if (a->shape->GetType() == COMPOUND || b->shape->GetType() == COMPOUND) {
+            partPairs.clear();
+            CollisionDetection::FindPartPairs(a, b, partPairs);
+            for (const auto& pair : partPairs) solveParts(a, pair.first, b, pair.second);
+        } else {
+            solveParts(a, -1, b, -1);
+        }
+        measure(i);
+        measure(j);
+    };
+
+    // Pairs in body order, as a scan of every pair would meet them: a pair
+    // the index leaves out has boxes apart, which the scan would skip too.
+    // Sensors never touch anything here; UpdateSensors finds their overlaps.
+    for (size_t i = 0; i + 1 < count; i++) {
+        if (contactIsSensor[i]) continue;
+        if (contactIsChain[i]) {
+            for (size_t j = i + 1; j < count; j++)
+                if (!contactIsSensor[j]) solvePair(i, j);
+            continue;
+        }
+        gather(i, i);
+        for (size_t k = 0; k < contactCandidates.size(); k++) {
+            const size_t j = contactCandidates[k];
+            if (contactIsSensor[j]) continue;
+            solvePair(i, j);
+            // Pushed out of the box its candidates were found for
+            if (!query.Contains(contactBoxes[i])) {
+                gather(i, j);
+                k = static_cast<size_t>(-1);
+            }
+        }
+    }
+}
+
+void World::UpdateAllVertices() {
+    ParallelFor(workers, bodies.size(), threadCount, [&](size_t i) {
+        Body* body = bodies[i];
+        if (body && body->shape) {
+            body->shape->UpdateVertices(body->rotation, body->position);
+        }
+    });
+
+    if (debugDraw.IsEnabled(DEBUG_AABBS)) {
+        for (Body* body : bodies)
+            debugDraw.AddBox(body->shape->GetAABB(body->position), DebugColor::ORANGE);
+    }
+}
+
+void World::ReportContact(const ContactInformation& contact) {
+    if (debugDraw.IsEnabled(DEBUG_CONTACTS)) {
+        debugDraw.AddPoint(contact.start, 3.f, DebugColor::RED);
+        debugDraw.AddPoint(contact.end, 3.f, DebugColor::GREEN);
+    }
+    if (debugDraw.IsEnabled(DEBUG_NORMALS)) {
+        Vec2 direction = contact.end - contact.start;
+        if (direction.Magnitude() > 0.0f) {
+            direction = direction.Normalize();
+            debugDraw.AddSegment(contact.start, contact.start + direction * 15.0f, DebugColor::CYAN);
+        }
+    }
+}
+
+void World::ForgetStaleCaches() {
+    for (auto it = simplexCache.begin(); it != simplexCache.end();) {
+        if (it->second.lastUsed != solveCount) it = simplexCache.erase(it);
+        else ++it;
+    }
+    for (auto it = impulseCache.begin(); it != impulseCache.end();) {
+        if (it->second.lastUsed != solveCount) it = impulseCache.erase(it);
+        else ++it;
+    }
+}
+
+void World::SolveCollisions(float deltaTime) {
+    solveCount++;
+
+    // Update vertices before collision checks
+    UpdateAllVertices();
+
+    // Contacts are only reported from the first pass, before any of them
+    // have been resolved, so debug output does not scale with maxIteration
+    const bool drawContacts = debugDraw.IsEnabled(DEBUG_CONTACTS) || debugDraw.IsEnabled(DEBUG_NORMALS);
+
+    // Joints start from last step's impulses and are solved in the same
+    // passes as the contacts, so either can push back on the other
+    jointSolver.Build(joints);
+    for (Joint* joint : joints) {
+        joint->Prepare(deltaTime);
+        joint->WarmStart();
+    }
+
+    for (int n = 0; n < maxIteration; n++) {
+        const bool report = n == 0 && drawContacts;
+        ForEachContact(0.f, [&](ContactInformation& contact) {
+            contact.a->allowRotation = true;
+            contact.b->allowRotation = true;
+            const float impulse = CollisionSolver::ResolveCollision(contact);
+            RecordContact(contact.a, contact.b, (contact.start + contact.end) * 0.5f, contact.normal, impulse);
+            if (report) ReportContact(contact);
+        });
+        jointSolver.SolveVelocity(Softness::RIGID);
+        for (int k = 0; k < JOINT_SWEEPS && !jointSolver.Loose().empty(); k++)
+            for (Joint* joint : jointSolver.Loose()) joint->SolveVelocity(Softness::RIGID);
+    }
+
+    // Position error is corrected once, from where the passes left the
+    // bodies; correcting it each sweep fed the velocity solve a pose that
+    // moved under it
+    jointSolver.SolvePosition(1.f);
+    for (int k = 0; k < JOINT_SWEEPS && !jointSolver.Loose().empty(); k++)
+        for (Joint* joint : jointSolver.Loose()) joint->SolvePosition(JOINT_CORRECTION);
+
+    // Forget pairs that no longer overlap
+    ForgetStaleCaches();
+}
+
+void World::StepSoft(float deltaTime) {
+    if (deltaTime <= 0.f) return;
+    solveCount++;
+    const int   steps = std::max(1, substeps);
+    const float h = deltaTime / steps;
+    const float scale = Constants::PIXELS_PER_METER;
+
+    // Forces are held for the whole step and applied a substep at a time
+    ParallelFor(workers, bodies.size(), threadCount, [&](size_t i) {
+        Body* body = bodies[i];
+        body->restitution = restitution;
+        body->gravity = gravity;
+        body->friction = friction;
+        if (!body->IsStatic()) {
+            body->AddForce(Vec2(0.f, body->mass * body->gravity * scale));
+            body->acceleration = body->sumForces * body->invMass;
+            body->angularAcceleration = body->sumTorque * body->invI;
+        }
+        body->ClearForces();
+        body->ClearTorque();
+    });
+
+    // Contacts are found once, at the start of the step, including pairs
+    // close enough to touch before it ends
+    UpdateAllVertices();
+    softContacts.clear();
+    const bool drawContacts = debugDraw.IsEnabled(DEBUG_CONTACTS) || debugDraw.IsEnabled(DEBUG_NORMALS);
+    ForEachContact(SPECULATIVE_DISTANCE, [&](ContactInformation& contact) {
+        if (contact.a->IsStatic() && contact.b->IsStatic()) return;
+        if (drawContacts) ReportContact(contact);
+        contact.a->allowRotation = true;
+        contact.b->allowRotation = true;
+
+        SoftContact c;
+        c.a = contact.a;
+        c.b = contact.b;
+        c.anchorA = contact.end - c.a->position;
+        c.anchorB = contact.start - c.b->position;
+        c.angleA = c.a->rotation;
+        c.angleB = c.b->rotation;
+        c.normal = contact.normal;
+        c.point = (contact.start + contact.end) * 0.5f;
+        c.touching = contact.depth >= 0.f;
+
+        const Vec2  tangent(c.normal.y, -c.normal.x);
+        const float rnA = c.anchorA.Cross(c.normal), rnB = c.anchorB.Cross(c.normal);
+        const float rtA = c.anchorA.Cross(tangent),  rtB = c.anchorB.Cross(tangent);
+        const float invMass = c.a->invMass + c.b->invMass;
+        const float kNormal  = invMass + c.a->invI * rnA * rnA + c.b->invI * rnB * rnB;
+        const float kTangent = invMass + c.a->invI * rtA * rtA + c.b->invI * rtB * rtB;
+        c.normalMass  = kNormal > 0.f ? 1.f / kNormal : 0.f;
+        c.tangentMass = kTangent > 0.f ? 1.f / kTangent : 0.f;
+        c.normalImpulse = c.tangentImpulse = 0.f;
+        const auto cached = impulseCache.find({ c.a, c.b });
+        if (cached != impulseCache.end()) {
+            const Vec2 anchor = c.anchorB.Rotate(-c.angleB);
+            float closest = IMPULSE_MATCH_DISTANCE * IMPULSE_MATCH_DISTANCE;
+            for (const CachedImpulse& point : cached->second.points) {
+                const float distance = (point.anchor - anchor).MagnitudeSquared();
+                if (distance >= closest) continue;
+                closest = distance;
+                c.normalImpulse = point.normalImpulse;
+                c.tangentImpulse = point.tangentImpulse;
+            }
+        }
+        c.approachSpeed = (PointVelocity(c.b, c.anchorB) - PointVelocity(c.a, c.anchorA)).Dot(c.normal);
+        c.friction = std::min(c.a->friction, c.b->friction);
+        c.restitution = std::min(c.a->restitution, c.b->restitution);
+        softContacts.push_back(c);
+    });
+
+    const float    contactHertz = std::min(CONTACT_HERTZ, 0.25f / h);
+    const Softness soft = Softness::Make(contactHertz, CONTACT_DAMPING_RATIO, h);
+    const Softness jointSoft = Softness::Make(JOINT_HERTZ_SCALE * contactHertz, JOINT_DAMPING_RATIO, h);
+    jointSolver.Build(joints);
+    for (Joint* joint : joints) joint->Prepare(h);
+
+    auto apply = [](SoftContact& c, const Vec2& impulse) {
+        c.a->ApplyImpulse(impulse * -1.f, c.anchorA);
+        c.b->ApplyImpulse(impulse, c.anchorB);
+    };
+
+    // One pass over the contacts. With bias, overlap is pushed out through
+    // the soft spring; without it (relax), only the velocity error is removed.
+    auto solve = [&](bool useBias) {
+        jointSolver.SolveVelocity(useBias ? jointSoft : Softness::RIGID);
+        for (Joint* joint : jointSolver.Loose()) joint->SolveVelocity(useBias ? jointSoft : Softness::RIGID);
+
+        for (SoftContact& c : softContacts) {
+            // Current gap between the anchors along the normal
+            const Vec2  pointA = c.a->position + c.anchorA.Rotate(c.a->rotation - c.angleA);
+            const Vec2  pointB = c.b->position + c.anchorB.Rotate(c.b->rotation - c.angleB);
+            const float separation = (pointB - pointA).Dot(c.normal);
+
+            float bias = 0.f, massScale = 1.f, impulseScale = 0.f;
+            if (separation > 0.f) {
+                bias = separation / h; // speculative: may close the gap, not more
+            } else if (useBias) {
+                bias = std::max(soft.biasRate * std::min(0.f, separation + LINEAR_SLOP), -MAX_PUSHOUT_SPEED);
+                massScale = soft.massScale;
+                impulseScale = soft.impulseScale;
+            }
+
+            const Vec2  relative = PointVelocity(c.b, c.anchorB) - PointVelocity(c.a, c.anchorA);
+            const float vn = relative.Dot(c.normal);
+            float impulse = -c.normalMass * massScale * (vn + bias) - impulseScale * c.normalImpulse;
+            const float total = std::max(c.normalImpulse + impulse, 0.f);
+            impulse = total - c.normalImpulse;
+            c.normalImpulse = total;
+            apply(c, c.normal * impulse);
+
+            // Friction, bounded by the normal impulse just found
+            const Vec2  tangent(c.normal.y, -c.normal.x);
+            const float vt = (PointVelocity(c.b, c.anchorB) - PointVelocity(c.a, c.anchorA)).Dot(tangent);
+            const float limit = c.friction * c.normalImpulse;
+            float friction = -c.tangentMass * vt;
+            const float tangentTotal = std::clamp(c.tangentImpulse + friction, -limit, limit);
+            friction = tangentTotal - c.tangentImpulse;
+            c.tangentImpulse = tangentTotal;
+            apply(c, tangent * friction);
+        }
+    };
+
+    for (int step = 0; step < steps; step++) {
+        ParallelFor(workers, bodies.size(), threadCount, [&](size_t i) {
+            Body* body = bodies[i];
+            if (body->IsStatic()) return;
+            body->velocity += body->acceleration * h;
+            if (body->allowRotation) body->angularVelocity += body->angularAcceleration * h;
+        });
+
+        // Impulses carry over between substeps; start from the last ones
+        for (Joint* joint : joints) joint->WarmStart();
+        for (SoftContact& c : softContacts) {
+            const Vec2 tangent(c.normal.y, -c.normal.x);
+            apply(c, c.normal * c.normalImpulse + tangent * c.tangentImpulse);
+        }
+
+        solve(true);
+
+        ParallelFor(workers, bodies.size(), threadCount, [&](size_t i) {
+            Body* body = bodies[i];
+            if (body->IsStatic()) return;
+            body->position += body->velocity * h;
+            if (body->allowRotation) body->rotation += body->angularVelocity * h;
+        });
+
+        solve(false);
+    }
+    // The soft joints give a little each substep, and on a long chain at
+    // few substeps that adds up link by link; the trees are closed again
+    // once the substeps are done
+    jointSolver.SolvePosition(1.f);
+
+    // Bounce once, at the end, from the speed the contact was approached at
+    for (SoftContact& c : softContacts) {
+        if (c.restitution == 0.f || c.approachSpeed > -RESTITUTION_THRESHOLD || c.normalImpulse == 0.f) continue;
+        const float vn = (PointVelocity(c.b, c.anchorB) - PointVelocity(c.a, c.anchorA)).Dot(c.normal);
+        float impulse = -c.normalMass * (vn + c.restitution * c.approachSpeed);
+        const float total = std::max(c.normalImpulse + impulse, 0.f);
+        impulse = total - c.normalImpulse;
+        c.normalImpulse = total;
+        apply(c, c.normal * impulse);
+    }
+
+    // Keep the impulses for the next step. A pair that was only close
+    // touched if the solver had to hold it apart.
+    for (const SoftContact& c : softContacts) {
+        ImpulseCache& cache = impulseCache[{ c.a, c.b }];
+        if (cache.lastUsed != solveCount) {
+            cache.points.clear();
+            cache.lastUsed = solveCount;
+        }
+        cache.points.push_back({ c.anchorB.Rotate(-c.angleB), c.normalImpulse, c.tangentImpulse });
+        if (c.touching || c.normalImpulse > 0.f) RecordContact(c.a, c.b, c.point, c.normal, c.normalImpulse);
+    }
+    ForgetStaleCaches();
+
+    // Positions moved in substeps; sweeping uses this step's final velocity
+    SolveContinuous(deltaTime);
+    UpdateAllVertices();
+}
+
+void World::Step(float deltaTime) {
+    BeginContactEvents();
+    if (solver == SolverType::SOFT_STEP) {
+        StepSoft(deltaTime);
+    } else {
+        Integrate(deltaTime);
+        SolveContinuous(deltaTime);
+        SolveCollisions(deltaTime);
+    }
+    EndContactEvents();
+    UpdateIndex();
+    UpdateSensors();
+}
+
+void World::UpdateSensors() {
+    sensorEvents.enter.clear();
+    sensorEvents.exit.clear();
+
+    for (Body* sensor : bodies) {
+        if (!sensor->shape->sensor) continue;
+        const AABB box = sensor->shape->GetAABB(sensor->position);
+        index.Query(box, [&](Body* visitor) {
+            if (visitor == sensor || visitor->shape->sensor || visitor->IsStatic()) return true;
+            if (!sensor->filter.ShouldCollide(visitor->filter)) return true;
+            if (!visitor->shape->GetAABB(visitor->position).Overlaps(box) || !SensorOverlaps(sensor, visitor)) return true;
+            SensorOverlap& overlap = sensorOverlaps[{ sensor, visitor }];
+            if (overlap.lastStep == 0) sensorEvents.enter.push_back({ sensor, visitor });
+            overlap = { sensor, visitor, eventStep };
+            return true;
+        });
+    }
+
+    for (auto it = sensorOverlaps.begin(); it != sensorOverlaps.end();) {
+        if (it->second.lastStep == eventStep) {
+            ++it;
+            continue;
+        }
+        sensorEvents.exit.push_back({ it->second.sensor, it->second.visitor });
+        it = sensorOverlaps.erase(it);
+    }
+}
+
+bool World::SensorOverlaps(Body* sensor, Body* visitor) {
+    const AABB visitorBox = visitor->shape->GetAABB(visitor->position);
+    switch (sensor->shape->GetType()) {
+        case CHAIN:
+            return false; // a line encloses nothing
+        case COMPOUND: {
+            const CompoundShape* compound = static_cast<CompoundShape*>(sensor->shape);
+            bool hit = false;
+            compound->QueryParts(visitorBox, [&](int part) {
+                if (hit) return;
+                const Body* placed = compound->PlacePart(part);
+                hit = Overlaps(visitor, *placed->shape, placed->position, placed->shape->GetAABB(placed->position));
+            });
+            return hit;
+        }
+        default:
+            return Overlaps(visitor, *sensor->shape, sensor->position, sensor->shape->GetAABB(sensor->position));
+    }
+}
+
+void World::BeginContactEvents() {
+    eventStep++;
+    contactEvents.begin.clear();
+    contactEvents.persist.clear();
+    contactEvents.end.clear();
+}
+
+void World::EndContactEvents() {
+    for (auto it = touching.begin(); it != touching.end();) {
+        if (it->second.lastStep == eventStep) {
+            ++it;
+            continue;
+        }
+        contactEvents.end.push_back({ it->second.a, it->second.b });
+        it = touching.erase(it);
+    }
+}
+
+void World::RecordContact(Body* a, Body* b, const Vec2& point, const Vec2& normal, float impulse) {
+    // Keyed by address order: a pair's routine may swap which body is a
+    TouchState& state = touching[std::minmax<const Body*>(a, b)];
+    if (state.lastStep == eventStep) {
+        ContactEvent& event = state.event >= 0 ? contactEvents.begin[state.event] : contactEvents.persist[~state.event];
+        event.impulse += impulse;
+        return;
+    }
+
+    // Pairs not touched last step were ended and forgotten, so any other
+    // pair found here touched then too
+    std::vector<ContactEvent>& events = state.lastStep == 0 ? contactEvents.begin : contactEvents.persist;
+    const int index = static_cast<int>(events.size());
+    events.push_back({ a, b, point, normal, impulse });
+    state.a = a;
+    state.b = b;
+    state.event = state.lastStep == 0 ? index : ~index;
+    state.lastStep = eventStep;
+}
+
+void World::UpdateIndex() {
+    // Measured per body in parallel; the tree itself is only touched serially
+    indexBoxes.resize(bodies.size());
+    ParallelFor(workers, bodies.size(), threadCount, [&](size_t i) {
+        Body* body = bodies[i];
+        body->shape->UpdateVertices(body->rotation, body->position);
+        indexBoxes[i] = body->shape->GetAABB(body->position);
+    });
+    for (size_t i = 0; i < bodies.size(); i++) index.Move(bodies[i]->proxy, indexBoxes[i]);
+
+    if (debugDraw.IsEnabled(DEBUG_BROADPHASE)) {
+        for (const Body* body : bodies)
+            debugDraw.AddBox(index.FatBox(body->proxy), DebugColor::YELLOW);
+    }
+}
+
+bool World::Overlaps(Body* body, const Shape& shape, const Vec2& position, const AABB& box) {
+    auto touches = [&](const Shape& other, const Vec2& otherPosition) {
+        const GJK::Result gap = GJK::Distance(other, otherPosition, shape, position, nullptr);
+        return gap.overlap || gap.distance <= 0.f;
+    };
+
+    bool hit = false;
+    switch (body->shape->GetType()) {
+        case CHAIN: {
+            const ChainShape* chain = static_cast<ChainShape*>(body->shape);
+            chain->QuerySegments(box, [&](int segment) {
+                if (hit) return;
+                Vec2 a, b;
+                chain->GetSegment(segment, a, b);
+                const Vec2 edge = b - a;
+                CapsuleShape line(edge.Magnitude(), 0.f);
+                const Vec2 middle = (a + b) * 0.5f;
+                line.UpdateVertices(std::atan2(edge.y, edge.x), middle);
+                hit = touches(line, middle);
+            });
+            return hit;
+        }
+        case COMPOUND: {
+            const CompoundShape* compound = static_cast<CompoundShape*>(body->shape);
+            compound->QueryParts(box, [&](int part) {
+                if (hit) return;
+                const Body* placed = compound->PlacePart(part);
+                hit = touches(*placed->shape, placed->position);
+            });
+            return hit;
+        }
+        default:
+            return touches(*body->shape, body->position);
+    }
+}
+
+int World::QueryPoint(const Vec2& point, Body** out, int capacity) const {
+    int count = 0;
+    if (capacity > 0) QueryPoint(point, [&](Body* body) { out[count++] = body; return count < capacity; });
+    return count;
+}
+
+int World::QueryAABB(const AABB& box, Body** out, int capacity) const {
+    int count = 0;
+    if (capacity > 0) QueryAABB(box, [&](Body* body) { out[count++] = body; return count < capacity; });
+    return count;
+}
+
+int World::QueryOverlap(const Shape& shape, const Vec2& position, Body** out, int capacity) const {
+    int count = 0;
+    if (capacity > 0) QueryOverlap(shape, position, [&](Body* body) { out[count++] = body; return count < capacity; });
+    return count;
+}
+
+int World::RayCast(const Vec2& origin, const Vec2& translation, RayMode mode, RayResult* out, int capacity) const {
+    if (capacity <= 0) return 0;
+    int count = 0;
+    index.RayCast(origin, translation, 1.f, [&](Body* body, float maxFraction) {
+        CollisionDetection::RayHit hit;
+        if (!CollisionDetection::RayCast(body, origin, translation, maxFraction, hit)) return maxFraction;
+        const RayResult result { body, hit.fraction, hit.point, hit.normal };
+        if (mode != RayMode::ALL) {
+            out[0] = result;
+            count = 1;
+            return mode == RayMode::ANY ? 0.f : hit.fraction;
+        }
+
+        // Sorted insert; once full, the farthest hit makes way and bounds the rest
+        int slot = count < capacity ? count++ : capacity - 1;
+        for (; slot > 0 && out[slot - 1].fraction > result.fraction; slot--) out[slot] = out[slot - 1];
+        out[slot] = result;
+        return count == capacity ? out[capacity - 1].fraction : maxFraction;
+    });
+    return count;
+}
+
+void World::RayCastBatch(const Ray* rays, int count, RayMode mode, RayResult* results) const {
+    const RayMode single = mode == RayMode::ALL ? RayMode::CLOSEST : mode;
+    ParallelFor(workers, static_cast<size_t>(count), threadCount, [&](size_t i) {
+        results[i] = RayResult {};
+        RayCast(rays[i].origin, rays[i].translation, single, &results[i], 1);
+    }, MIN_RAYS_PER_THREAD);
+}
+
+uint64_t World::StateHash() const {
+    // FNV-1a over 32-bit words: the raw bits of each body's motion state
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint32_t word) { hash = (hash ^ word) * 1099511628211ull; };
+
+    for (const Body* body : bodies) {
+        mix(FloatBits(body->position.x));
+        mix(FloatBits(body->position.y));
+        mix(FloatBits(body->velocity.x));
+        mix(FloatBits(body->velocity.y));
+        mix(FloatBits(body->rotation));
+        mix(FloatBits(body->angularVelocity));
+    }
+    return hash;
+}
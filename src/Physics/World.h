@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Body.h"
+#include "ContactInformation.h"
+#include "DebugDraw.h"
+#include "DynamicTree.h"
+#include "GJK.h"
+#include "Joint.h"
+#include "JointSolver.h"
+#include "WorkerPool.h"
+
+// Owns the simulated bodies and the global simulation settings, and runs the
+// physics step without depending on the renderer or the window.
+//
+// bodies keeps insertion order: removal never reorders the survivors, so
+// pair order (and therefore the result of a step) does not depend on which
+// bodies were deleted or culled before.
+struct World {
+    // Step used by the deterministic (fixed dt) mode
+    static constexpr float FIXED_TIME_STEP = 1.f / 60.f;
+
+    // ITERATIVE re-detects and resolves every pair maxIteration times.
+    // SOFT_STEP finds contacts once, then runs substeps that each integrate
+    // and relax them once through soft springs; stiffer stacks for less work.
+    enum class SolverType : uint8_t { ITERATIVE, SOFT_STEP };
+
+    std::vector<Body*> bodies;
+    // Owned; a joint goes with either of its bodies
+    std::vector<Joint*> joints;
+
+    // Global settings, pushed onto every body each step
+    float gravity     = 9.81f;
+    float restitution = 0.65f;
+    float friction    = 0.5f;
+    int   maxIteration = 3;
+    SolverType solver = SolverType::ITERATIVE;
+    int   substeps = 4; // SOFT_STEP only
+
+    // Sweep bullets, and bodies moving more than part of their own size in
+    // a step, to their first impact instead of letting them tunnel
+    bool  continuousCollision = true;
+
+    // Worker threads for the per-body parts of the step. Contacts are always
+    // solved serially in body order, so results are identical for any count.
+    int   threadCount = 1;
+
+    DebugDraw debugDraw;
+
+    // GJK warm-start state for pairs without a specialized routine, kept
+    // while their bounding boxes overlap. Keyed by body (a compound's part
+    // bodies for its parts); a removed body's pairs go with it, so a new
+    // body at a reused address starts cold.
+    using BodyPair = std::pair<const Body*, const Body*>;
+    struct BodyPairHash {
+        size_t operator()(const BodyPair& pair) const {
+            size_t h = std::hash<const Body*>()(pair.first);
+            return h ^ (std::hash<const Body*>()(pair.second) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+        }
+    };
+    std::unordered_map<BodyPair, GJK::SimplexCache, BodyPairHash> simplexCache;
+
+    // SOFT_STEP impulses each touching pair ended the last step with, so the
+    // next one starts from them. Points are anchors in b's own frame.
+    struct CachedImpulse {
+        Vec2  anchor;
+        float normalImpulse, tangentImpulse;
+    };
+    struct ImpulseCache {
+        std::vector<CachedImpulse> points;
+        uint32_t lastUsed = 0;
+    };
+    std::unordered_map<BodyPair, ImpulseCache, BodyPairHash> impulseCache;
+
+    // Fat boxes of every body, for the queries; Step keeps it current
+    DynamicTree index;
+
+    // What touched what during the last Step, in flat arrays that Step
+    // refills, keeping their capacity, for reading once it returns. A pair
+    // begins the step it first touches, persists while it keeps touching,
+    // and ends the step after it stops; ends come in no particular order.
+    // Removing a body drops its pairs without an end event. Events are
+    // valid until the next Step, or until one of their bodies is removed.
+    struct ContactEvent {
+        Body* a;
+        Body* b;
+        Vec2  point;   // midway between the bodies where they met first this step
+        Vec2  normal;  // unit, from a to b
+        float impulse; // summed normal impulse between them over the step
+    };
+    struct ContactEndEvent {
+        Body* a;
+        Body* b;
+    };
+    struct ContactEvents {
+        std::vector<ContactEvent>    begin;
+        std::vector<ContactEvent>    persist;
+        std::vector<ContactEndEvent> end;
+    };
+    ContactEvents contactEvents;
+
+    // Bodies whose shape is a sensor are never solved, swept or pushed.
+    // After each Step, enter lists the bodies that began to overlap one
+    // and exit those that stopped, in no particular order. Other sensors,
+    // static bodies and bodies the sensor's filter turns away are never
+    // reported. Valid as contactEvents are.
+    struct SensorEvent {
+        Body* sensor;
+        Body* visitor;
+    };
+    struct SensorEvents {
+        std::vector<SensorEvent> enter;
+        std::vector<SensorEvent> exit;
+    };
+    SensorEvents sensorEvents;
+
+    // Joints per body pair (lower address first) whose bodies never collide
+    std::unordered_map<BodyPair, int, BodyPairHash> jointedPairs;
+    uint32_t solveCount = 0;
+
+    World() = default;
+    ~World();
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    void AddBody(Body* body);
+    void Clear();
+    // Forget the warm-start state: the contact impulses and GJK simplices
+    // each pair carried over from the last step. Snapshots leave it out, so
+    // whoever captures one clears it too, and this world steps on exactly as
+    // one restored from the snapshot would.
+    void ClearCaches();
+
+    // Delete and remove one body, and its joints; false if it is not in the world
+    bool RemoveBody(Body* body);
+    // Catch the index up with a body moved, turned or resized outside Step
+    void Refresh(Body* body);
+
+    // Delete and remove every body for which shouldRemove(body) is true,
+    // and their joints, keeping the survivors in order
+    template <typename Predicate>
+    void RemoveBodies(Predicate shouldRemove) {
+        // remove_if is stable for the elements it keeps
+        std::vector<Body*> removed;
+        auto it = std::remove_if(bodies.begin(), bodies.end(), [&](Body* body) {
+            if (!shouldRemove(body)) return false;
+            index.Remove(body->proxy);
+            removed.push_back(body);
+            return true;
+        });
+        bodies.erase(it, bodies.end());
+        if (removed.empty()) return;
+
+        std::vector<const Body*> forgotten(removed.begin(), removed.end());
+        for (const Body* body : removed) AppendParts(body, forgotten);
+        std::sort(forgotten.begin(), forgotten.end());
+        auto isRemoved = [&](const Body* body) { return std::binary_search(forgotten.begin(), forgotten.end(), body); };
+        if (!joints.empty()) RemoveJoints([&](const Joint* joint) { return isRemoved(joint->a) || isRemoved(joint->b); });
+        ForgetTouching(isRemoved);
+        for (Body* body : removed) delete body;
+    }
+
+    // Takes ownership; both bodies must already be in the world (a may be null)
+    void AddJoint(Joint* joint);
+    // Delete and remove one joint; false if it is not in the world
+    bool RemoveJoint(Joint* joint);
+
+    // Apply gravity and integrate every body over deltaTime
+    void Integrate(float deltaTime);
+    // Move each fast body back along this step's motion to where it first
+    // touches a slower body, resolve that impact and carry on with the rest
+    // of the step. Call between Integrate and SolveCollisions.
+    void SolveContinuous(float deltaTime);
+    // Detect and resolve collisions, maxIteration passes over all pairs,
+    // with the joints, for a step of deltaTime. Pairs whose filters
+    // (Body::filter) keep them apart are dropped before any shape test.
+    void SolveCollisions(float deltaTime);
+
+    // Whole step with the soft step solver; Step calls it in that mode
+    void StepSoft(float deltaTime);
+
+    void Step(float deltaTime);
+
+    // 64-bit hash of every body's motion state, bit-exact, in body order
+    uint64_t StateHash() const;
+
+    // Queries, answered from the index without allocating. Each either calls
+    // fn(body) per hit, in no particular order, until fn returns false, or
+    // writes up to capacity hits to out and returns how many it wrote.
+    // Bodies are tested against their exact shapes, as of the last Step,
+    // whatever their collision filters.
+
+    // Bodies whose shape contains point
+    template <typename Fn>
+    void QueryPoint(const Vec2& point, Fn fn) const {
+        const CircleShape probe(0.f);
+        QueryOverlap(probe, point, fn);
+    }
+    int QueryPoint(const Vec2& point, Body** out, int capacity) const;
+
+    // Bodies whose bounding box overlaps box
+    template <typename Fn>
+    void QueryAABB(const AABB& box, Fn fn) const {
+        index.Query(box, [&](Body* body) {
+            if (!body->shape->GetAABB(body->position).Overlaps(box)) return true;
+            return fn(body);
+        });
+    }
+    int QueryAABB(const AABB& box, Body** out, int capacity) const;
+
+    // Bodies whose shape overlaps shape at position; shape's vertices must
+    // already be at position, through UpdateVertices
+    template <typename Fn>
+    void QueryOverlap(const Shape& shape, const Vec2& position, Fn fn) const {
+        const AABB box = shape.GetAABB(position);
+        QueryAABB(box, [&](Body* body) {
+            if (!Overlaps(body, shape, position, box)) return true;
+            return fn(body);
+        });
+    }
+    int QueryOverlap(const Shape& shape, const Vec2& position, Body** out, int capacity) const;
+
+    // Rays, from origin to origin + translation, against the bodies' exact
+    // shapes through the index. CLOSEST keeps the nearest hit, ANY the first
+    // one found, which is all line of sight needs, and ALL the nearest hits
+    // that fit, nearest first.
+    enum class RayMode : uint8_t { CLOSEST, ANY, ALL };
+    struct Ray {
+        Vec2 origin;
+        Vec2 translation;
+    };
+    struct RayResult {
+        Body* body = nullptr; // null when the ray hit nothing
+        float fraction = 1.f; // of translation, where it hit
+        Vec2  point;
+        Vec2  normal;         // the body's outward surface normal
+    };
+    // Writes up to capacity hits (one unless ALL) to out; returns how many
+    int RayCast(const Vec2& origin, const Vec2& translation, RayMode mode, RayResult* out, int capacity) const;
+    // results[i] is ray i's hit, cast over threadCount threads; ALL is
+    // taken as CLOSEST, since each ray gets one result
+    void RayCastBatch(const Ray* rays, int count, RayMode mode, RayResult* results) const;
+
+private:
+    // Calls fn(contact) for each touching pair of parts, measured when the
+    // traversal reaches it, so fn may move the bodies. With margin > 0,
+    // convex parts closer than that also get a contact with depth -gap.
+    template <typename Fn>
+    void ForEachContact(float margin, Fn fn);
+
+    template <typename Predicate>
+    void RemoveJoints(Predicate shouldRemove) {
+        auto it = std::remove_if(joints.begin(), joints.end(), [&](Joint* joint) {
+            if (!shouldRemove(joint)) return false;
+            UnlinkJoint(joint);
+            delete joint;
+            return true;
+        });
+        joints.erase(it, joints.end());
+    }
+    // Forget the joint in jointedPairs
+    void UnlinkJoint(const Joint* joint);
+
+    // Pairs touching as of the step in lastStep, with the event that step
+    // gave them: an index into contactEvents.begin, or ~index into persist
+    struct TouchState {
+        Body*    a;
+        Body*    b;
+        uint32_t lastStep = 0;
+        int      event;
+    };
+    std::unordered_map<BodyPair, TouchState, BodyPairHash> touching;
+    uint32_t eventStep = 1;
+
+    // Bodies inside each sensor as of the step in lastStep
+    struct SensorOverlap {
+        Body*    sensor;
+        Body*    visitor;
+        uint32_t lastStep = 0;
+    };
+    std::unordered_map<BodyPair, SensorOverlap, BodyPairHash> sensorOverlaps;
+
+    // Find what overlaps each sensor through the index, after a step
+    void UpdateSensors();
+    static bool SensorOverlaps(Body* sensor, Body* visitor);
+
+    // Start this step's events, and end the pairs it did not touch
+    void BeginContactEvents();
+    void EndContactEvents();
+    // a and b touched this step; the first call for the pair sets the event,
+    // every call adds to its impulse
+    void RecordContact(Body* a, Body* b, const Vec2& point, const Vec2& normal, float impulse);
+    // Drop the touching pairs, sensor overlaps and caches of every pair
+    // with a body isRemoved accepts
+    template <typename Predicate>
+    void ForgetTouching(Predicate isRemoved) {
+        for (auto it = touching.begin(); it != touching.end();) {
+            if (isRemoved(it->second.a) || isRemoved(it->second.b)) it = touching.erase(it);
+            else ++it;
+        }
+        for (auto it = sensorOverlaps.begin(); it != sensorOverlaps.end();) {
+            if (isRemoved(it->second.sensor) || isRemoved(it->second.visitor)) it = sensorOverlaps.erase(it);
+            else ++it;
+        }
+        for (auto it = simplexCache.begin(); it != simplexCache.end();) {
+            if (isRemoved(it->first.first) || isRemoved(it->first.second)) it = simplexCache.erase(it);
+            else ++it;
+        }
+        for (auto it = impulseCache.begin(); it != impulseCache.end();) {
+            if (isRemoved(it->first.first) || isRemoved(it->first.second)) it = impulseCache.erase(it);
+            else ++it;
+        }
+    }
+    // Adds a compound body's part bodies to out, which the GJK cache knows
+    // its pairs by; nothing for any other body
+    static void AppendParts(const Body* body, std::vector<const Body*>& out);
+    void UpdateAllVertices();
+    // Refit every body's leaf in the index after a step
+    void UpdateIndex();
+    // Exact test of body against shape at position, whose box is box
+    static bool Overlaps(Body* body, const Shape& shape, const Vec2& position, const AABB& box);
+    void ReportContact(const ContactInformation& contact);
+    // Drop GJK and impulse caches of pairs not seen in the current solve
+    void ForgetStaleCaches();
+
+    std::vector<AABB> indexBoxes; // UpdateIndex scratch
+
+    // Threads for the parallel loops, up to threadCount - 1 of them, kept
+    // between steps; RayCastBatch, though const, runs on them too
+    mutable WorkerPool workers;
+
+    // Joint trees solved exactly, rebuilt from joints every step
+    JointSolver jointSolver;
+
+    // A contact held for the whole step. Anchors are fixed at detection;
+    // separation follows the bodies as they move.
+    struct SoftContact {
+        Body* a;
+        Body* b;
+        Vec2  anchorA, anchorB; // from each body's position to its contact point
+        float angleA, angleB;   // body rotations the anchors were measured at
+        Vec2  normal;           // from a to b
+        Vec2  point;            // midway between the bodies, for events
+        bool  touching;         // overlapping when found, not just close
+        float normalMass, tangentMass;
+        float normalImpulse, tangentImpulse;
+        float approachSpeed;    // normal relative velocity before solving
+        float friction, restitution;
+    };
+    std::vector<SoftContact> softContacts; // StepSoft scratch, kept for its capacity
+
+    // SolveContinuous scratch, kept for its capacity
+    std::vector<size_t>      sweptBodies;     // indices into bodies, ascending
+    std::vector<float>       sweptExtents;
+    std::vector<int>         sweptCandidates; // indices into bodies
+    std::vector<int>         sweptSegments;
+    std::vector<int>         sweptParts;
+
+    // ForEachContact scratch, kept for its capacity
+    std::vector<AABB>                contactBoxes;
+    std::vector<char>                contactIsChain;
+    std::vector<char>                contactIsSensor;
+    std::vector<CollisionFilter>     contactFilters;
+    std::vector<int>                 contactOrder;      // body order by index proxy, SolveContinuous's too
+    std::vector<int>                 contactChains;
+    std::vector<int>                 contactCandidates;
+    std::vector<int>                 chainSegments;
+    std::vector<std::pair<int, int>> partPairs;
+    std::vector<ContactInformation>  manifold;
+};